@@ -0,0 +1,155 @@
+#****************************************************************
+#
+# beamsweep.py - the accuracy and speed of a parser by beam.
+#
+# Runs a dependency or constituent parser over the same input
+# with each beam width and score margin, and reports the UAS or
+# the labeled bracket F1 against the gold file together with the
+# sentences parsed per second, so that a beam can be chosen for
+# the time that can be spent on a sentence.
+#
+# The time of loading the model, measured by parsing an empty
+# file, is taken out of the speed. The F1 is on all labeled
+# brackets above the part of speech, without the evalb rules,
+# so it is for comparing beams rather than for reporting.
+#
+#****************************************************************
+
+import os
+import sys
+import time
+import getopt
+import tempfile
+import subprocess
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'dep'))
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'cfg'))
+
+import depio
+import eval as depeval
+import parsecfg
+
+#================================================================
+
+def run(parser, model, input, output, width, margin, options):
+   """run the parser and return the wall clock seconds taken"""
+   args = [parser, input, output, model] + options
+   if width:
+      args.append(g_dWidthOption[g_sKind] + str(width))
+   if float(margin):
+      args.append('-m' + str(margin))
+   start = time.time()
+   devnull = open(os.devnull, 'w')
+   ret = subprocess.call(args, stdout=devnull, stderr=devnull)
+   devnull.close()
+   if ret != 0:
+      raise Exception("%s failed with width %s and margin %s" % (parser, width, margin))
+   return time.time() - start
+
+def uas(output, gold):
+   """the unlabeled attachment score without punctuation"""
+   correct = 0
+   total = 0
+   ref = depio.depread(gold)
+   for sent in depio.depread(output):
+      ret = depeval.eval(sent, ref.next())
+      correct += ret[0]
+      total += ret[2]
+   return float(correct) / total
+
+def brackets(node, start, retval):
+   """collect the labeled brackets of node from start and return its end"""
+   if node.type == 'token':
+      return start + 1
+   end = start
+   for child in node.children:
+      end = brackets(child, end, retval)
+   retval.append((node.name, start, end))
+   return end
+
+def fscore(output, gold):
+   """the labeled bracket F1"""
+   correct = 0
+   proposed = 0
+   total = 0
+   ref = open(gold)
+   for line in open(output):
+      ref_line = ref.readline()
+      out_brackets = []
+      ref_brackets = []
+      if line.strip():
+         brackets(parsecfg.fromString(line), 0, out_brackets)
+      brackets(parsecfg.fromString(ref_line), 0, ref_brackets)
+      total += len(ref_brackets)
+      proposed += len(out_brackets)
+      for bracket in out_brackets:
+         if bracket in ref_brackets:
+            ref_brackets.remove(bracket)
+            correct += 1
+   ref.close()
+   if correct == 0:
+      return 0.0
+   precision = float(correct) / proposed
+   recall = float(correct) / total
+   return 2 * precision * recall / (precision + recall)
+
+def count(gold):
+   """the number of sentences in the gold file"""
+   if g_sKind == 'dep':
+      return len(list(depio.depread(gold)))
+   total = 0
+   for line in open(gold):
+      if line.strip():
+         total += 1
+   return total
+
+#================================================================
+
+g_dWidthOption = {'dep' : '-b', 'con' : '-w'}
+
+def usage():
+   print "Usage: beamsweep.py [-w widths] [-m margins] [-o options] dep|con parser model input gold"
+   print "   -w the beam widths, separated by commas (default 0, the compiled agenda size)"
+   print "   -m the score margins, separated by commas (default 0, no margin)"
+   print "   -o other options for the parser, such as \"-c\""
+   sys.exit(1)
+
+if __name__ == '__main__':
+   try:
+      opts, args = getopt.getopt(sys.argv[1:], "w:m:o:")
+   except getopt.GetoptError:
+      usage()
+   if len(args) != 5 or args[0] not in g_dWidthOption:
+      usage()
+   g_sKind, parser, model, input, gold = args
+   widths = [0]
+   margins = [0]
+   options = []
+   for opt, value in opts:
+      if opt == '-w':
+         widths = [int(x) for x in value.split(',')]
+      elif opt == '-m':
+         margins = [x for x in value.split(',')]
+      elif opt == '-o':
+         options = value.split()
+
+   sentences = count(gold)
+   output = tempfile.mktemp()
+   empty = tempfile.mktemp()
+   open(empty, 'w').close()
+   try:
+      load = run(parser, model, empty, output, 0, 0, options)
+      print "%s\t%s\t%s\t%s" % ("width", "margin", g_sKind == 'dep' and "UAS" or "F1", "sent/s")
+      for width in widths:
+         for margin in margins:
+            seconds = run(parser, model, input, output, width, margin, options) - load
+            if g_sKind == 'dep':
+               accuracy = uas(output, gold)
+            else:
+               accuracy = fscore(output, gold)
+            print "%s\t%s\t%.4f\t%.1f" % (width or "-", float(margin) and margin or "-", accuracy, sentences / max(seconds, 1e-6))
+            sys.stdout.flush()
+   finally:
+      for path in [output, empty, output + '.scores']:
+         if os.path.exists(path):
+            os.remove(path)
@@ -0,0 +1,127 @@
+#****************************************************************
+#
+# lengthbench.py - the memory and speed of a parser by length.
+#
+# Makes sentences of each length from the tokens of a tagged
+# input file, runs the dependency parser over them, and reports
+# the peak memory of decoding and the sentences and tokens
+# parsed per second. Every output is checked to be a tree over
+# all the tokens of its sentence, so that sentences longer than
+# the parser can handle show up as failures rather than as
+# empty parses.
+#
+# The time and the memory of loading the model, measured by
+# parsing an empty file, are taken out of the speed and the peak
+# memory, which leaves the memory of decoding.
+#
+#****************************************************************
+
+import os
+import sys
+import time
+import getopt
+import tempfile
+import subprocess
+
+sys.path.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'dep'))
+
+import depio
+
+#================================================================
+
+def tokens(input):
+   """the tagged tokens of the input file"""
+   retval = []
+   for line in open(input):
+      retval.extend(line.split())
+   return retval
+
+def make(words, length, count, path):
+   """write count sentences of length tokens, taken in turn from words"""
+   file = open(path, 'w')
+   index = 0
+   for i in range(count):
+      sent = []
+      for j in range(length):
+         sent.append(words[index % len(words)])
+         index += 1
+      file.write(' '.join(sent) + '\n')
+   file.close()
+
+def run(parser, model, input, output, options):
+   """run the parser and return the seconds taken and the peak memory in MB"""
+   args = [parser, input, output, model] + options
+   devnull = open(os.devnull, 'w')
+   start = time.time()
+   process = subprocess.Popen(args, stdout=devnull, stderr=devnull)
+   pid, status, usage = os.wait4(process.pid, 0)
+   seconds = time.time() - start
+   devnull.close()
+   if status != 0:
+      raise Exception("%s failed on %s" % (parser, input))
+   return seconds, usage.ru_maxrss / 1024.0
+
+def check(output, length, count):
+   """the number of outputs that are trees over all the tokens"""
+   correct = 0
+   total = 0
+   for sent in depio.depread(output):
+      total += 1
+      if len(sent) != length:
+         continue
+      heads = [int(line[2]) for line in sent]
+      if len([head for head in heads if head == -1]) != 1:
+         continue
+      if [head for head in heads if head < -1 or head >= length]:
+         continue
+      correct += 1
+   if total != count:
+      raise Exception("%d outputs for %d sentences" % (total, count))
+   return correct
+
+#================================================================
+
+def usage():
+   print "Usage: lengthbench.py [-l lengths] [-n sentences] [-o options] parser model input"
+   print "   -l the sentence lengths, separated by commas (default 10,25,50,100,250,1000,2000)"
+   print "   -n the number of sentences of each length (default 100)"
+   print "   -o other options for the parser, such as \"-b16\""
+   sys.exit(1)
+
+if __name__ == '__main__':
+   try:
+      opts, args = getopt.getopt(sys.argv[1:], "l:n:o:")
+   except getopt.GetoptError:
+      usage()
+   if len(args) != 3:
+      usage()
+   parser, model, input = args
+   lengths = [10, 25, 50, 100, 250, 1000, 2000]
+   count = 100
+   options = []
+   for opt, value in opts:
+      if opt == '-l':
+         lengths = [int(x) for x in value.split(',')]
+      elif opt == '-n':
+         count = int(value)
+      elif opt == '-o':
+         options = value.split()
+
+   words = tokens(input)
+   sents = tempfile.mktemp()
+   output = tempfile.mktemp()
+   try:
+      make(words, 0, 0, sents)
+      load, base = min([run(parser, model, sents, output, options) for i in range(3)])
+      print "%s\t%s\t%s\t%s\t%s" % ("length", "trees", "MB", "sent/s", "tokens/s")
+      for length in lengths:
+         make(words, length, count, sents)
+         seconds, memory = run(parser, model, sents, output, options)
+         seconds = max(seconds - load, 1e-6)
+         correct = check(output, length, count)
+         print "%d\t%d/%d\t%.1f\t%.1f\t%.0f" % (length, correct, count, memory - base, count / seconds, count * length / seconds)
+         sys.stdout.flush()
+   finally:
+      for path in [sents, output]:
+         if os.path.exists(path):
+            os.remove(path)
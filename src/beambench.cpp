@@ -0,0 +1,114 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *
+ * beambench.cpp - benchmark beam selection, comparing the heap
+ *                 of CAgendaSimple with the selection of
+ *                 CAgendaSelect
+ *
+ * Usage: beambench [actions [candidates]]
+ *
+ * Each round scores the actions of every state in a full beam,
+ * as a transition-based decoder does, and keeps the best as the
+ * next beam. Scores are drawn from a small range, so that there
+ * are ties, as there are between the states of a real beam.
+ *
+ ****************************************************************/
+
+#include "definitions.h"
+#include "agenda.h"
+
+/*---------------------------------------------------------------
+ *
+ * CBenchItem - a scored action
+ *
+ *--------------------------------------------------------------*/
+
+struct CBenchItem {
+   long score;
+   unsigned source;
+   unsigned action;
+   bool operator > (const CBenchItem &item) const { return score > item.score; }
+   bool operator < (const CBenchItem &item) const { return score < item.score; }
+};
+
+/*---------------------------------------------------------------
+ *
+ * makeScores - the scores of the actions, for all rounds
+ *
+ *--------------------------------------------------------------*/
+
+void makeScores(const unsigned long &nCandidates, std::vector<long> &scores) {
+   srand(0);
+   scores.resize(nCandidates);
+   for (unsigned long i=0; i<nCandidates; ++i)
+      scores[i] = rand()%4096;
+}
+
+/*---------------------------------------------------------------
+ *
+ * bench - run the rounds with one agenda
+ *
+ * Returns the sum of the scores of all the beams, which is the
+ * same for any agenda that keeps the best items.
+ *
+ *--------------------------------------------------------------*/
+
+template<typename AGENDA>
+long bench(const std::string &sName, const unsigned &nBeam, const unsigned &nActions, const std::vector<long> &scores) {
+   AGENDA agenda(nBeam);
+   CBenchItem item;
+   std::vector<long> beam(nBeam, 0);
+   unsigned nGenerators = 1;
+   unsigned long index = 0;
+   unsigned long nRounds = 0;
+   long checksum = 0;
+   const clock_t start = clock();
+   while (index+nGenerators*nActions <= scores.size()) {
+      agenda.clear();
+      for (unsigned generator=0; generator<nGenerators; ++generator) {
+         for (unsigned action=0; action<nActions; ++action) {
+            item.score = beam[generator] + scores[index++];
+            item.source = generator;
+            item.action = action;
+            agenda.insertItem(&item);
+         }
+      }
+      nGenerators = agenda.size();
+      for (unsigned i=0; i<nGenerators; ++i) {
+         // scores are kept small so that they do not overflow
+         beam[i] = agenda.item(i)->score % 65536;
+         checksum += agenda.item(i)->score;
+      }
+      // the beams are in different orders
+      std::sort(beam.begin(), beam.begin()+nGenerators);
+      ++nRounds;
+   }
+   const double seconds = double(clock()-start)/CLOCKS_PER_SEC;
+   std::cout << sName << " beam " << nBeam << ": " << index/(seconds>0?seconds:1e-9) << " candidates/sec, " << nRounds/(seconds>0?seconds:1e-9) << " rounds/sec (" << seconds << "s, checksum " << checksum << ")" << std::endl;
+   return checksum;
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char *argv[]) {
+   try {
+      const unsigned nActions = argc > 1 ? atoi(argv[1]) : 8;
+      const unsigned long nCandidates = argc > 2 ? atol(argv[2]) : 20000000;
+      std::cout << nActions << " actions, " << nCandidates << " candidates" << std::endl;
+      std::vector<long> scores;
+      makeScores(nCandidates, scores);
+      for (unsigned nBeam=8; nBeam<=256; nBeam*=2) {
+         const long heap = bench< CAgendaSimple<CBenchItem> >("CAgendaSimple", nBeam, nActions, scores);
+         const long select = bench< CAgendaSelect<CBenchItem> >("CAgendaSelect", nBeam, nActions, scores);
+         ASSERT(heap==select, "The selected beam differs from the heap");
+      }
+      return 0;
+   } catch (const std::string &e) {
+      std::cerr << "Error: " << e << std::endl;
+      return 1;
+   }
+}
@@ -11,6 +11,7 @@
 
 #include "conparser.h"
 #include "weight.h"
+#include "profile.h"
 
 using namespace TARGET_LANGUAGE;
 using namespace TARGET_LANGUAGE::conparser;
@@ -1368,6 +1369,8 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
    static CStateItem lattice[(MAX_SENTENCE_SIZE*(2+UNARY_MOVES)+2)*(AGENDA_SIZE+1)];
    static CStateItem *lattice_index[MAX_SENTENCE_SIZE*(2+UNARY_MOVES)+2];
 
+   PROFILE_PHASE(kDecode);
+   PROFILE_COUNT(kSentences, 1);
 #ifdef DEBUG
    clock_t total_start_time = clock();
 #endif
@@ -1457,6 +1460,7 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
 #endif
 
          // load context
+         PROFILE_PHASE(kScore);
          m_Context.load(pGenerator, m_lCache, sentence, false);
 
          //pGenerator->trace();
@@ -1476,7 +1480,9 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
 
          if (actions.size() > 0)
             getOrUpdateStackScore(static_cast<CWeight*>(static_cast<conparser::CWeight*>(m_weights)), packedscores, pGenerator);
+         PROFILE_STOP(kScore);
 
+         PROFILE_PHASE(kBeam);
          for (tmp_j=0; tmp_j<actions.size(); ++tmp_j) {
             scored_action.load(actions[tmp_j], pGenerator, packedscores[actions[tmp_j].code()]);
             beam.insertItem(&scored_action);
@@ -1502,6 +1508,7 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
 			return false;
 		}
       // insertItems
+      PROFILE_PHASE(kMove);
       for (tmp_j=0; tmp_j<beam.size(); ++tmp_j) { // insert from
          pGenerator = beam.item(tmp_j)->item;
          pGenerator->Move(lattice_index[index+1], beam.item(tmp_j)->action);
@@ -1525,6 +1532,7 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
          }
          ++lattice_index[index+1];
       }
+      PROFILE_STOP(kMove);
 
 #ifdef SCALE
       if (bAllTerminated)
@@ -1601,6 +1609,7 @@ bool CConParser::work( const bool bTrain , const CStringVector &sentence , CSent
       return true;
 
    //TRACE("Outputing sentence");
+   PROFILE_PHASE(kOutput);
    pBestGen->GenerateTree( sentence, retval[0] );
    if (scores) scores[0] = pBestGen->score;
 
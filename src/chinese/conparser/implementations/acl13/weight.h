@@ -654,6 +654,10 @@ typedef CScoreMapType<CTuple2<unsigned long long, unsigned long long>, SCORE_TYP
 class CWeight : public CWeightBase {
 
 public:
+#ifdef FINGERPRINT_FEATURES
+   // the scores of all the templates, which must be constructed first
+   CFingerprintScoreTable<SCORE_TYPE, CAction::MAX> m_table;
+#endif
    CTaggedWordMap m_mapSYNS0w;
    CConstituentMap m_mapSYNS0c;
    CTagConstituentMap m_mapSYNS0tc;
@@ -1219,7 +1223,11 @@ public:
                            m_mapSubWordHeadCharEqualTag("SubWordHeadCharEqualTag", TABLE_SIZE),
                            m_mapInSubWordDictionaryTag("InSubWordDictionaryTag", TABLE_SIZE),
                            m_mapInSubWordTagDictionaryTag("InSubWordTagDictionaryTag", TABLE_SIZE)
-   { }
+   {
+#ifdef FINGERPRINT_FEATURES
+      iterate_templates(,.attach(m_table););
+#endif
+   }
    ~CWeight() {
    	if (m_Knowledge) delete m_Knowledge;
 //      iterate_templates(,.freePoolMemory(););
@@ -186,16 +186,92 @@ double CReranker::getOrUpdatePriorScores(double *prior_scores, int amount) {
    return retval;
 }
 
+/*----------------------------------------------------------------
+ *
+ * CParseScorer - scores the parses of the candidates in a thread
+ *
+ * The tagger and the depparser do not share state, so the parses
+ * are scored while the calling thread scores the taggings.
+ *
+ *---------------------------------------------------------------*/
+
+class CParseScorer : public CThread {
+protected:
+   CDepParser *m_depparser;
+   const CSentenceParsed *m_nbest;
+   const std::vector<int> &m_lSameParse;
+   std::vector<double> &m_lScores;
+   std::string m_sError;
+public:
+   CParseScorer(CDepParser *depparser, const CSentenceParsed *nbest, const std::vector<int> &same, std::vector<double> &scores) : m_depparser(depparser), m_nbest(nbest), m_lSameParse(same), m_lScores(scores) { }
+   void run() {
+      try {
+         for (int i=0; i<m_lSameParse.size(); ++i)
+            if (m_lSameParse[i] == i)
+               m_lScores[i] = m_depparser->getGlobalScore(m_nbest[i]);
+      }
+      catch (const std::string &e) {
+         m_sError = e;
+      }
+   }
+   const std::string &error() const { return m_sError; }
+};
+
 /*----------------------------------------------------------------
  *
  * findBest - find the best tagged and depparsed sequence index
  *
+ * Candidates that repeat the tagging or the whole output of an
+ * earlier candidate take its score instead of being scored again,
+ * so that the taggings are scored once rather than once for each
+ * of their parses.
+ *
  *---------------------------------------------------------------*/
 
 int CReranker::findBest(const CSentenceParsed *nbest, int nBest, double *prior_scores) {
    int best_index=-1;
    double score, best_score;
-   static CTwoStringVector tagged;
+   m_lTagged.resize(nBest);
+   m_lSameTagging.assign(nBest, -1);
+   m_lSameParse.assign(nBest, -1);
+   m_lTagScores.resize(nBest);
+   m_lParseScores.resize(nBest);
+   for (int i=0; i<nBest; ++i) {
+      if (nbest[i].empty())
+         continue;
+      UnparseSentence(nbest+i, &m_lTagged[i]);
+      m_lSameTagging[i] = m_lSameParse[i] = i;
+      for (int j=0; j<i; ++j) {
+         if (m_lSameTagging[j] == j && m_lTagged[j] == m_lTagged[i]) {
+            m_lSameTagging[i] = j;
+            for (int k=j; k<i; ++k) {
+               if (m_lSameParse[k] == k && m_lSameTagging[k] == j && nbest[k] == nbest[i]) {
+                  m_lSameParse[i] = k;
+                  break;
+               }
+            }
+            break;
+         }
+      }
+   }
+
+   CParseScorer parse_scorer(m_depparser, nbest, m_lSameParse, m_lParseScores);
+   parse_scorer.start();
+   std::string error;
+   try {
+      for (int i=0; i<nBest; ++i)
+         if (m_lSameTagging[i] == i)
+            m_lTagScores[i] = m_tagger->getGlobalScore(&m_lTagged[i]);
+   }
+   catch (const std::string &e) {
+      error = e;
+   }
+   parse_scorer.join();
+   if (!error.empty())
+      throw error;
+   if (!parse_scorer.error().empty())
+      throw parse_scorer.error();
+
    for (int i=0; i<nBest; ++i) {
       if (nbest[i].empty()) {
          if (best_index==-1)
@@ -203,9 +279,8 @@ int CReranker::findBest(const CSentenceParsed *nbest, int nBest, double *prior_s
          continue;
       }
 
-      UnparseSentence(nbest+i, &tagged);
-      score = m_tagger->getGlobalScore(&tagged);
-      score += m_depparser->getGlobalScore(nbest[i]);
+      score = m_lTagScores[m_lSameTagging[i]];
+      score += m_lParseScores[m_lSameParse[i]];
       score += getOrUpdatePriorScores(prior_scores+(i*2), 0);//
       if (best_index==-1 || score>best_score) {
          best_index=i; best_score=score;
@@ -15,6 +15,7 @@
 
 #include "tagger.h"
 #include "depparser.h"
+#include "thread.h"
 
 #include "weight.h"
 
@@ -32,6 +33,14 @@ protected:
    reranker::CWeight *m_weights;
    int m_nScoreIndex;
 
+   // the candidates of a sentence, with the first candidate of the
+   // same tagging and of the same parse, which are scored only once
+   std::vector<CTwoStringVector> m_lTagged;
+   std::vector<int> m_lSameTagging;
+   std::vector<int> m_lSameParse;
+   std::vector<double> m_lTagScores;
+   std::vector<double> m_lParseScores;
+
 public:
    CReranker(const std::string &sFeatureDB, const bool &bTrain) {
       m_depparser = new CDepParser(sFeatureDB+".depparser", bTrain);
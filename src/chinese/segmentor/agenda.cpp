@@ -63,6 +63,74 @@ unsigned long groupCharTypes(CSegmentor *segmentor, const CStringVector *sentenc
    return ret;
 }
 
+/*---------------------------------------------------------------
+ *
+ * getOrUpdateCharScore - get the score of the char templates
+ *
+ * The char n-grams around end, given whether the char at end
+ * starts a word and whether the next char is separated from it.
+ *
+ *--------------------------------------------------------------*/
+
+SCORE_TYPE getOrUpdateCharScore(CSegmentor *segmentor, const CStringVector* sentence, const int &end, const int &char_info, const int &which_score, SCORE_TYPE amount=0, int round=0) {
+
+   CWeight &weight = segmentor->getWeights();
+   const int size = sentence->size();
+   SCORE_TYPE retval = 0;
+   int tmp_i;
+
+   for (tmp_i = std::max(0, end-1); tmp_i < std::min(size, end+2); ++tmp_i) {
+      retval += weight.m_mapCharUnigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 1), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatUnigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 1, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+   }
+
+   for (tmp_i = std::max(0, end-1); tmp_i < std::min(size-1, end+1); ++tmp_i) {
+      retval += weight.m_mapCharBigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 2), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatBigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 2, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+   }
+
+   for (tmp_i = std::max(0, end-1); tmp_i < std::min(size-2, end); ++tmp_i) {
+      retval += weight.m_mapCharTrigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 3), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatTrigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 3, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+   }
+
+   return retval;
+}
+
+/*---------------------------------------------------------------
+ *
+ * cacheCharScores - compute the char scores for a sentence
+ *
+ * The scores that do not depend on the state item are looked up
+ * once for each char, and the separate and append scores take
+ * them from the cache when decoding. Updates do not use it.
+ *
+ *--------------------------------------------------------------*/
+
+void cacheCharScores(CSegmentor *segmentor, const CStringVector* sentence) {
+
+   const int which_score = segmentor->isTraining() ? CScore<SCORE_TYPE>::eNonAverage : CScore<SCORE_TYPE>::eAverage ;
+   CWeight &weight = segmentor->getWeights();
+   const int size = sentence->size();
+   const SCORE_TYPE amount = 0; // for _cache_word
+
+   segmentor->m_lCharScores.resize(size);
+   for (int index=0; index<size; ++index) {
+      CCharScores &scores = segmentor->m_lCharScores[index];
+      for (int char_info=0; char_info<4; ++char_info)
+         scores.chars[char_info] = getOrUpdateCharScore(segmentor, sentence, index, char_info, which_score);
+      if (index < size-1) {
+         const CWord &two_char = _cache_word(index, 2);
+         scores.separate = weight.m_mapSeparateChars.getOrUpdateScore(two_char, which_score, amount);
+         scores.consecutive = weight.m_mapConsecutiveChars.getOrUpdateScore(two_char, which_score, amount);
+      }
+      else {
+         scores.separate = 0;
+         scores.consecutive = 0;
+      }
+   }
+}
+
 /*---------------------------------------------------------------
  *
  * getOrUpdateSeparateScore - get the local score when a word is done
@@ -87,7 +155,6 @@ SCORE_TYPE getOrUpdateSeparateScore(CSegmentor *segmentor, const CStringVector*
    CWeight &weight = segmentor->getWeights();
 
    // temporary variables
-   static int tmp_i;
    static int length, last_length, word_length;
    static int start, end, last_start, last_end;
    start = item->getWordStart();
@@ -148,24 +215,12 @@ SCORE_TYPE getOrUpdateSeparateScore(CSegmentor *segmentor, const CStringVector*
    length = normalizeLength(length);
    last_length = normalizeLength(last_length);
 
-   nReturn = 0;
-
    // ===================================================================================
    // character scores -- with end-1 middled
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<int>(sentence->size()), end+2); ++tmp_i) {
-      nReturn += weight.m_mapCharUnigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 1), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) nReturn += weight.m_mapCharCatUnigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 1, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-   }
-
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<int>(sentence->size())-1, end+1); ++tmp_i) {
-      nReturn += weight.m_mapCharBigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 2), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) nReturn += weight.m_mapCharCatBigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 2, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-   }
-
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<int>(sentence->size())-2, end); ++tmp_i) {
-      nReturn += weight.m_mapCharTrigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 3), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) nReturn += weight.m_mapCharCatTrigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 3, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-   }
+   if (amount==0)
+      nReturn = segmentor->m_lCharScores[end].chars[char_info];
+   else
+      nReturn = getOrUpdateCharScore(segmentor, sentence, end, char_info, which_score, amount, round);
 
    // ===================================================================================
    // word scores
@@ -189,7 +244,10 @@ SCORE_TYPE getOrUpdateSeparateScore(CSegmentor *segmentor, const CStringVector*
       nReturn += weight.m_mapLastLengthByWord.getOrUpdateScore(std::make_pair(word, last_length), which_score, amount, round);
    }
    if ( end < sentence->size()-1 ) {
-      nReturn += weight.m_mapSeparateChars.getOrUpdateScore(two_char, which_score, amount, round);
+      if (amount==0)
+         nReturn += segmentor->m_lCharScores[end].separate;
+      else
+         nReturn += weight.m_mapSeparateChars.getOrUpdateScore(two_char, which_score, amount, round);
 
       nReturn += weight.m_mapWordAndNextChar.getOrUpdateScore(word_nextchar, which_score, amount, round);
       nReturn += weight.m_mapFirstCharLastWordByWord.getOrUpdateScore(first_chars_two_words, which_score, amount, round);
@@ -221,8 +279,6 @@ SCORE_TYPE getOrUpdateAppendScore(CSegmentor *segmentor, const CStringVector* se
    which_score = segmentor->isTraining() ? CScore<SCORE_TYPE>::eNonAverage : CScore<SCORE_TYPE>::eAverage ;
    // abbreviation weight
    CWeight &weight = segmentor->getWeights();
-   // temporary vals
-   static int tmp_i;
 
    // about the chars
    const unsigned long start = item->getWordStart();
@@ -244,25 +300,16 @@ SCORE_TYPE getOrUpdateAppendScore(CSegmentor *segmentor, const CStringVector* se
       first_char_and_char.allocate(first_char, current_char);
    }
 
-   retval = 0;
    // ===================================================================================
    // character scores -- the middle character is end-1
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<unsigned long>(sentence->size()), end+2); ++tmp_i) {
-      retval += weight.m_mapCharUnigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 1), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatUnigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 1, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-   }
-
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<unsigned long>(sentence->size())-1, end+1); ++tmp_i) {
-      retval += weight.m_mapCharBigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 2), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatBigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 2, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+   if (amount==0) {
+      retval = segmentor->m_lCharScores[end].chars[char_info];
+      retval += segmentor->m_lCharScores[end].consecutive;
    }
-
-   for (tmp_i = std::max(0, static_cast<int>(end)-1); tmp_i < std::min(static_cast<unsigned long>(sentence->size())-2, end); ++tmp_i) {
-      retval += weight.m_mapCharTrigram.getOrUpdateScore( std::make_pair( _cache_word(tmp_i, 3), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
-      if (segmentor->hasCharTypeKnowledge()) retval += weight.m_mapCharCatTrigram.getOrUpdateScore( std::make_pair( groupCharTypes(segmentor, sentence, tmp_i, 3, amount), encodeCharInfoAndPosition(char_info, tmp_i-end) ), which_score, amount, round);
+   else {
+      retval = getOrUpdateCharScore(segmentor, sentence, end, char_info, which_score, amount, round);
+      retval += weight.m_mapConsecutiveChars.getOrUpdateScore( _cache_word(end, 2), which_score, amount, round);
    }
-
-   retval += weight.m_mapConsecutiveChars.getOrUpdateScore( _cache_word(end, 2), which_score, amount, round);
    retval += weight.m_mapFirstCharAndChar.getOrUpdateScore( first_char_and_char, which_score, amount, round);
 
    return retval;
@@ -396,6 +443,7 @@ bool work(CSegmentor *segmentor, const CStringVector &sentence, CStringVector *v
    //clock_t start_time = clock();
    TRACE("Initialising the decoding process...");
    segmentor->clearWordCache();
+   cacheCharScores(segmentor, &sentence);
 
    lattice[0].clear();
    lattice_index[0] = lattice;
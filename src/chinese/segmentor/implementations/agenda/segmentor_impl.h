@@ -107,6 +107,22 @@ public:
    }
 };
 
+/*===============================================================
+ *
+ * CCharScores - the scores of the character templates at a char
+ *
+ * These do not depend on the segmentation but only on the char
+ * and whether it starts or ends a word, so they are computed for
+ * each char once per sentence instead of for each state item.
+ *
+ *==============================================================*/
+
+struct CCharScores {
+   SCORE_TYPE chars[4];     // the char n-grams, by encodeCharSegmentation
+   SCORE_TYPE separate;     // the next char is separated
+   SCORE_TYPE consecutive;  // the next char is appended
+};
+
 /*===============================================================
  *
  * The implementation specific part of segmentor is defined here. 
@@ -114,6 +130,8 @@ public:
  *==============================================================*/
 
 class CSegmentorImpl {
+public:
+   std::vector<CCharScores> m_lCharScores; // for the sentence being segmented
 };
 
 //===============================================================
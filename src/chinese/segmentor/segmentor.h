@@ -13,6 +13,7 @@
 #define CHINESE_SEGMENTOR_H 1
 
 #include "base_include.h"
+#include "linguistics/word_trie.h"
 
 /*===============================================================
  *
@@ -46,6 +47,8 @@ namespace segmentor {
  *              m_lWordCache[1][5] = B C D E F
  * Note: there are space wastes, but this seem to be the most time
  *       efficient.
+ * Words missing from the cache are found by walking the trie of
+ * the dictionary from the start of the span.
  *
  *==============================================================*/
 
@@ -53,13 +56,14 @@ class CSegmentor : public segmentor::CSegmentorImpl {
 
 private:
    unsigned long *m_lWordCache;
+   CWordSpans m_WordSpans;
    bool m_bTrain;
    segmentor::CFeatureHandle *m_Feature;
 
 //-------------------------------------------------------------
 // Constructor destructor
 public:
-   CSegmentor(const std::string &sFeatureDBPath, bool bTrain=false, const std::string &sCharCatFile="", const std::string &sLexiconFile="", bool bRule=false) : segmentor::CSegmentorImpl(), m_bTrain(bTrain) {
+   CSegmentor(const std::string &sFeatureDBPath, bool bTrain=false, const std::string &sCharCatFile="", const std::string &sLexiconFile="", bool bRule=false) : segmentor::CSegmentorImpl(), m_WordSpans(segmentor::MAX_SENTENCE_SIZE), m_bTrain(bTrain) {
       // load features
       m_Feature = new segmentor::CFeatureHandle(this, sFeatureDBPath, bTrain, bRule);
       // initialize word cache
@@ -90,7 +94,7 @@ public:
       delete m_Feature;
       delete [] m_lWordCache;
    }
-   CSegmentor(CSegmentor& segmentor) { THROW("CSegmentor does not support copy constructor!"); }
+   CSegmentor(CSegmentor& segmentor) : m_WordSpans(0) { THROW("CSegmentor does not support copy constructor!"); }
 
 //-------------------------------------------------------------
 // Main interface
@@ -161,19 +165,15 @@ public:
 // Word cache
 public:
    const unsigned long& findWordFromCache(const int &start, const int &length, const CStringVector* sentence) {
-      if (m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == ~0L) { // empty std::string
-         static std::string temp;
-         static unsigned long int i;
-         temp.clear();
-         for ( i = start; i < start+length ; ++i )
-            temp += sentence->at(i) ;
-         m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] = CWord(temp, false).code();
-      }
+      if (m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == ~0L) // empty std::string
+         m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] = m_WordSpans.find(start, start+length-1, sentence);
       return m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ];
    }
    const unsigned long& replaceWordToCache(const int &start, const int &length, const CStringVector* sentence) {
       assert(start+length<=sentence->size());
-      if (m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == ~0L || m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == CWord::UNKNOWN) { // empty std::string
+      if (m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == ~0L || m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == CWord::UNKNOWN) // empty std::string
+         m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] = m_WordSpans.find(start, start+length-1, sentence);
+      if (m_lWordCache[ start * segmentor::MAX_SENTENCE_SIZE + length - 1 ] == CWord::UNKNOWN) { // a new word
          static std::string temp;
          static unsigned long int i;
          temp.clear();
@@ -185,6 +185,7 @@ public:
    }
    void clearWordCache() {
       memset(m_lWordCache, 255, sizeof(m_lWordCache[0])*segmentor::MAX_SENTENCE_SIZE*segmentor::MAX_SENTENCE_SIZE);
+      m_WordSpans.clear();
 //      for (int i=0; i<segmentor::MAX_SENTENCE_SIZE; ++i)
 //         for (int j=0; j<segmentor::MAX_SENTENCE_SIZE; j++)
 //            m_lWordCache[i*segmentor::MAX_SENTENCE_SIZE+j].clear();
@@ -21,6 +21,7 @@
  *==============================================================*/
 
 #include "weight.h"
+#include "linguistics/word_trie.h"
 
 namespace chinese {
 
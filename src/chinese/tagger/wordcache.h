@@ -25,6 +25,10 @@
  *              m_lWordCache[1][5] = B C D E F
  * Note: there are space wastes, but this seem to be the most time
  *       efficient. 
+ *
+ * Words missing from the cache are found by walking the trie of
+ * the dictionary from the start of the span, so that no string
+ * is built for spans that are not dictionary words.
  * 
  *===============================================================*/
 
@@ -34,23 +38,19 @@ protected:
 
    unsigned *m_lWordCache;
    int m_nMaxSentenceSize;
+   CWordSpans m_Spans;
 
 public:
 
-   CWordCache(int nSentenceSize) : m_nMaxSentenceSize(nSentenceSize) { m_lWordCache = new unsigned[nSentenceSize*nSentenceSize]; }
+   CWordCache(int nSentenceSize) : m_nMaxSentenceSize(nSentenceSize), m_Spans(nSentenceSize) { m_lWordCache = new unsigned[nSentenceSize*nSentenceSize]; }
    virtual ~CWordCache() { delete [] m_lWordCache; }
 
 public:
 
    // find a word from the cache
    const unsigned& find(const int &start, const int &end, const CStringVector* sentence) {
-      static std::string temp;
-      if (m_lWordCache[start*m_nMaxSentenceSize+end] == ~0 ) { // empty std::string
-         temp.clear();
-         for (int i=start; i<=end; ++i) // append the corresponding characters
-            temp += sentence->at(i);
-            m_lWordCache[start*m_nMaxSentenceSize+end] = CWord(temp,false).code();
-      }
+      if (m_lWordCache[start*m_nMaxSentenceSize+end] == ~0 ) // empty std::string
+         m_lWordCache[start*m_nMaxSentenceSize+end] = m_Spans.find(start, end, sentence);
       return m_lWordCache[start*m_nMaxSentenceSize+end];
    }
 
@@ -58,7 +58,9 @@ public:
    const unsigned& replace(const int &start, const int &end, const CStringVector* sentence) {
       static std::string temp;
       if (m_lWordCache[start*m_nMaxSentenceSize+end] == ~0 ||
-          m_lWordCache[start*m_nMaxSentenceSize+end] == CWord::UNKNOWN ) { // empty std::string
+          m_lWordCache[start*m_nMaxSentenceSize+end] == CWord::UNKNOWN ) // empty std::string
+         m_lWordCache[start*m_nMaxSentenceSize+end] = m_Spans.find(start, end, sentence);
+      if (m_lWordCache[start*m_nMaxSentenceSize+end] == CWord::UNKNOWN ) { // a new word
          temp.clear();
          for (int i=start; i<=end; ++i) // append the corresponding characters
             temp += sentence->at(i);
@@ -73,6 +75,7 @@ public:
 //         for (int j=0; j<m_nMaxSentenceSize; j++)
 //            m_lWordCache[i*m_nMaxSentenceSize+j].clear();
       memset(m_lWordCache, 255, sizeof(m_lWordCache[0])*m_nMaxSentenceSize*m_nMaxSentenceSize);
+      m_Spans.clear();
    }
 
 };
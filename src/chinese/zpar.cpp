@@ -16,11 +16,72 @@
 #include "doc2snt.h"
 #include "reader.h"
 #include "writer.h"
+#include "stages.h"
 #include "stdlib.h"
 
 using namespace chinese;
 
 #define MAX_SENTENCE_SIZE 512
+#define RING_SIZE 64
+
+/*===============================================================
+ *
+ * the stages
+ *
+ * The document is split into sentences in the calling thread,
+ * and each model and the output run in stage threads of their
+ * own, so that splitting, the models and writing overlap. Each
+ * model is only used by its own stage, so the models need not
+ * be reentrant.
+ *
+ *==============================================================*/
+
+void split(CDoc2Snt &doc2snt, CRing<CStringVector> &sentences, CStageStats &stats) {
+   try {
+      CStringVector *input_sent;
+      // If we read segmented sentence, we will ignore spaces from input.
+      while ((input_sent = sentences.back()) != 0) {
+         TRACE("Sentence " << stats.items());
+         stats.startItem();
+         input_sent->clear();
+         if (!doc2snt.getSentence(*input_sent))
+            break;
+         if ( input_sent->back()=="\n" ) {
+            input_sent->pop_back();
+         }
+         stats.finishItem();
+         sentences.push();
+      }
+      sentences.close();
+   }
+   catch (const std::string &e) {
+      stats.fail(e);
+      sentences.abort();
+   }
+}
+
+class CTagStage : public CStage<CStringVector, CTwoStringVector> {
+protected:
+   CTagger &m_tagger;
+public:
+   CTagStage(CTagger &tagger, CRing<CStringVector> &input, CRing<CTwoStringVector> &output) : CStage<CStringVector, CTwoStringVector>("tag", input, output), m_tagger(tagger) { }
+   void process(CStringVector &input, CTwoStringVector &output) {
+      m_tagger.tag(&input, &output, NULL, 1);
+   }
+};
+
+// runs the stages after split to the end of the document, and reports them
+void runStages(CDoc2Snt &doc2snt, CRing<CStringVector> &sentences, std::vector<CThread*> &threads, std::vector<const CStageStats*> &stages) {
+   CStageStats split_stats("split");
+   const uint64_t start = CStageStats::now();
+   for (unsigned long i=0; i<threads.size(); ++i)
+      threads[i]->start();
+   split(doc2snt, sentences, split_stats);
+   for (unsigned long i=0; i<threads.size(); ++i)
+      threads[i]->join();
+   stages.insert(stages.begin(), &split_stats);
+   finishStages(stages, (CStageStats::now()-start)/1e9, std::cerr);
+}
 
 #define JOINT_CONPARSER
 #ifndef JOINT_CONPARSER
@@ -30,46 +91,41 @@ using namespace chinese;
  *
  *==============================================================*/
 
+class CTagWriteStage : public CSink<CTwoStringVector> {
+protected:
+   CSentenceWriter &m_writer;
+   bool m_bNewLine;
+public:
+   CTagWriteStage(CSentenceWriter &writer, bool bNewLine, CRing<CTwoStringVector> &input) : CSink<CTwoStringVector>("write", input), m_writer(writer), m_bNewLine(bNewLine) { }
+   void process(CTwoStringVector &input) {
+      m_writer.writeSentence(&input, '_', m_bNewLine);
+   }
+};
+
 void tag(const std::string sInputFile, const std::string sOutputFile, const std::string sFeaturePath, bool bOutDoc) {
    std::cerr << "Tagging started" << std::endl;
-   int time_start = clock();
+   const uint64_t time_start = CStageStats::now();
    std::string sFeatureFile = sFeaturePath + "/tagger";
    if (!FileExists(sFeatureFile))
       THROW("Tagger model does not exists. It should be put at model_path/tagger");
    CTagger tagger(sFeatureFile, false, MAX_SENTENCE_SIZE, "", false);
    CDoc2Snt doc2snt(sInputFile, MAX_SENTENCE_SIZE);
-   CSentenceReader input_reader(sInputFile);
    CSentenceWriter output_writer(sOutputFile);
-   CStringVector *input_sent = new CStringVector;
-   CTwoStringVector *output_sent = new CTwoStringVector;
-
-   unsigned nCount=0;
    bool bNewLine = bOutDoc ? false : true;
-   bool bDocPar = false;
-
-   CBitArray prunes(MAX_SENTENCE_SIZE);
-
-   //bool bReadSuccessful;
-   //bReadSuccessful = input_reader.readRawSentence(input_sent, true, false);
-
-   // If we read segmented sentence, we will ignore spaces from input.
-   while( doc2snt.getSentence( *input_sent ) ) {
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-      bDocPar = false;
-      if ( input_sent->back()=="\n" ) {
-         bDocPar = true;
-         input_sent->pop_back();
-      }
-      tagger.tag(input_sent, output_sent, NULL, 1);
-      // Ouptut sent
-      output_writer.writeSentence(output_sent, '_', bNewLine);
-      input_sent->clear();
-   }
-   delete input_sent;
-   delete output_sent;
 
-   std::cerr << "Tagging has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   CRing<CStringVector> sentences(RING_SIZE);
+   CRing<CTwoStringVector> tagged(RING_SIZE);
+   CTagStage tag_stage(tagger, sentences, tagged);
+   CTagWriteStage write_stage(output_writer, bNewLine, tagged);
+   std::vector<CThread*> threads;
+   threads.push_back(&tag_stage);
+   threads.push_back(&write_stage);
+   std::vector<const CStageStats*> stages;
+   stages.push_back(&tag_stage);
+   stages.push_back(&write_stage);
+   runStages(doc2snt, sentences, threads, stages);
+
+   std::cerr << "Tagging has finished successfully. Total time taken is: " << (CStageStats::now()-time_start)/1e9 << std::endl;
 }
 
 /*===============================================================
@@ -78,9 +134,29 @@ void tag(const std::string sInputFile, const std::string sOutputFile, const std:
  *
  *==============================================================*/
 
+class CConParseStage : public CStage<CTwoStringVector, chinese::CCFGTree> {
+protected:
+   CConParser &m_conparser;
+public:
+   CConParseStage(CConParser &conparser, CRing<CTwoStringVector> &input, CRing<chinese::CCFGTree> &output) : CStage<CTwoStringVector, chinese::CCFGTree>("parse", input, output), m_conparser(conparser) { }
+   void process(CTwoStringVector &input, chinese::CCFGTree &output) {
+      m_conparser.parse(input, &output);
+   }
+};
+
+class CConWriteStage : public CSink<chinese::CCFGTree> {
+protected:
+   std::ostream &m_outs;
+public:
+   CConWriteStage(std::ostream &outs, CRing<chinese::CCFGTree> &input) : CSink<chinese::CCFGTree>("write", input), m_outs(outs) { }
+   void process(chinese::CCFGTree &input) {
+      m_outs << input.str_unbinarized() << std::endl;
+   }
+};
+
 void parse(const std::string sInputFile, const std::string sOutputFile, const std::string sFeaturePath) {
    std::cerr << "Initializing ZPar..." << std::endl;
-   int time_start = clock();
+   const uint64_t time_start = CStageStats::now();
    std::ostream *outs; if (sOutputFile=="") outs=&std::cout; else outs = new std::ofstream(sOutputFile.c_str());
    std::string sTaggerFeatureFile = sFeaturePath + "/tagger";
    std::string sParserFeatureFile = sFeaturePath + "/conparser";
@@ -93,35 +169,26 @@ void parse(const std::string sInputFile, const std::string sOutputFile, const st
    std::cerr << "[The parsing model] "; std::cerr.flush();
    CConParser conparser(sParserFeatureFile, false);
    CDoc2Snt doc2snt(sInputFile, MAX_SENTENCE_SIZE);
-   CSentenceReader input_reader(sInputFile);
-   CStringVector *input_sent = new CStringVector;
-   CTwoStringVector *tagged_sent = new CTwoStringVector;
-   chinese::CCFGTree *output_sent = new chinese::CCFGTree;
    std::cerr << "ZPar initialized." << std::endl; std::cerr.flush();
 
-   unsigned nCount=0;
-
-   CBitArray prunes(MAX_SENTENCE_SIZE);
-
-   // If we read segmented sentence, we will ignore spaces from input.
-   while( doc2snt.getSentence( *input_sent ) ) {
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-      if ( input_sent->back()=="\n" ) {
-         input_sent->pop_back();
-      }
-      tagger.tag(input_sent, tagged_sent, NULL, 1);
-      conparser.parse(*tagged_sent, output_sent);
-      // Ouptut sent
-      (*outs) << output_sent->str_unbinarized() << std::endl;
-      input_sent->clear();
-   }
-   delete input_sent;
-   delete tagged_sent;
-   delete output_sent;
+   CRing<CStringVector> sentences(RING_SIZE);
+   CRing<CTwoStringVector> tagged(RING_SIZE);
+   CRing<chinese::CCFGTree> parsed(RING_SIZE);
+   CTagStage tag_stage(tagger, sentences, tagged);
+   CConParseStage parse_stage(conparser, tagged, parsed);
+   CConWriteStage write_stage(*outs, parsed);
+   std::vector<CThread*> threads;
+   threads.push_back(&tag_stage);
+   threads.push_back(&parse_stage);
+   threads.push_back(&write_stage);
+   std::vector<const CStageStats*> stages;
+   stages.push_back(&tag_stage);
+   stages.push_back(&parse_stage);
+   stages.push_back(&write_stage);
+   runStages(doc2snt, sentences, threads, stages);
 
    if (sOutputFile!="") delete outs;
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   std::cerr << "Parsing has finished successfully. Total time taken is: " << (CStageStats::now()-time_start)/1e9 << std::endl;
 }
 
 #else
@@ -131,11 +198,54 @@ void parse(const std::string sInputFile, const std::string sOutputFile, const st
  *
  *==============================================================*/
 
+class CJointParseStage : public CStage<CStringVector, chinese::CJointTree> {
+protected:
+   CConParser &m_conparser;
+public:
+   CJointParseStage(CConParser &conparser, CRing<CStringVector> &input, CRing<chinese::CJointTree> &output) : CStage<CStringVector, chinese::CJointTree>("parse", input, output), m_conparser(conparser) { }
+   void process(CStringVector &input, chinese::CJointTree &output) {
+      m_conparser.parse(input, &output , 0, 1 ) ;
+   }
+};
+
+class CJointWriteStage : public CSink<chinese::CJointTree> {
+protected:
+   std::ostream *m_outs;
+   CSentenceWriter *m_output_writer;
+   bool m_bSegmented, m_bTagged, m_bCharTag;
+   CTwoStringVector m_tagged_sent;
+   CStringVector m_output_sent_untag;
+public:
+   CJointWriteStage(std::ostream *outs, CSentenceWriter *output_writer, bool bSegmented, bool bTagged, bool bCharTag, CRing<chinese::CJointTree> &input) : CSink<chinese::CJointTree>("write", input), m_outs(outs), m_output_writer(output_writer), m_bSegmented(bSegmented), m_bTagged(bTagged), m_bCharTag(bCharTag) { }
+   void process(chinese::CJointTree &output_sent) {
+      if(!m_bSegmented && !m_bTagged)
+      {
+         // Output Character Tag or Not
+         if ( m_bCharTag ) {
+            (*m_outs) << output_sent.str_unbinarizedall() << std::endl;
+         } else {
+            (*m_outs) << output_sent.str_unbinarized() << std::endl;
+         }
+      }
+      else if(m_bTagged)
+      {
+         UnparseSentence( &output_sent, &m_tagged_sent ) ;
+         m_output_writer->writeSentence(&m_tagged_sent, '_', true);
+      }
+      else if(m_bSegmented)
+      {
+         UnparseSentence( &output_sent, &m_tagged_sent ) ;
+         UntagSentence( &m_tagged_sent, &m_output_sent_untag );
+         m_output_writer->writeSentence(&m_output_sent_untag);
+      }
+   }
+};
+
 void jointparse(const std::string sInputFile, const std::string sOutputFile, const std::string sFeaturePath, bool bSegmented, bool bTagged, bool bCharTag) {
    std::cerr << "Initializing ZPar..." << std::endl;
-   int time_start = clock();
-   std::ostream *outs;
-   CSentenceWriter *output_writer;
+   const uint64_t time_start = CStageStats::now();
+   std::ostream *outs = 0;
+   CSentenceWriter *output_writer = 0;
    if(!bSegmented && !bTagged)
    {
 	   if (sOutputFile=="") outs=&std::cout; else outs = new std::ofstream(sOutputFile.c_str());
@@ -150,56 +260,23 @@ void jointparse(const std::string sInputFile, const std::string sOutputFile, con
    std::cerr << "[The parsing model] "; std::cerr.flush();
    CConParser conparser(sParserFeatureFile, MAX_SENTENCE_SIZE, false);
    CDoc2Snt doc2snt(sInputFile, MAX_SENTENCE_SIZE);
-   CSentenceReader input_reader(sInputFile);
-   CStringVector *input_sent = new CStringVector;
-   CStringVector *output_sent_untag = new CStringVector;
-   CTwoStringVector *tagged_sent = new CTwoStringVector;
-   chinese::CJointTree *output_sent = new chinese::CJointTree;
    std::cerr << "ZPar initialized." << std::endl; std::cerr.flush();
 
-   unsigned nCount=0;
-
-   CBitArray prunes(MAX_SENTENCE_SIZE);
-
-   // If we read segmented sentence, we will ignore spaces from input.
-   while( doc2snt.getSentence( *input_sent ) ) {
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-      if ( input_sent->back()=="\n" ) {
-         input_sent->pop_back();
-      }
-      conparser.parse(*input_sent, output_sent , 0, 1 ) ;
-      // Ouptut sent
-      if(!bSegmented && !bTagged)
-      {
-         // Output Character Tag or Not
-         if ( bCharTag ) {
-    	      (*outs) << output_sent->str_unbinarizedall() << std::endl;
-         } else {
-    	      (*outs) << output_sent->str_unbinarized() << std::endl;
-         }
-      }
-      else if(bTagged)
-      {
-    	  UnparseSentence( output_sent, tagged_sent ) ;
-    	  output_writer->writeSentence(tagged_sent, '_', true);
-      }
-      else if(bSegmented)
-      {
-    	  UnparseSentence( output_sent, tagged_sent ) ;
-    	  UntagSentence( tagged_sent, output_sent_untag );
-    	  output_writer->writeSentence(output_sent_untag);
-      }
-      input_sent->clear();
-   }
-   delete input_sent;
-   delete tagged_sent;
-   delete output_sent;
-   delete output_sent_untag;
+   CRing<CStringVector> sentences(RING_SIZE);
+   CRing<chinese::CJointTree> parsed(RING_SIZE);
+   CJointParseStage parse_stage(conparser, sentences, parsed);
+   CJointWriteStage write_stage(outs, output_writer, bSegmented, bTagged, bCharTag, parsed);
+   std::vector<CThread*> threads;
+   threads.push_back(&parse_stage);
+   threads.push_back(&write_stage);
+   std::vector<const CStageStats*> stages;
+   stages.push_back(&parse_stage);
+   stages.push_back(&write_stage);
+   runStages(doc2snt, sentences, threads, stages);
 
    if (sOutputFile!="" && !bSegmented && !bTagged) delete outs;
    if(bSegmented || bTagged) delete output_writer;
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   std::cerr << "Parsing has finished successfully. Total time taken is: " << (CStageStats::now()-time_start)/1e9 << std::endl;
 }
 
 #endif
@@ -210,9 +287,29 @@ void jointparse(const std::string sInputFile, const std::string sOutputFile, con
  *
  *==============================================================*/
 
+class CDepParseStage : public CStage<CTwoStringVector, CLabeledDependencyTree> {
+protected:
+   CDepParser &m_depparser;
+public:
+   CDepParseStage(CDepParser &depparser, CRing<CTwoStringVector> &input, CRing<CLabeledDependencyTree> &output) : CStage<CTwoStringVector, CLabeledDependencyTree>("parse", input, output), m_depparser(depparser) { }
+   void process(CTwoStringVector &input, CLabeledDependencyTree &output) {
+      m_depparser.parse(input, &output);
+   }
+};
+
+class CDepWriteStage : public CSink<CLabeledDependencyTree> {
+protected:
+   std::ostream &m_outs;
+public:
+   CDepWriteStage(std::ostream &outs, CRing<CLabeledDependencyTree> &input) : CSink<CLabeledDependencyTree>("write", input), m_outs(outs) { }
+   void process(CLabeledDependencyTree &input) {
+      m_outs << input;
+   }
+};
+
 void depparse(const std::string sInputFile, const std::string sOutputFile, const std::string sFeaturePath) {
    std::cerr << "Initializing ZPar..." << std::endl;
-   int time_start = clock();
+   const uint64_t time_start = CStageStats::now();
    std::ostream *outs; if (sOutputFile=="") outs=&std::cout; else outs = new std::ofstream(sOutputFile.c_str());
    std::string sTaggerFeatureFile = sFeaturePath + "/tagger";
    std::string sParserFeatureFile = sFeaturePath + "/depparser";
@@ -225,35 +322,26 @@ void depparse(const std::string sInputFile, const std::string sOutputFile, const
    std::cerr << "[The parsing model] "; std::cerr.flush();
    CDepParser depparser(sParserFeatureFile, false);
    CDoc2Snt doc2snt(sInputFile, MAX_SENTENCE_SIZE);
-   CSentenceReader input_reader(sInputFile);
-   CStringVector *input_sent = new CStringVector;
-   CTwoStringVector *tagged_sent = new CTwoStringVector;
-   CLabeledDependencyTree *output_sent = new CLabeledDependencyTree;
    std::cerr << "ZPar initialized." << std::endl; std::cerr.flush();
 
-   unsigned nCount=0;
-
-   CBitArray prunes(MAX_SENTENCE_SIZE);
-
-   // If we read segmented sentence, we will ignore spaces from input.
-   while( doc2snt.getSentence( *input_sent ) ) {
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-      if ( input_sent->back()=="\n" ) {
-         input_sent->pop_back();
-      }
-      tagger.tag(input_sent, tagged_sent, NULL, 1);
-      depparser.parse(*tagged_sent, output_sent);
-      // Ouptut sent
-      (*outs) << *output_sent;
-      input_sent->clear();
-   }
-   delete input_sent;
-   delete tagged_sent;
-   delete output_sent;
+   CRing<CStringVector> sentences(RING_SIZE);
+   CRing<CTwoStringVector> tagged(RING_SIZE);
+   CRing<CLabeledDependencyTree> parsed(RING_SIZE);
+   CTagStage tag_stage(tagger, sentences, tagged);
+   CDepParseStage parse_stage(depparser, tagged, parsed);
+   CDepWriteStage write_stage(*outs, parsed);
+   std::vector<CThread*> threads;
+   threads.push_back(&tag_stage);
+   threads.push_back(&parse_stage);
+   threads.push_back(&write_stage);
+   std::vector<const CStageStats*> stages;
+   stages.push_back(&tag_stage);
+   stages.push_back(&parse_stage);
+   stages.push_back(&write_stage);
+   runStages(doc2snt, sentences, threads, stages);
 
    if (sOutputFile!="") delete outs;
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   std::cerr << "Parsing has finished successfully. Total time taken is: " << (CStageStats::now()-time_start)/1e9 << std::endl;
 }
 
 /*===============================================================
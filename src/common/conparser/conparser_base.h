@@ -33,9 +33,15 @@ protected:
    bool m_bTrain ; // the system runs either at training mode or decoding mode
    std::string m_sFeatureDB;
 
+   // the beam used when decoding; a width of zero is the compiled
+   // agenda size, and states that trail the best state of a step by
+   // more than a nonzero margin are dropped
+   unsigned m_nBeamWidth;
+   conparser::SCORE_TYPE m_nBeamMargin;
+
 public:
    // constructor and destructor
-   CConParserBase( std::string sFeatureDBPath , bool bTrain ) : m_bTrain(bTrain), m_sFeatureDB(sFeatureDBPath) { 
+   CConParserBase( std::string sFeatureDBPath , bool bTrain ) : m_bTrain(bTrain), m_sFeatureDB(sFeatureDBPath), m_nBeamWidth(0), m_nBeamMargin(0) { 
       // do nothing
    }
    virtual ~CConParserBase() {
@@ -52,6 +58,10 @@ public:
 
    virtual void finishtraining() = 0 ;  
 
+   virtual void setBeam( const unsigned &nWidth , const conparser::SCORE_TYPE &nMargin ) {
+      THROW("conparser_base.h: the method setBeam is not implemented");
+   }
+
 };
 
 }; // namespace TARGET_LANGUAGE
@@ -11,6 +11,7 @@
 
 #include "conparser.h"
 #include "weight.h"
+#include "profile.h"
 
 using namespace TARGET_LANGUAGE;
 using namespace TARGET_LANGUAGE::conparser;
@@ -947,6 +948,8 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
    static CStateItem lattice[(MAX_SENTENCE_SIZE*(2+UNARY_MOVES)+2)*(AGENDA_SIZE+1)];
    static CStateItem *lattice_index[MAX_SENTENCE_SIZE*(2+UNARY_MOVES)+2];
 
+   PROFILE_PHASE(kDecode);
+   PROFILE_COUNT(kSentences, 1);
 #ifdef DEBUG
    clock_t total_start_time = clock();
 #endif
@@ -1002,6 +1005,10 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
    }
    index=0;
 
+   // the beam asked for when decoding
+   beam.clear();
+   beam.setWidth((bTrain || m_nBeamWidth == 0) ? AGENDA_SIZE : m_nBeamWidth);
+
    TRACE("Decoding start ... ") ;
    while (true) { // for each step
 
@@ -1030,6 +1037,7 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
 #endif
 
          // load context
+         PROFILE_PHASE(kScore);
          m_Context.load(pGenerator, m_lCache, m_lWordLen, false);
 
          // get actions
@@ -1037,7 +1045,9 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
 
          if (actions.size() > 0)
             getOrUpdateStackScore(static_cast<CWeight*>(m_weights), packedscores, pGenerator);
+         PROFILE_STOP(kScore);
 
+         PROFILE_PHASE(kBeam);
          for (tmp_j=0; tmp_j<actions.size(); ++tmp_j) {
             scored_action.load(actions[tmp_j], pGenerator, packedscores[actions[tmp_j].code()]);
             beam.insertItem(&scored_action);
@@ -1048,10 +1058,14 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
          }
       } // done iterating generator item
 
+      if (!bTrain && m_nBeamMargin > 0)
+         beam.prune(m_nBeamMargin);
+
 #ifdef SCALE
       bAllTerminated = true;
 #endif
       // insertItems
+      PROFILE_PHASE(kMove);
       for (tmp_j=0; tmp_j<beam.size(); ++tmp_j) { // insert from
          pGenerator = beam.item(tmp_j)->item;
          pGenerator->Move(lattice_index[index+1], beam.item(tmp_j)->action);
@@ -1075,6 +1089,7 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
          }
          ++lattice_index[index+1];
       }
+      PROFILE_STOP(kMove);
 
 #ifdef SCALE
       if (bAllTerminated)
@@ -1151,6 +1166,7 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
       return;
 
    TRACE("Outputing sentence");
+   PROFILE_PHASE(kOutput);
    pBestGen->GenerateTree( sentence, retval[0] );
    if (pBestGen)
      best_score = pBestGen->score;
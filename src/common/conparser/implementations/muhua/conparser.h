@@ -143,6 +143,12 @@ public:
 
 public:
    void parse( const CTwoStringVector &sentence , CSentenceParsed *retval , int nBest=1 , conparser::SCORE_TYPE *scores=0 ) ;
+   void setBeam( const unsigned &nWidth , const conparser::SCORE_TYPE &nMargin ) {
+      ASSERT(nWidth <= conparser::AGENDA_SIZE, "The beam width can not be larger than the agenda size " << conparser::AGENDA_SIZE);
+      ASSERT(nMargin >= 0, "The beam margin can not be negative");
+      m_nBeamWidth = nWidth;
+      m_nBeamMargin = nMargin;
+   }
    void parse( const CSentenceMultiCon<CConstituent> &sentence , CSentenceParsed *retval , int nBest=1 , conparser::SCORE_TYPE *scores=0 ) ;
    void train( const CSentenceParsed &correct , int round ) ;
    void train( const CSentenceMultiCon<CConstituent> &con_input, const CSentenceParsed &correct , int round ) ;
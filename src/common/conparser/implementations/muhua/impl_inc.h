@@ -31,7 +31,12 @@ typedef CTemporary<CConstituentLabel> CConstituent;
 #include "learning/perceptron/score.h"
 #include "learning/perceptron/hashmap_score_packed.h"
 
+#ifdef FINGERPRINT_FEATURES
+#include "learning/perceptron/hashmap_score_fingerprint.h"
+#define CScoreMapType CFingerprintScoreMap
+#else
 #define CScoreMapType CPackedScoreMap
+#endif
 
 typedef CBigram< CTaggedWord<TARGET_LANGUAGE::CTag, TARGET_LANGUAGE::TAG_SEPARATOR> > CTwoTaggedWords; 
 
@@ -452,6 +452,10 @@ typedef CScoreMapType<CTuple2<CWord, CTag>, SCORE_TYPE, CAction::MAX> CWordTagMa
 class CWeight : public CWeightBase {
 
 public:
+#ifdef FINGERPRINT_FEATURES
+   // the scores of all the templates, which must be constructed first
+   CFingerprintScoreTable<SCORE_TYPE, CAction::MAX> m_table;
+#endif
 
    // S0
    CConstituentMap m_mapS0c;
@@ -925,7 +929,11 @@ TABLE_SIZE),
 
                           m_mapA1("PreviousAction", TABLE_SIZE),
                           m_mapA1A2("PreviousActionBigram", TABLE_SIZE)
-   { }
+   {
+#ifdef FINGERPRINT_FEATURES
+      iterate_templates(,.attach(m_table););
+#endif
+   }
    ~CWeight() {
 //      iterate_templates(,.freePoolMemory(););
 //      CPackedScore<SCORE_TYPE, CAction::MAX>::freePoolMemory();
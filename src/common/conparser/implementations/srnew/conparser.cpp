@@ -633,6 +633,10 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
    }
    index=0;
 
+   // the beam asked for when decoding
+   beam.clear();
+   beam.setWidth((bTrain || m_nBeamWidth == 0) ? AGENDA_SIZE : m_nBeamWidth);
+
    TRACE("Decoding start ... ") ;
    while (true) { // for each step
 
@@ -682,6 +686,9 @@ void CConParser::work( const bool bTrain , const CTwoStringVector &sentence , CS
 
       } // done iterating generator item
 
+      if (!bTrain && m_nBeamMargin > 0)
+         beam.prune(m_nBeamMargin);
+
       // insertItems
       for (tmp_j=0; tmp_j<beam.size(); ++tmp_j) { // insert from
          pGenerator = beam.item(tmp_j)->item;
@@ -28,13 +28,16 @@ const char cInputFormat,
 #ifdef CONLL_OUTPUT
 const char cOutputFormat,
 #endif
-int nBest, const bool bScores, const bool bBinary) {
+int nBest, const bool bScores, const bool bBinary, const unsigned &nBeamWidth, const conparser::SCORE_TYPE &nBeamMargin) {
 
    std::cerr << "Parsing started" << std::endl;
 
    int time_start = clock();
 
    CConParser parser(sFeatureFile, false) ;
+   // the compiled beam unless asked otherwise
+   if (nBeamWidth != 0 || nBeamMargin != 0)
+      parser.setBeam(nBeamWidth, nBeamMargin);
    CSentenceReader *input_reader=0;
    std::ifstream *is=0;
    if (cInputFormat=='c')
@@ -122,7 +125,9 @@ int nBest, const bool bScores, const bool bBinary) {
       delete []scores;
    }
 
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   const double dTime = double(clock()-time_start)/CLOCKS_PER_SEC;
+   std::cerr << "Parsing has finished successfully. Total time taken is: " << dTime << std::endl;
+   std::cerr << "Sentences per second: " << (dTime > 0 ? nCount/dTime : 0) << std::endl;
 }
 
 /*===============================================================
@@ -139,6 +144,8 @@ int main(int argc, char* argv[]) {
       configurations.defineConfiguration("b", "", "output binarized parse trees", "");
       configurations.defineConfiguration("n", "N", "N best list output", "1");
       configurations.defineConfiguration("s", "", "output scores to output_file.scores", "");
+      configurations.defineConfiguration("w", "N", "beam width, no larger than the compiled agenda size (0 for the agenda size)", "0");
+      configurations.defineConfiguration("m", "M", "drop the states that trail the best one by more than M (0 for none)", "0");
 #ifdef CONLL_OUTPUT
       configurations.defineConfiguration("o", "b/c/a", "output format: b - bracked sentence; c - conll dependencies; a - both", "b");
 #endif
@@ -158,6 +165,16 @@ int main(int argc, char* argv[]) {
       bool bScores = configurations.getConfiguration("s").empty() ? false : true;
       bool bBinary = configurations.getConfiguration("b").empty() ? false : true;
       char cInputFormat = configurations.getConfiguration("i") == "c" ? 'c' : 'r';
+      unsigned nBeamWidth = 0;
+      if (!fromString(nBeamWidth, configurations.getConfiguration("w"))) {
+         std::cout << "The beam width must be an integer." << std::endl;
+         return 1;
+      }
+      conparser::SCORE_TYPE nBeamMargin = 0;
+      if (!fromString(nBeamMargin, configurations.getConfiguration("m")) || nBeamMargin < 0) {
+         std::cout << "The beam margin must be a non-negative number." << std::endl;
+         return 1;
+      }
 #ifdef CONLL_OUTPUT
       char cOutputFormat = configurations.getConfiguration("o").at(0);
 #endif
@@ -166,7 +183,7 @@ int main(int argc, char* argv[]) {
 #ifdef CONLL_OUTPUT
               cOutputFormat,
 #endif
-              nBest, bScores, bBinary);
+              nBest, bScores, bBinary, nBeamWidth, nBeamMargin);
    }
    catch (const std::string &e) {
       std::cerr << "Error: " << e << std::endl;
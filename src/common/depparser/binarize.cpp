@@ -0,0 +1,174 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * binarize.cpp - convert a model into the binary model format. *
+ *                                                              *
+ * Binary models are memory mapped by the decoder, and can only *
+ * be used for decoding. Only the non zero averaged scores are  *
+ * kept, and they can be quantized to 16 or 8 bits to make the  *
+ * deployed model smaller still.                                *
+ *                                                              *
+ * The memory of both models is reported: the resident memory   *
+ * of the loaded model, and the size of the binary model, which *
+ * bounds the pages it maps and shares between processes. Given *
+ * a reference file, both models also parse it and the          *
+ * accuracies are compared, so that the loss from quantization  *
+ * can be checked before deployment. The sentences that the     *
+ * models parse differently are counted, and a binary model     *
+ * that is not quantized must parse all of them the same.       *
+ *                                                              *
+ ****************************************************************/
+
+#include "definitions.h"
+#include "depparser.h"
+
+using namespace TARGET_LANGUAGE;
+
+/*---------------------------------------------------------------
+ *
+ * CEvaluation - the result of parsing the reference with a model
+ *
+ *--------------------------------------------------------------*/
+
+struct CEvaluation {
+   unsigned long words;
+   unsigned long heads;
+   unsigned long labels;
+};
+
+/*---------------------------------------------------------------
+ *
+ * residentMemory - the resident set size of the process in bytes
+ *
+ *--------------------------------------------------------------*/
+
+unsigned long residentMemory() {
+   std::ifstream file("/proc/self/statm");
+   unsigned long size, resident;
+   if (!(file >> size >> resident))
+      return 0;
+   return resident * sysconf(_SC_PAGESIZE);
+}
+
+unsigned long fileSize(const std::string &sPath) {
+   std::ifstream file(sPath.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
+   return file.is_open() ? static_cast<unsigned long>(file.tellg()) : 0;
+}
+
+/*---------------------------------------------------------------
+ *
+ * evaluate - parse the reference with a model
+ *
+ *--------------------------------------------------------------*/
+
+void evaluate(const std::string &sModel, const std::vector<CDependencyParse> &reference, CEvaluation &result, std::vector<CDependencyParse> &outputs) {
+   CDepParser parser(sModel, false);
+   CTwoStringVector input;
+   result.words = result.heads = result.labels = 0;
+   outputs.resize(reference.size());
+   for (unsigned long i=0; i<reference.size(); ++i) {
+      CDependencyParse &output = outputs[i];
+      UnparseSentence(&reference[i], &input);
+      parser.parse(input, &output);
+      ASSERT(output.size()==reference[i].size(), "The parser output for sentence " << i+1 << " does not match the reference");
+      for (unsigned long j=0; j<output.size(); ++j) {
+         ++result.words;
+         if (output[j].head == reference[i][j].head) {
+            ++result.heads;
+#ifdef LABELED
+            if (output[j].label == reference[i][j].label)
+               ++result.labels;
+#endif
+         }
+      }
+   }
+}
+
+void report(const std::string &sName, const unsigned long &memory, const CEvaluation &result) {
+   std::cout << sName << "\t" << memory/1024 << "K";
+   if (result.words) {
+      std::cout << "\tUAS " << 100.0*result.heads/result.words << "%";
+#ifdef LABELED
+      std::cout << "\tLAS " << 100.0*result.labels/result.words << "%";
+#endif
+   }
+   std::cout << std::endl;
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char* argv[]) {
+   try {
+      COptions options(argc, argv);
+      CConfigurations configurations;
+      configurations.defineConfiguration("q", "bits", "quantize the scores to 16 or 8 bits", "0");
+      configurations.defineConfiguration("r", "path", "compare the accuracy of both models on the reference", "");
+      if (options.args.size() != 3) {
+         std::cout << "Usage: " << argv[0] << " model_file binary_model_file" << std::endl;
+         std::cout << configurations.message() << std::endl;
+         return 1;
+      }
+      configurations.loadConfigurations(options.opts);
+
+      unsigned nValueBits = 0;
+      if (!fromString(nValueBits, configurations.getConfiguration("q")) || !binaryValueBitsValid(nValueBits)) {
+         std::cout << "The quantization must be 16 or 8 bits." << std::endl;
+         return 1;
+      }
+      const std::string sReference = configurations.getConfiguration("r");
+
+      ASSERT(!CBinaryModelReader::detect(options.args[1]), "The model " << options.args[1] << " is already binary");
+      // the model is measured as it is loaded, since the heap it frees
+      // would flatter any later measurement
+      unsigned long memory;
+      {
+         const unsigned long before = residentMemory();
+         depparser::CWeight weights(options.args[1], false);
+         const unsigned long after = residentMemory();
+         memory = after > before ? after - before : 0;
+         weights.saveBinaryScores(options.args[2], nValueBits);
+      }
+
+      CEvaluation text, binary;
+      text.words = binary.words = 0;
+      unsigned long differences = 0;
+      if (!sReference.empty()) {
+         std::ifstream is(sReference.c_str());
+         ASSERT(is.is_open(), "Cannot open the reference " << sReference);
+         std::vector<CDependencyParse> reference;
+         CDependencyParse ref_sent;
+         while (is >> ref_sent) {
+            if (ref_sent.size() > depparser::MAX_SENTENCE_SIZE) {
+               WARNING("The sentence is longer than system limitation, skipping it.");
+            }
+            else {
+               reference.push_back(ref_sent);
+            }
+         }
+         std::vector<CDependencyParse> text_outputs, binary_outputs;
+         evaluate(options.args[1], reference, text, text_outputs);
+         evaluate(options.args[2], reference, binary, binary_outputs);
+         for (unsigned long i=0; i<reference.size(); ++i)
+            if (!(text_outputs[i] == binary_outputs[i]))
+               ++differences;
+         ASSERT(nValueBits || differences == 0, "The binary model parses " << differences << " of " << reference.size() << " sentences differently from the model");
+      }
+      report("model resident", memory, text);
+      report("binary file   ", fileSize(options.args[2]), binary);
+      if (text.words) {
+         std::cout << "delta\t\t\tUAS " << 100.0*(double(binary.heads)-double(text.heads))/text.words << "%";
+#ifdef LABELED
+         std::cout << "\tLAS " << 100.0*(double(binary.labels)-double(text.labels))/text.words << "%";
+#endif
+         std::cout << "\t" << differences << " sentences parsed differently" << std::endl;
+      }
+      return 0;
+   } catch (const std::string &e) {
+      std::cerr << "Error: " << e << std::endl;
+      return 1;
+   }
+}
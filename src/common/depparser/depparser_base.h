@@ -29,15 +29,23 @@ class CDepParserBase {
 protected:
 
    depparser::CWeightBase *m_weights;
+   bool m_bSharedWeights ; // the weights belong to another parser
 
    bool m_bTrain ; // the system runs either at training mode or decoding mode
    bool m_bCoNLL ;
 
    const depparser::CSuperTag *m_supertags;
 
+   // the beam used when decoding; a width of zero is the compiled
+   // agenda size, and states that trail the best state of a round by
+   // more than a nonzero margin are dropped, so that the beam of each
+   // round is as wide as the scores make it worth
+   unsigned m_nBeamWidth;
+   depparser::SCORE_TYPE m_nBeamMargin;
+
 public:
    // constructor and destructor
-   CDepParserBase( std::string sFeatureDBPath , bool bTrain , bool bCoNLL ) : m_bTrain(bTrain) , m_bCoNLL(bCoNLL) , m_supertags(0) { 
+   CDepParserBase( std::string sFeatureDBPath , bool bTrain , bool bCoNLL ) : m_bTrain(bTrain) , m_bCoNLL(bCoNLL) , m_supertags(0) , m_bSharedWeights(false) , m_nBeamWidth(0) , m_nBeamMargin(0) { 
       // do nothing
    }
    virtual ~CDepParserBase() {
@@ -57,6 +65,12 @@ public:
       // set supertags before parsing
       m_supertags = supertags;
    }
+   virtual void setBeam(const unsigned &nWidth, const depparser::SCORE_TYPE &nMargin) {
+      THROW("depparser_base.h: the method setBeam is not implemented");
+   }
+   // a hint that sentences of up to nLength words follow, so that the
+   // states can be allocated once for all of them
+   virtual void reserve(const unsigned &nLength) { }
 
 public:
 
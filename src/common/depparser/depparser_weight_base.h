@@ -11,6 +11,7 @@
 #define _DEPPARSER_WEIGHTS_BASE_H
 
 #include "depparser_base_include.h"
+#include "learning/perceptron/score_binary.h"
 
 namespace TARGET_LANGUAGE {
 namespace depparser {
@@ -30,10 +31,16 @@ protected:
 
    bool m_bRules;
 
+   CBinaryModelReader *m_binary;
+
+public:
+   // binary model flags
+   enum { BINARY_RULES = 1 };
+
 public:
    // CONSTRUCTOR 
-   CWeightBase(const std::string &sFile, bool bTrain) : m_bTrain(bTrain) , m_sRecordPath(sFile) , m_bRules(false) { }
-   virtual ~CWeightBase() { }
+   CWeightBase(const std::string &sFile, bool bTrain) : m_bTrain(bTrain) , m_sRecordPath(sFile) , m_bRules(false) , m_binary(0) { }
+   virtual ~CWeightBase() { delete m_binary; }
 
    void setRules(const bool &bRules) {
       TRACE("Rules set to " << (bRules ? "true" : "false"));
@@ -46,6 +53,45 @@ public:
    virtual void loadScores() = 0 ;
    virtual void saveScores() = 0 ; 
 
+protected:
+   // the word dictionary, tags and labels of a binary model, followed by the score maps
+   void saveBinaryHeader(CBinaryModelWriter<SCORE_TYPE> &model) {
+      std::vector<std::string> list(1); // word code 0 is unknown
+      const CWord word;
+      for (unsigned long i=CWord::EMPTY; i<word.dictionarySize(); ++i)
+         list.push_back(CWord(i).str());
+      model.addList(list);
+      list.clear();
+      for (unsigned long i=CTag::FIRST; i<CTag::COUNT; ++i)
+         list.push_back(CTag(i).str());
+      model.addList(list);
+      list.clear();
+#ifdef LABELED
+      for (unsigned long i=CDependencyLabel::FIRST; i<CDependencyLabel::COUNT; ++i)
+         list.push_back(CDependencyLabel(i).str());
+#endif
+      model.addList(list);
+      model.setFlags(m_bRules ? BINARY_RULES : 0);
+   }
+
+   // maps the binary model and translates its words into the codes of this process
+   void loadBinaryHeader() {
+      ASSERT(!m_bTrain, "Binary models can only be used for decoding");
+      m_binary = new CBinaryModelReader(m_sRecordPath);
+      const std::vector<std::string> &words = m_binary->list(0);
+      for (unsigned long i=CWord::EMPTY; i<words.size(); ++i)
+         m_binary->dictionary().add(CWord(words[i]).code(), i);
+      const std::vector<std::string> &tags = m_binary->list(1);
+      for (unsigned long i=0; i<tags.size(); ++i)
+         ASSERT(CTag(tags[i]).code()==CTag::FIRST+i, "The POS tag " << tags[i] << " in the binary model does not match the tag set");
+#ifdef LABELED
+      const std::vector<std::string> &labels = m_binary->list(2);
+      for (unsigned long i=0; i<labels.size(); ++i)
+         ASSERT(CDependencyLabel(labels[i]).code()==CDependencyLabel::FIRST+i, "The dependency label " << labels[i] << " in the binary model does not match the label set");
+#endif
+      setRules(m_binary->flags() & BINARY_RULES);
+   }
+
 };
 
 };
@@ -45,17 +45,5 @@ static unsigned getLabel(const unsigned &action) {
 }
 #endif
 
-struct CScoredAction {
-   unsigned action;
-   SCORE_TYPE score;
-public:
-   bool operator < (const CScoredAction &a) const {
-      return score < a.score;
-   }
-   bool operator > (const CScoredAction &a) const {
-      return score > a.score;
-   }
-};
-
 }//namespace
 #endif
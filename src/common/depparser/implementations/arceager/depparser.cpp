@@ -11,6 +11,7 @@
 
 #include "depparser.h"
 #include "depparser_weight.h"
+#include "profile.h"
 
 using namespace TARGET_LANGUAGE;
 using namespace TARGET_LANGUAGE::depparser;
@@ -51,12 +52,9 @@ inline void CDepParser::getOrUpdateStackScore( const CStateItem *item, CPackedSc
    const int &n0l2d_index = n0ld_index==-1 ? -1 : item->sibling(n0ld_index); // leftmost dep of next
    const int &ht_index = item->headstackempty() ? -1 : item->headstacktop(); // headstack
    const int &ht2_index = item->headstacksize()<2 ? -1 : item->headstackitem(item->headstacksize()-2); // headstack 2nd
-   static int n1_index;
-   static int n2_index;
-   static int n3_index;
-   n1_index = (n0_index != -1 && n0_index+1<m_lCache.size()) ? n0_index+1 : -1 ;
-   n2_index = (n0_index != -1 && n0_index+2<m_lCache.size()) ? n0_index+2 : -1 ;
-   n3_index = (n0_index != -1 && n0_index+3<m_lCache.size()) ? n0_index+3 : -1 ;
+   const int n1_index = (n0_index != -1 && n0_index+1<m_lCache.size()) ? n0_index+1 : -1 ;
+   const int n2_index = (n0_index != -1 && n0_index+2<m_lCache.size()) ? n0_index+2 : -1 ;
+   const int n3_index = (n0_index != -1 && n0_index+3<m_lCache.size()) ? n0_index+3 : -1 ;
 
    const CTaggedWord<CTag, TAG_SEPARATOR> &st_word_tag = st_index==-1 ? g_emptyTaggedWord : m_lCache[st_index];
    const CTaggedWord<CTag, TAG_SEPARATOR> &sth_word_tag = sth_index==-1 ? g_emptyTaggedWord : m_lCache[sth_index];
@@ -112,8 +110,7 @@ inline void CDepParser::getOrUpdateStackScore( const CStateItem *item, CPackedSc
    const int &n0ld_label = n0ld_index==-1 ? CDependencyLabel::NONE : item->label(n0ld_index);
    const int &n0l2d_label = n0l2d_index==-1 ? CDependencyLabel::NONE : item->label(n0l2d_index);
 
-   static int st_n0_dist;
-   st_n0_dist = encodeLinkDistance(st_index, n0_index);
+   const int st_n0_dist = encodeLinkDistance(st_index, n0_index);
 
    const int st_rarity = st_index==-1?0:item->rightarity(st_index);
    const int st_larity = st_index==-1?0:item->leftarity(st_index);
@@ -123,8 +120,8 @@ inline void CDepParser::getOrUpdateStackScore( const CStateItem *item, CPackedSc
    const CSetOfTags<CDependencyLabel> &st_ltagset = st_index==-1?CSetOfTags<CDependencyLabel>():item->lefttagset(st_index);
    const CSetOfTags<CDependencyLabel> &n0_ltagset = n0_index==-1?CSetOfTags<CDependencyLabel>():item->lefttagset(n0_index);
 
-   static CTwoTaggedWords st_word_tag_n0_word_tag ;
-   static CTwoWords st_word_n0_word ;
+   CTwoTaggedWords st_word_tag_n0_word_tag ;
+   CTwoWords st_word_n0_word ;
    if ( amount == 0 ) {
       st_word_tag_n0_word_tag.refer( &st_word_tag, &n0_word_tag );
       st_word_n0_word.refer( &st_word, &n0_word );
@@ -134,15 +131,15 @@ inline void CDepParser::getOrUpdateStackScore( const CStateItem *item, CPackedSc
       st_word_n0_word.allocate( st_word, n0_word );
    }
 
-   static CTuple2<CWord, CTag> word_tag;
-   static CTuple2<CWord, int> word_int;
-   static CTuple2<CTag, int> tag_int;
-   static CTuple3<CWord, CTag, CTag> word_tag_tag;
-   static CTuple3<CWord, CWord, CTag> word_word_tag;
-   static CTuple3<CWord, CWord, int> word_word_int;
-   static CTuple3<CTag, CTag, int> tag_tag_int;
-   static CTuple2<CWord, CSetOfTags<CDependencyLabel> > word_tagset;
-   static CTuple2<CTag, CSetOfTags<CDependencyLabel> > tag_tagset;
+   CTuple2<CWord, CTag> word_tag;
+   CTuple2<CWord, int> word_int;
+   CTuple2<CTag, int> tag_int;
+   CTuple3<CWord, CTag, CTag> word_tag_tag;
+   CTuple3<CWord, CWord, CTag> word_word_tag;
+   CTuple3<CWord, CWord, int> word_word_int;
+   CTuple3<CTag, CTag, int> tag_tag_int;
+   CTuple2<CWord, CSetOfTags<CDependencyLabel> > word_tagset;
+   CTuple2<CTag, CSetOfTags<CDependencyLabel> > tag_tagset;
 
    // single
    if (st_index != -1) {
@@ -307,7 +304,7 @@ inline void CDepParser::getOrUpdateStackScore( const CStateItem *item, CPackedSc
 
    if (m_bCoNLL) {
 
-      static unsigned i;
+      unsigned i;
 
       if (st_index!=-1) {
          if (!m_lCacheCoNLLLemma[st_index].empty()) cast_weights->m_mapSTl.getOrUpdateScore( retval, m_lCacheCoNLLLemma[st_index], action, m_nScoreIndex, amount, round) ;
@@ -367,9 +364,9 @@ void CDepParser::updateScores(const CDependencyParse & parsed , const CDependenc
  *--------------------------------------------------------------*/
 
 inline void CDepParser::updateScoreForState( const CStateItem &from, const CStateItem *output , const SCORE_TYPE &amount ) {
-   static CStateItem item(&m_lCache);
-   static unsigned action;
-   static CPackedScoreType<SCORE_TYPE, action::MAX> empty;
+   CStateItem item(&m_lCache);
+   unsigned action;
+   CPackedScoreType<SCORE_TYPE, action::MAX> empty;
    item = from;
    while ( item != *output ) {
       action = item.FollowMove( output );
@@ -391,8 +388,8 @@ inline void CDepParser::updateScoreForState( const CStateItem &from, const CStat
 void CDepParser::updateScoresForStates( const CStateItem *output , const CStateItem *correct , SCORE_TYPE amount_add, SCORE_TYPE amount_subtract ) {
 
    // do not update those steps where they are correct
-   static CStateItem item(&m_lCache);
-   static unsigned action, correct_action;
+   CStateItem item(&m_lCache);
+   unsigned action, correct_action;
    item.clear();
    while ( item != *output ) {
       action = item.FollowMove( output );
@@ -416,11 +413,12 @@ void CDepParser::updateScoresForStates( const CStateItem *output , const CStateI
  *--------------------------------------------------------------*/
 
 inline void CDepParser::reduce( const CStateItem *item, const CPackedScoreType<SCORE_TYPE, action::MAX> &scores ) {
-   static action::CScoredAction scoredaction;
+   CScoredTransition scoredaction;
+   scoredaction.source = item;
    // update stack score
    scoredaction.action = action::REDUCE;
    scoredaction.score = item->score + scores[scoredaction.action];
-   m_Beam->insertItem(&scoredaction);
+   insertTransition(scoredaction);
 }
 
 /*---------------------------------------------------------------
@@ -430,21 +428,22 @@ inline void CDepParser::reduce( const CStateItem *item, const CPackedScoreType<S
  *--------------------------------------------------------------*/
 
 inline void CDepParser::arcleft( const CStateItem *item, const CPackedScoreType<SCORE_TYPE, action::MAX> &scores ) {
-   static action::CScoredAction scoredaction;
-   static unsigned label;
+   CScoredTransition scoredaction;
+   scoredaction.source = item;
+   unsigned label;
 #ifdef LABELED
    for (label=CDependencyLabel::FIRST; label<CDependencyLabel::COUNT; ++label) {
       if ( !m_weights->rules() || canAssignLabel(m_lCache, item->size(), item->stacktop(), label) ) {
          scoredaction.action = action::encodeAction(action::ARC_LEFT, label);
          scoredaction.score = item->score + scores[scoredaction.action];
                                //+scores[action::ARC_LEFT];
-         m_Beam->insertItem(&scoredaction);
+         insertTransition(scoredaction);
       }
    }
 #else
    scoredaction.action = action::ARC_LEFT;
    scoredaction.score = item->score + scores[scoredaction.action];
-      m_Beam->insertItem(&scoredaction);
+      insertTransition(scoredaction);
 #endif
 }
 
@@ -455,21 +454,22 @@ inline void CDepParser::arcleft( const CStateItem *item, const CPackedScoreType<
  *--------------------------------------------------------------*/
 
 inline void CDepParser::arcright( const CStateItem *item, const CPackedScoreType<SCORE_TYPE, action::MAX> &scores ) {
-   static action::CScoredAction scoredaction;
-   static unsigned label;
+   CScoredTransition scoredaction;
+   scoredaction.source = item;
+   unsigned label;
 #ifdef LABELED
    for (label=CDependencyLabel::FIRST; label<CDependencyLabel::COUNT; ++label) {
       if ( !m_weights->rules() || canAssignLabel(m_lCache, item->stacktop(), item->size(), label) ) {
          scoredaction.action = action::encodeAction(action::ARC_RIGHT, label);
          scoredaction.score = item->score + scores[scoredaction.action];
                               //+scores[action::ARC_RIGHT];
-         m_Beam->insertItem(&scoredaction);
+         insertTransition(scoredaction);
       }
    }
 #else
    scoredaction.action = action::ARC_RIGHT;
    scoredaction.score = item->score + scores[scoredaction.action];
-   m_Beam->insertItem(&scoredaction);
+   insertTransition(scoredaction);
 #endif
 }
 
@@ -480,11 +480,12 @@ inline void CDepParser::arcright( const CStateItem *item, const CPackedScoreType
  *--------------------------------------------------------------*/
 
 inline void CDepParser::shift( const CStateItem *item, const CPackedScoreType<SCORE_TYPE, action::MAX> &scores ) {
-   static action::CScoredAction scoredaction;
+   CScoredTransition scoredaction;
+   scoredaction.source = item;
    // update stack score
    scoredaction.action = action::SHIFT;
    scoredaction.score = item->score + scores[scoredaction.action];
-   m_Beam->insertItem(&scoredaction);
+   insertTransition(scoredaction);
 }
 
 /*---------------------------------------------------------------
@@ -494,11 +495,12 @@ inline void CDepParser::shift( const CStateItem *item, const CPackedScoreType<SC
  *--------------------------------------------------------------*/
 
 inline void CDepParser::poproot( const CStateItem *item, const CPackedScoreType<SCORE_TYPE, action::MAX> &scores ) {
-   static action::CScoredAction scoredaction;
+   CScoredTransition scoredaction;
+   scoredaction.source = item;
    // update stack score
    scoredaction.action = action::POP_ROOT;
    scoredaction.score = item->score + scores[scoredaction.action];
-   m_Beam->insertItem(&scoredaction);
+   insertTransition(scoredaction);
 }
 
 
@@ -512,22 +514,23 @@ inline void CDepParser::poproot( const CStateItem *item, const CPackedScoreType<
 
 void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CDependencyParse *retval , const CDependencyParse &correct , int nBest , SCORE_TYPE *scores ) {
 
+   PROFILE_PHASE(kDecode);
+   PROFILE_COUNT(kSentences, 1);
 #ifdef DEBUG
    clock_t total_start_time = clock();
 #endif
-   static int index;
+   int index;
    const int length = sentence.size() ;
 
    const CStateItem *pGenerator ;
-   static CStateItem pCandidate(&m_lCache) ;
+   CStateItem &pCandidate = m_Candidate ;
+   CStateItem *pTarget ;
 
    // used only for training
-   static bool bCorrect ;  // used in learning for early update
-   static bool bContradictsRules;
-   static CStateItem correctState(&m_lCache) ;
-   static CPackedScoreType<SCORE_TYPE, action::MAX> packed_scores;
-
-   ASSERT(length<MAX_SENTENCE_SIZE, "The size of the sentence is larger than the system configuration.");
+   bool bCorrect ;  // used in learning for early update
+   bool bContradictsRules;
+   CStateItem &correctState = m_CorrectState ;
+   CPackedScoreType<SCORE_TYPE, action::MAX> &packed_scores = m_PackedScores;
 
    TRACE("Initialising the decoding process...") ;
    // initialise word cache
@@ -555,8 +558,14 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
       }
    }
 
-   // initialise agenda
+   // initialise agenda, with the beam asked for when decoding
    m_Agenda->clear();
+   m_Beam->clear();
+   const int nWidth = (bTrain || m_nBeamWidth == 0) ? AGENDA_SIZE : m_nBeamWidth;
+   const bool bPrune = !bTrain && m_nBeamMargin > 0;
+   m_Agenda->setWidth(nWidth);
+   m_Beam->setWidth(nWidth);
+   m_bTraining = bTrain;
    pCandidate.clear();                          // restore state using clean
    m_Agenda->pushCandidate(&pCandidate);           // and push it back
    m_Agenda->nextRound();                       // as the generator item
@@ -600,13 +609,17 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
       }
 
       pGenerator = m_Agenda->generatorStart();
+      m_Beam->clear();
       // iterate generators
       for (int j=0; j<m_Agenda->generatorSize(); ++j) {
 
          // for the state items that already contain all words
-         m_Beam->clear();
+         m_GeneratorBeam->clear();
          packed_scores.reset();
+         PROFILE_PHASE(kScore);
          getOrUpdateStackScore( pGenerator, packed_scores, action::NO_ACTION );
+         PROFILE_STOP(kScore);
+         PROFILE_PHASE(kBeam);
          if ( pGenerator->size() == length ) {
             assert( pGenerator->stacksize() != 0 );
             if ( pGenerator->stacksize()>1 ) {
@@ -661,12 +674,19 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
             }
          }
 
-         // insert item
-         for (unsigned i=0; i<m_Beam->size(); ++i) {
-            pCandidate = *pGenerator;
-            pCandidate.score = m_Beam->item(i)->score;
-            pCandidate.Move( m_Beam->item(i)->action );
-            m_Agenda->pushCandidate(&pCandidate);
+         PROFILE_STOP(kBeam);
+
+         if (bTrain) {
+            for (int i=0; i<m_GeneratorBeam->size(); ++i) {
+               PROFILE_PHASE(kMove);
+               pCandidate = *pGenerator;
+               pCandidate.score = m_GeneratorBeam->item(i)->score;
+               pCandidate.Move( m_GeneratorBeam->item(i)->action );
+               PROFILE_STOP(kMove);
+               PROFILE_PHASE(kBeam);
+               m_Agenda->pushCandidate(&pCandidate);
+               PROFILE_STOP(kBeam);
+            }
          }
 
          if (bTrain && *pGenerator == correctState) {
@@ -675,12 +695,34 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
          pGenerator = m_Agenda->generatorNext() ;
 
       }
+
+      // in decoding, the actions of all the generators compete for the
+      // beam, and only the ones that are kept are made into states, in place
+      if (!bTrain) {
+         PROFILE_PHASE(kBeam);
+         if (bPrune) m_Beam->prune(m_nBeamMargin);
+         m_Beam->sortItems();
+         PROFILE_STOP(kBeam);
+         for (int i=0; i<m_Beam->size(); ++i) {
+            const CScoredTransition &transition = *(m_Beam->item(i));
+            PROFILE_PHASE(kMove);
+            pTarget = m_Agenda->candidateItem();
+            *pTarget = *(transition.source);
+            pTarget->score = transition.score;
+            pTarget->Move( transition.action );
+            PROFILE_STOP(kMove);
+            PROFILE_PHASE(kBeam);
+            m_Agenda->pushCandidate();
+            PROFILE_STOP(kBeam);
+         }
+      }
+
       // when we are doing training, we need to consider the standard move and update
       if (bTrain) {
 #ifdef EARLY_UPDATE
          if (!bCorrect) {
             TRACE("Error at the "<<correctState.size()<<"th word; total is "<<correct.size())
-            updateScoresForStates(m_Agenda->bestGenerator(), &correctState, 1, -1) ;
+            updateScoresForStates(m_Agenda->bestGenerator(), &correctState, m_nUpdateAmount, -m_nUpdateAmount) ;
 #ifndef LOCAL_LEARNING
             return ;
 #else
@@ -710,12 +752,13 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
       // then make sure that the correct item is stack top finally
       if ( *(m_Agenda->bestGenerator()) != correctState ) {
          TRACE("The best item is not the correct one")
-         updateScoresForStates(m_Agenda->bestGenerator(), &correctState, 1, -1) ;
+         updateScoresForStates(m_Agenda->bestGenerator(), &correctState, m_nUpdateAmount, -m_nUpdateAmount) ;
          return ;
       }
    }
 
    TRACE("Outputing sentence");
+   PROFILE_PHASE(kOutput);
    m_Agenda->sortGenerators();
    for (int i=0; i<std::min(m_Agenda->generatorSize(), nBest); ++i) {
       pGenerator = m_Agenda->generator(i) ;
@@ -738,7 +781,7 @@ void CDepParser::work( const bool bTrain , const CTwoStringVector &sentence , CD
 
 void CDepParser::parse( const CTwoStringVector &sentence , CDependencyParse *retval , int nBest , SCORE_TYPE *scores ) {
 
-   static CDependencyParse empty ;
+   const CDependencyParse empty ;
 
    assert( !m_bCoNLL );
 
@@ -760,8 +803,8 @@ void CDepParser::parse( const CTwoStringVector &sentence , CDependencyParse *ret
 
 void CDepParser::train( const CDependencyParse &correct , int round ) {
 
-   static CTwoStringVector sentence ;
-   static CDependencyParse output ;
+   CTwoStringVector sentence ;
+   CDependencyParse output ;
 
    assert( !m_bCoNLL );
 #ifndef FRAGMENTED_TREE
@@ -781,6 +824,36 @@ void CDepParser::train( const CDependencyParse &correct , int round ) {
 
 };
 
+/*---------------------------------------------------------------
+ *
+ * mix - mix the changes of the shards of an epoch of iterative
+ *       parameter mixing into the weights
+ *
+ * The weights were in use for all the rounds of the shards, and
+ * are averaged over them before they are changed.
+ *
+ *---------------------------------------------------------------*/
+
+void CDepParser::mix( const std::vector<CDepParser*> &shards ) {
+
+   ASSERT( m_bTrain && m_nTrainingRound == 0 , "Only the weights of a training parser that has not trained can be mixed" ) ;
+   depparser::CWeight *weights = static_cast<depparser::CWeight*>(m_weights);
+
+   int nRounds = 0;
+   for (unsigned i=0; i<shards.size(); ++i)
+      nRounds += shards[i]->m_nTrainingRound;
+   weights->computeAverageFeatureWeights(nRounds);
+
+   for (unsigned i=0; i<shards.size(); ++i) {
+      ASSERT( shards[i]->m_nUpdateAmount == static_cast<SCORE_TYPE>(shards.size()) , "The shard does not belong to this epoch" ) ;
+      depparser::CWeight *shard_weights = static_cast<depparser::CWeight*>(shards[i]->m_weights);
+      shard_weights->computeAverageFeatureWeights(shards[i]->m_nTrainingRound);
+      weights->mix(*shard_weights, shards.size());
+      m_nTotalErrors += shards[i]->m_nTotalErrors;
+   }
+
+}
+
 /*---------------------------------------------------------------
  *
  * extract_features - extract features from an example (counts recorded to parser model as weights)
@@ -855,9 +928,9 @@ void CDepParser::initCoNLLCache( const CCoNLLInputOrOutput &sentence ) {
 
 void CDepParser::parse_conll( const CCoNLLInput &sentence , CCoNLLOutput *retval , int nBest, SCORE_TYPE *scores ) {
 
-   static CDependencyParse empty ;
-   static CTwoStringVector input ;
-   static CDependencyParse output[AGENDA_SIZE] ;
+   const CDependencyParse empty ;
+   CTwoStringVector input ;
+   CDependencyParse output[AGENDA_SIZE] ;
 
    assert( m_bCoNLL ) ;
 
@@ -890,9 +963,9 @@ void CDepParser::parse_conll( const CCoNLLInput &sentence , CCoNLLOutput *retval
 
 void CDepParser::train_conll( const CCoNLLOutput &correct , int round ) {
 
-   static CTwoStringVector sentence ;
-   static CDependencyParse output ;
-   static CDependencyParse reference ;
+   CTwoStringVector sentence ;
+   CDependencyParse output ;
+   CDependencyParse reference ;
 
    assert( m_bCoNLL ) ;
 
@@ -44,7 +44,9 @@ class CDepParser : public CDepParserBase {
 private:
 
    CAgendaBeam<depparser::CStateItem> *m_Agenda;
-   CAgendaSimple<depparser::action::CScoredAction> *m_Beam;
+   CAgendaSelect<depparser::CScoredTransition> *m_Beam;   // the actions of a round
+   CAgendaSimple<depparser::CScoredTransition> *m_GeneratorBeam;   // the actions of a generator, in training
+   bool m_bTraining;                                       // whether work() is training
 
    // caches for input
    std::vector< CTaggedWord<CTag, TAG_SEPARATOR> > m_lCache;
@@ -60,22 +62,64 @@ private:
    int m_nTotalErrors;
    bool m_bScoreModified;
    int m_nScoreIndex;
+   depparser::SCORE_TYPE m_nUpdateAmount;
+
+   // the working states of the decoder
+   depparser::CStateItem m_Candidate;
+   depparser::CStateItem m_CorrectState;
+   CPackedScoreType<depparser::SCORE_TYPE, depparser::action::MAX> m_PackedScores;
 
 public:
    // constructor and destructor
-   CDepParser( const std::string &sFeatureDBPath , bool bTrain , bool bCoNLL=false ) : CDepParserBase(sFeatureDBPath, bTrain, bCoNLL) {
+   CDepParser( const std::string &sFeatureDBPath , bool bTrain , bool bCoNLL=false ) : CDepParserBase(sFeatureDBPath, bTrain, bCoNLL) , m_Candidate(&m_lCache) , m_CorrectState(&m_lCache) {
       m_Agenda = new CAgendaBeam<depparser::CStateItem>(AGENDA_SIZE);
-      m_Beam = new CAgendaSimple<depparser::action::CScoredAction>(AGENDA_SIZE);
+      m_Beam = new CAgendaSelect<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_GeneratorBeam = new CAgendaSimple<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_bTraining = false;
       m_weights = new depparser :: CWeight(sFeatureDBPath, bTrain );
+      if (!bTrain) static_cast<depparser::CWeight*>(m_weights)->freezeScores();
       m_nTrainingRound = 0;
       m_nTotalErrors = 0;
+      m_nUpdateAmount = 1;
 //      m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eNonAverage ;
       if (bTrain) m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eNonAverage ; else m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eAverage ;
    }
+   // a decoder sharing the weights of a loaded decoder, for parsing in another thread
+   CDepParser( const CDepParser &model , bool bCoNLL ) : CDepParserBase("", false, bCoNLL) , m_Candidate(&m_lCache) , m_CorrectState(&m_lCache) {
+      ASSERT(!model.m_bTrain, "Only the weights of a decoding parser can be shared");
+      m_Agenda = new CAgendaBeam<depparser::CStateItem>(AGENDA_SIZE);
+      m_Beam = new CAgendaSelect<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_GeneratorBeam = new CAgendaSimple<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_bTraining = false;
+      m_weights = model.m_weights;
+      m_bSharedWeights = true;
+      m_nBeamWidth = model.m_nBeamWidth;
+      m_nBeamMargin = model.m_nBeamMargin;
+      m_nTrainingRound = 0;
+      m_nTotalErrors = 0;
+      m_nUpdateAmount = 1;
+      m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eAverage ;
+   }
+   // a parser training on one of nShards shards of the data in iterative parameter
+   // mixing, whose weights hold its changes to the weights of the training model
+   CDepParser( const CDepParser &model , const unsigned &nShards , bool bCoNLL ) : CDepParserBase("", true, bCoNLL) , m_Candidate(&m_lCache) , m_CorrectState(&m_lCache) {
+      ASSERT(model.m_bTrain, "Only the weights of a training parser can be mixed");
+      m_Agenda = new CAgendaBeam<depparser::CStateItem>(AGENDA_SIZE);
+      m_Beam = new CAgendaSelect<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_GeneratorBeam = new CAgendaSimple<depparser::CScoredTransition>(AGENDA_SIZE);
+      m_bTraining = false;
+      m_weights = new depparser :: CWeight("", true);
+      static_cast<depparser::CWeight*>(m_weights)->setBase(*static_cast<const depparser::CWeight*>(model.m_weights));
+      m_nTrainingRound = 0;
+      m_nTotalErrors = 0;
+      m_nUpdateAmount = nShards;
+      m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eNonAverage ;
+   }
    ~CDepParser() {
       delete m_Agenda;
       delete m_Beam;
-      delete m_weights;
+      delete m_GeneratorBeam;
+      if (!m_bSharedWeights) delete m_weights;
    }
    CDepParser( CDepParser &depparser) : CDepParserBase(depparser) {
       assert(1==0);
@@ -83,6 +127,12 @@ public:
 
 public:
    void parse( const CTwoStringVector &sentence , CDependencyParse *retval , int nBest=1 , depparser::SCORE_TYPE *scores=0 ) ;
+   void setBeam( const unsigned &nWidth , const depparser::SCORE_TYPE &nMargin ) {
+      ASSERT(nWidth <= AGENDA_SIZE, "The beam width can not be larger than the agenda size " << AGENDA_SIZE);
+      ASSERT(nMargin >= 0, "The beam margin can not be negative");
+      m_nBeamWidth = nWidth;
+      m_nBeamMargin = nMargin;
+   }
    void train( const CDependencyParse &correct , int round ) ;
    void extract_features( const CDependencyParse &input ) ;
 
@@ -90,6 +140,8 @@ public:
    void train_conll( const CCoNLLOutput &correct , int round ) ;
    void extract_features_conll( const CCoNLLOutput &input ) ;
 
+   void mix( const std::vector<CDepParser*> &shards ) ;
+
    void finishtraining() {
       static_cast<depparser::CWeight*>(m_weights)->computeAverageFeatureWeights(m_nTrainingRound);
       static_cast<depparser::CWeight*>(m_weights)->saveScores();
@@ -113,6 +165,13 @@ private:
    inline void updateScoreForState( const depparser::CStateItem &from, const depparser::CStateItem *output , const depparser::SCORE_TYPE &amount ) ;
 
 
+   // training keeps the actions of each generator apart, and makes
+   // and pushes their states in the order the models were trained in
+   inline void insertTransition( const depparser::CScoredTransition &transition ) {
+      if (m_bTraining) m_GeneratorBeam->insertItem(&transition);
+      else m_Beam->insertItem(&transition);
+   }
+
    // helper method
    inline void reduce( const depparser::CStateItem *item, const CPackedScoreType<depparser::SCORE_TYPE, depparser::action::MAX> &scores ) ;
    inline void shift( const depparser::CStateItem *item, const CPackedScoreType<depparser::SCORE_TYPE, depparser::action::MAX> &scores) ;
@@ -29,14 +29,17 @@ typedef int64_t SCORE_TYPE ;
 // the implementation supports the extraction of features as a command
 #define SUPPORT_FEATURE_EXTRACTION
 
-// The size of a sentence and the words
-const unsigned MAX_SENTENCE_SIZE = 256 ; 
+// the implementation supports training in threads by parameter mixing
+#define SUPPORT_PARAMETER_MIXING
+
+// The size of a sentence and the words; the states grow with the
+// sentence, so that there is no limit on its size
+const unsigned MAX_SENTENCE_SIZE = UINT_MAX ;
 const unsigned MAX_SENTENCE_SIZE_BITS = 8 ; 
 
 // normalise link size and the direction
 inline int encodeLinkDistance(const int &head_index, const int &dep_index) {
-   static int diff;
-   diff = head_index - dep_index;
+   int diff = head_index - dep_index;
    assert(diff != 0); 
    if (diff<0)
       diff=-diff;
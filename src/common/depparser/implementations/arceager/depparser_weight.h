@@ -374,7 +374,11 @@ public:
    // MEHTODS
    virtual void loadScores();
    virtual void saveScores();
+   void saveBinaryScores(const std::string &sPath, const unsigned &nValueBits=0);
+   void freezeScores();
    void computeAverageFeatureWeights(int round);
+   void setBase(const CWeight &base);
+   void mix(CWeight &worker, const SCORE_TYPE &workers);
    SCORE_TYPE dotProduct(const CWeight &w);
  
 };
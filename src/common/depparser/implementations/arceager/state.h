@@ -14,16 +14,17 @@
  * records the properties of each input word so far.
  *
  * A state item is partial and do not include information about
- * all words from the input sentence. Though m_lHeads, m_lDepsL 
- * and m_lDepsR are fixed arrays with MAX_SENTENCE_SIZE length, 
- * not all the elements from the arrays are used. The ACTIVE 
- * elements are from the input index 0 to m_nNextWord, inclusive. 
- * And a state item only captures information about the active 
- * sub section from input.
+ * all words from the input sentence. The properties of the words
+ * are kept in m_lWords, which grows with the words that the state
+ * reaches, so that there is no limit on the size of a sentence
+ * and short sentences only touch the properties they use. The 
+ * ACTIVE elements are from the input index 0 to m_nNextWord, 
+ * inclusive. And a state item only captures information about 
+ * the active sub section from input.
  *
  * The property for each input word need to be initialised. 
- * m_lHeads m_lDepsL etc could be initialised within the 
- * clear() method. However, because the parsing process is
+ * The heads, dependencies etc in m_lWords could be initialised
+ * within the clear() method. However, because the parsing process is
  * incremental, they can also be initialised lasily. 
  * Apart from the avoidance of unecessary assignments, one 
  * benefit of lazy initialisation is that we only need to copy
@@ -39,21 +40,27 @@ class CStateItem {
 public:
    enum STACK_STATUS { OFF_STACK=0, ON_STACK_SHIFT, ON_STACK_ARCRIGHT } ;
 
+protected:
+   // the properties of one input word
+   struct CWordLinks {
+      int head;                                 // the lexical head
+      int depL;                                 // the leftmost dependency (just for cache, temporary info)
+      int depR;                                 // the rightmost dependency (just for cache, temporary info)
+      int depNumL;                              // the number of left dependencies
+      int depNumR;                              // the number of right dependencies
+      CSetOfTags<CDependencyLabel> depTagL;     // the set of left tags
+      CSetOfTags<CDependencyLabel> depTagR;     // the set of right tags
+      int sibling;                              // the sibling towards head
+#ifdef LABELED
+      unsigned long label;                      // the label of the dependency link
+#endif
+   };
+
 protected:
    std::vector<int> m_Stack;                     // stack of words that are currently processed
    std::vector<int> m_HeadStack;
    int m_nNextWord;                         // index for the next word
-   int m_lHeads[MAX_SENTENCE_SIZE];         // the lexical head for each word
-   int m_lDepsL[MAX_SENTENCE_SIZE];         // the leftmost dependency for each word (just for cache, temporary info)
-   int m_lDepsR[MAX_SENTENCE_SIZE];         // the rightmost dependency for each word (just for cache, temporary info)
-   int m_lDepNumL[MAX_SENTENCE_SIZE];       // the number of left dependencies
-   int m_lDepNumR[MAX_SENTENCE_SIZE];       // the number of right dependencies
-   CSetOfTags<CDependencyLabel> m_lDepTagL[MAX_SENTENCE_SIZE]; // the set of left tags
-   CSetOfTags<CDependencyLabel> m_lDepTagR[MAX_SENTENCE_SIZE]; // the set of right tags
-   int m_lSibling[MAX_SENTENCE_SIZE];       // the sibling towards head
-#ifdef LABELED
-   unsigned long m_lLabels[MAX_SENTENCE_SIZE];   // the label of each dependency link
-#endif
+   std::vector<CWordLinks> m_lWords;        // the properties of each word up to m_nNextWord
    unsigned long m_nLastAction;                  // the last stack action
    const std::vector < CTaggedWord<CTag, TAG_SEPARATOR> >* m_lCache;
 
@@ -75,12 +82,12 @@ public:
       if ( m_nNextWord != item.m_nNextWord )
          return false;
       for ( i=0; i<m_nNextWord; ++i ) {
-         if ( m_lHeads[i] != item.m_lHeads[i] )
+         if ( m_lWords[i].head != item.m_lWords[i].head )
             return false;
       }
 #ifdef LABELED
       for ( i=0; i<m_nNextWord; ++i ) 
-         if ( m_lLabels[i] != item.m_lLabels[i] )
+         if ( m_lWords[i].label != item.m_lWords[i].label )
             return false;
 #endif
       if ( m_Stack.size() != item.m_Stack.size() )
@@ -117,20 +124,20 @@ public:
 #endif
 }
 
-   inline int head( const int &index ) const { assert(index<=m_nNextWord); return m_lHeads[index]; }
-   inline int leftdep( const int &index ) const { assert(index<=m_nNextWord); return m_lDepsL[index]; }
-   inline int rightdep( const int &index ) const { assert(index<=m_nNextWord); return m_lDepsR[index]; }
-   inline int sibling( const int &index ) const { assert(index<=m_nNextWord); return m_lSibling[index]; }
+   inline int head( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].head; }
+   inline int leftdep( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depL; }
+   inline int rightdep( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depR; }
+   inline int sibling( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].sibling; }
    inline int size( ) const { return m_nNextWord ; }
 #ifdef LABELED
-   inline int label( const int &index ) const { assert(index<=m_nNextWord); return m_lLabels[index]; }
+   inline int label( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].label; }
 #endif
 
-   inline int leftarity( const int &index ) const { assert(index<=m_nNextWord); return m_lDepNumL[index]; }
-   inline int rightarity( const int &index ) const { assert(index<=m_nNextWord); return m_lDepNumR[index]; }
+   inline int leftarity( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depNumL; }
+   inline int rightarity( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depNumR; }
 
-   inline const CSetOfTags<CDependencyLabel> &lefttagset( const int &index ) const { assert(index<=m_nNextWord); return m_lDepTagL[index]; }
-   inline const CSetOfTags<CDependencyLabel> &righttagset( const int &index ) const { assert(index<=m_nNextWord); return m_lDepTagR[index]; }
+   inline const CSetOfTags<CDependencyLabel> &lefttagset( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depTagL; }
+   inline const CSetOfTags<CDependencyLabel> &righttagset( const int &index ) const { assert(index<=m_nNextWord); return m_lWords[index].depTagR; }
 
    void clear() { 
       m_nNextWord = 0; m_Stack.clear(); m_HeadStack.clear(); 
@@ -146,19 +153,10 @@ public:
       m_nLastAction = item.m_nLastAction;
       m_lCache = item.m_lCache;
       score = item.score; 
-      for ( int i=0; i<=m_nNextWord; ++i ){ // only copy active word (including m_nNext)
-         m_lHeads[i] = item.m_lHeads[i];  
-         m_lDepsL[i] = item.m_lDepsL[i]; 
-         m_lDepsR[i] = item.m_lDepsR[i];
-         m_lDepNumL[i] = item.m_lDepNumL[i];
-         m_lDepNumR[i] = item.m_lDepNumR[i];
-         m_lDepTagL[i] = item.m_lDepTagL[i];
-         m_lDepTagR[i] = item.m_lDepTagR[i];
-         m_lSibling[i] = item.m_lSibling[i];
-#ifdef LABELED
-         m_lLabels[i] = item.m_lLabels[i];
-#endif
-      }
+      if ( m_lWords.size() < item.m_lWords.size() )
+         m_lWords.resize( item.m_lWords.size() );
+      // only copy active word (including m_nNext)
+      std::copy( item.m_lWords.begin(), item.m_lWords.begin()+m_nNextWord+1, m_lWords.begin() );
    }
 
 //-----------------------------------------------------------------------------
@@ -171,19 +169,18 @@ public:
    void ArcLeft() { 
 #endif
       assert( m_Stack.size() > 0 ) ;
-      assert( m_lHeads[m_Stack.back()] == DEPENDENCY_LINK_NO_HEAD ) ;
-      static int left ;
-      left = m_Stack.back() ;
+      assert( m_lWords[m_Stack.back()].head == DEPENDENCY_LINK_NO_HEAD ) ;
+      const int left = m_Stack.back() ;
       m_Stack.pop_back() ;
       m_HeadStack.pop_back() ;
-      m_lHeads[left] = m_nNextWord;
+      m_lWords[left].head = m_nNextWord;
 #ifdef LABELED
-      m_lLabels[left] = lab;
-      m_lDepTagL[m_nNextWord].add(lab) ;
+      m_lWords[left].label = lab;
+      m_lWords[m_nNextWord].depTagL.add(lab) ;
 #endif
-      m_lSibling[left] = m_lDepsL[m_nNextWord];
-      m_lDepsL[m_nNextWord] = left ;
-      m_lDepNumL[m_nNextWord] ++ ;
+      m_lWords[left].sibling = m_lWords[m_nNextWord].depL;
+      m_lWords[m_nNextWord].depL = left ;
+      m_lWords[m_nNextWord].depNumL ++ ;
 #ifdef LABELED
       m_nLastAction=action::encodeAction(action::ARC_LEFT, lab);
 #else
@@ -198,17 +195,16 @@ public:
    void ArcRight() { 
 #endif
       assert( m_Stack.size() > 0 ) ;
-      static int left ;
-      left = m_Stack.back() ;
+      const int left = m_Stack.back() ;
       m_Stack.push_back( m_nNextWord ) ;
-      m_lHeads[m_nNextWord] = left ;
+      m_lWords[m_nNextWord].head = left ;
 #ifdef LABELED
-      m_lLabels[m_nNextWord] = lab ;
-      m_lDepTagR[left].add(lab) ;
+      m_lWords[m_nNextWord].label = lab ;
+      m_lWords[left].depTagR.add(lab) ;
 #endif
-      m_lSibling[m_nNextWord] = m_lDepsR[left];
-      m_lDepsR[left] = m_nNextWord ;
-      m_lDepNumR[left] ++ ;
+      m_lWords[m_nNextWord].sibling = m_lWords[left].depR;
+      m_lWords[left].depR = m_nNextWord ;
+      m_lWords[left].depNumR ++ ;
       m_nNextWord ++;
       ClearNext();
 #ifdef LABELED
@@ -229,7 +225,7 @@ public:
  
    // the reduce action does popping
    void Reduce() {
-      assert( m_lHeads[m_Stack.back()] != DEPENDENCY_LINK_NO_HEAD ) ;
+      assert( m_lWords[m_Stack.back()].head != DEPENDENCY_LINK_NO_HEAD ) ;
       m_Stack.pop_back() ;
       m_nLastAction=action::encodeAction(action::REDUCE);
    }
@@ -237,12 +233,12 @@ public:
    // this is used for the convenience of scoring and updating
    void PopRoot() {
 #ifndef FRAGMENTED_TREE
-      assert( m_Stack.size() == 1 && m_lHeads[m_Stack.back()] == DEPENDENCY_LINK_NO_HEAD ) ; // make sure only one root item in stack 
+      assert( m_Stack.size() == 1 && m_lWords[m_Stack.back()].head == DEPENDENCY_LINK_NO_HEAD ) ; // make sure only one root item in stack 
 #else
-      assert( m_lHeads[m_Stack.back()] == DEPENDENCY_LINK_NO_HEAD ) ;
+      assert( m_lWords[m_Stack.back()].head == DEPENDENCY_LINK_NO_HEAD ) ;
 #endif
 #ifdef LABELED
-      m_lLabels[m_Stack.back()] = CDependencyLabel::ROOT;
+      m_lWords[m_Stack.back()].label = CDependencyLabel::ROOT;
 #endif
       m_nLastAction = action::encodeAction(action::POP_ROOT);
       m_Stack.pop_back() ; // pop it
@@ -250,16 +246,18 @@ public:
 
    // the clear next action is used to clear the next word, used with forwarding the next word index
    void ClearNext() {
-      m_lHeads[m_nNextWord] = DEPENDENCY_LINK_NO_HEAD ;
-      m_lDepsL[m_nNextWord] = DEPENDENCY_LINK_NO_HEAD ;
-      m_lDepsR[m_nNextWord] = DEPENDENCY_LINK_NO_HEAD ;
-      m_lDepNumL[m_nNextWord] = 0 ;
-      m_lDepTagL[m_nNextWord].clear() ;
-      m_lDepNumR[m_nNextWord] = 0 ;
-      m_lDepTagR[m_nNextWord].clear() ;
-      m_lSibling[m_nNextWord] = DEPENDENCY_LINK_NO_HEAD ;
+      if ( m_nNextWord >= static_cast<int>(m_lWords.size()) )
+         m_lWords.resize( m_nNextWord+1 );
+      m_lWords[m_nNextWord].head = DEPENDENCY_LINK_NO_HEAD ;
+      m_lWords[m_nNextWord].depL = DEPENDENCY_LINK_NO_HEAD ;
+      m_lWords[m_nNextWord].depR = DEPENDENCY_LINK_NO_HEAD ;
+      m_lWords[m_nNextWord].depNumL = 0 ;
+      m_lWords[m_nNextWord].depTagL.clear() ;
+      m_lWords[m_nNextWord].depNumR = 0 ;
+      m_lWords[m_nNextWord].depTagR.clear() ;
+      m_lWords[m_nNextWord].sibling = DEPENDENCY_LINK_NO_HEAD ;
 #ifdef LABELED
-      m_lLabels[m_nNextWord] = CDependencyLabel::NONE;
+      m_lWords[m_nNextWord].label = CDependencyLabel::NONE;
 #endif
    }
 
@@ -310,7 +308,7 @@ public:
 #else
    bool StandardMoveStep( const CDependencyParse &tree ) {
 #endif
-      static int top;
+      int top;
       // when the next word is tree.size() it means that the sentence is done already
       if ( m_nNextWord == static_cast<int>(tree.size()) ) {
          assert( m_Stack.size() > 0 );
@@ -326,8 +324,8 @@ public:
       // the first case is that there is some words on the stack linking to nextword
       if ( m_Stack.size() > 0 ) {
          top = m_Stack.back();
-         while ( !(m_lHeads[top] == DEPENDENCY_LINK_NO_HEAD) )
-            top = m_lHeads[top];
+         while ( !(m_lWords[top].head == DEPENDENCY_LINK_NO_HEAD) )
+            top = m_lWords[top].head;
          if ( tree[top].head == m_nNextWord ) {    // if a local head deps on nextword first
             if ( top == m_Stack.back() ) {
 #ifdef LABELED
@@ -378,26 +376,26 @@ public:
    }
 
    unsigned FollowMove( const CStateItem *item ) {
-      static int top;
+      int top;
       // if the next words are same then don't check head because it might be a finished sentence (m_nNextWord==sentence.sz)
       if ( m_nNextWord == item->m_nNextWord ) {
 //std::cout << "this" << std::endl; for (int i=0; i<m_Stack.size(); ++i) std::cout << m_Stack[i] << " "; std::cout << std::endl;
 //std::cout << "that" << std::endl; for (int i=0; i<item->m_Stack.size(); ++i) std::cout << item->m_Stack[i] << " "; std::cout << std::endl;
 //         if ( m_Stack.size() == item->m_Stack.size() ) {
-//std::cout << "this heads" << std::endl; for (int i=0; i<=m_nNextWord; ++i) std::cout << m_lHeads[i] << " "; std::cout << std::endl;
-//std::cout << "that heads" << std::endl; for (int i=0; i<=item->m_nNextWord; ++i) std::cout << item->m_lHeads[i] << " "; std::cout << std::endl;
-//std::cout << "this dtags" << std::endl; for (int i=0; i<=m_nNextWord; ++i) std::cout << m_lLabels[i] << " "; std::cout << std::endl;
-//std::cout << "that dtags" << std::endl; for (int i=0; i<=item->m_nNextWord; ++i) std::cout << item->m_lLabels[i] << " "; std::cout << std::endl;
+//std::cout << "this heads" << std::endl; for (int i=0; i<=m_nNextWord; ++i) std::cout << m_lWords[i].head << " "; std::cout << std::endl;
+//std::cout << "that heads" << std::endl; for (int i=0; i<=item->m_nNextWord; ++i) std::cout << item->m_lWords[i].head << " "; std::cout << std::endl;
+//std::cout << "this dtags" << std::endl; for (int i=0; i<=m_nNextWord; ++i) std::cout << m_lWords[i].label << " "; std::cout << std::endl;
+//std::cout << "that dtags" << std::endl; for (int i=0; i<=item->m_nNextWord; ++i) std::cout << item->m_lWords[i].label << " "; std::cout << std::endl;
 //         }
          assert( m_Stack.size() > item->m_Stack.size() );
          top = m_Stack.back();
-         if ( item->m_lHeads[top] == m_nNextWord ) 
+         if ( item->m_lWords[top].head == m_nNextWord ) 
 #ifdef LABELED
-            return action::encodeAction(action::ARC_LEFT, item->m_lLabels[top]);
+            return action::encodeAction(action::ARC_LEFT, item->m_lWords[top].label);
 #else
             return action::ARC_LEFT;
 #endif
-         else if ( item->m_lHeads[top] != DEPENDENCY_LINK_NO_HEAD ) 
+         else if ( item->m_lWords[top].head != DEPENDENCY_LINK_NO_HEAD ) 
             return action::encodeAction(action::REDUCE);
          else 
             return action::encodeAction(action::POP_ROOT);
@@ -405,12 +403,12 @@ public:
       // the first case is that there is some words on the stack linking to nextword
       if ( m_Stack.size() > 0 ) {
          top = m_Stack.back();
-         while ( !(m_lHeads[top] == DEPENDENCY_LINK_NO_HEAD) )
-            top = m_lHeads[top];
+         while ( !(m_lWords[top].head == DEPENDENCY_LINK_NO_HEAD) )
+            top = m_lWords[top].head;
          if ( item->head(top) == m_nNextWord ) {    // if a local head deps on nextword first
             if ( top == m_Stack.back() ) {
 #ifdef LABELED
-               return action::encodeAction(action::ARC_LEFT, item->m_lLabels[top]);
+               return action::encodeAction(action::ARC_LEFT, item->m_lWords[top].label);
 #else
                return action::ARC_LEFT;
 #endif
@@ -431,7 +429,7 @@ public:
          top = m_Stack.back(); 
          if ( item->head(m_nNextWord) == top ) {    // the next word deps on stack top
 #ifdef LABELED
-            return action::encodeAction(action::ARC_RIGHT, item->m_lLabels[m_nNextWord]);
+            return action::encodeAction(action::ARC_RIGHT, item->m_lWords[m_nNextWord].label);
 #else
             return action::ARC_RIGHT;
 #endif
@@ -446,15 +444,32 @@ public:
       output.clear();
       for ( int i=0; i<size(); ++i ) 
 #ifdef LABELED
-         output.push_back( CLabeledDependencyTreeNode( input.at(i).first , input.at(i).second , m_lHeads[i] , CDependencyLabel(m_lLabels[i]).str() ) ) ;
+         output.push_back( CLabeledDependencyTreeNode( input.at(i).first , input.at(i).second , m_lWords[i].head , CDependencyLabel(m_lWords[i].label).str() ) ) ;
 #else
-         output.push_back( CDependencyTreeNode( input.at(i).first , input.at(i).second , m_lHeads[i] ) ) ;
+         output.push_back( CDependencyTreeNode( input.at(i).first , input.at(i).second , m_lWords[i].head ) ) ;
 #endif
    }
 
 
 
 
+};
+
+/*===============================================================
+ *
+ * CScoredTransition - an action from a state and the score of the
+ *                     result, which is only made into a state if
+ *                     it is kept in the beam
+ *
+ *==============================================================*/
+
+struct CScoredTransition {
+   const CStateItem *source;                // the state the action is taken from
+   unsigned long action;
+   SCORE_TYPE score;                        // the score of the resulting state
+public:
+   bool operator < (const CScoredTransition &t) const { return score < t.score; }
+   bool operator > (const CScoredTransition &t) const { return score > t.score; }
 };
 
 #endif
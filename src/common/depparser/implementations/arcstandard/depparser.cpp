@@ -1,6 +1,7 @@
 // Copyright (C) University of Oxford 2010
 #include "depparser.h"
 #include "depparser_weight.h"
+#include "profile.h"
 
 using namespace TARGET_LANGUAGE;
 using namespace TARGET_LANGUAGE::depparser;
@@ -9,7 +10,6 @@ const CWord g_emptyWord("");
 const CTaggedWord<CTag, TAG_SEPARATOR> g_emptyTaggedWord;
 const CTag g_noneTag = CTag::NONE;
 
-const int kMaxSentenceSize = MAX_SENTENCE_SIZE;
 const int kAgendaSize = AGENDA_SIZE;
 
 #define cast_weights static_cast<CWeight*>(m_weights)
@@ -36,17 +36,17 @@ CDepParser::CDepParser(const std::string &sFeatureDBPath,
                        bool bCoNLL)
   : CDepParserBase(sFeatureDBPath, bTrain, bCoNLL),
   lattice_(0),
-  m_kBestTransitions(0),
-  max_beam_size_(0),
+  beam_(AGENDA_SIZE),
   max_lattice_size_(0) {
 
   m_weights = new depparser :: CWeight(sFeatureDBPath, bTrain);
-  m_kBestTransitions = new depparser::CScoredTransition[AGENDA_SIZE];
+  if (!bTrain) {
+    static_cast<depparser::CWeight*>(m_weights)->freezeScores();
+  }
   m_nTrainingRound = 0;
 
   m_nTotalErrors = 0;
 
-  max_beam_size_ = AGENDA_SIZE;
   if (bTrain) {
     m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eNonAverage;
   } else {
@@ -54,12 +54,29 @@ CDepParser::CDepParser(const std::string &sFeatureDBPath,
   }
 }
 
+CDepParser::CDepParser(const CDepParser &model,
+                       bool bCoNLL)
+  : CDepParserBase("", false, bCoNLL),
+  lattice_(0),
+  beam_(AGENDA_SIZE),
+  max_lattice_size_(0) {
+
+  ASSERT(!model.m_bTrain, "Only the weights of a decoding parser can be shared");
+  m_weights = model.m_weights;
+  m_bSharedWeights = true;
+  m_nBeamWidth = model.m_nBeamWidth;
+  m_nBeamMargin = model.m_nBeamMargin;
+  m_nTrainingRound = 0;
+
+  m_nTotalErrors = 0;
+
+  m_nScoreIndex = CScore<depparser::SCORE_TYPE>::eAverage;
+}
+
 CDepParser::~CDepParser() {
   // delete m_Beam;
-  delete m_weights;
-
-  if (m_kBestTransitions) {
-    delete[] m_kBestTransitions;
+  if (!m_bSharedWeights) {
+    delete m_weights;
   }
 
   if (lattice_) {
@@ -69,130 +86,52 @@ CDepParser::~CDepParser() {
 
 /*---------------------------------------------------------------
  *
- * getOrUpdateStackScore - manipulate the score from stack
+ * GetOrUpdateS0Score, GetOrUpdateS1Score - manipulate the score
+ * from the templates of a stack node alone
+ *
+ * These only look at the node, its dependents and their words,
+ * so that their scores are the same for every state with the
+ * same node in the same place.
  *
  *---------------------------------------------------------------*/
-inline void
-CDepParser::GetOrUpdateStackScore(const CStateItem * item,
-                                  CPackedScore& retval,
-                                  const unsigned & action,
-                                  SCORE_TYPE amount,
-                                  int round) {
-
-  const int & S0id = item->stacktop();
-  const int & S0l1did = (S0id == -1 ? -1 : item->leftdep(S0id));
-  const int & S0r1did = (S0id == -1 ? -1 : item->rightdep(S0id));
-  const int & S0l2did = (S0id == -1 ? -1 : item->left2dep(S0id));
-  const int & S0r2did = (S0id == -1 ? -1 : item->right2dep(S0id));
-  const int & S1id = item->stack2top();
-  const int & S1l1did = (S1id == -1 ? -1 : item->leftdep(S1id));
-  const int & S1r1did = (S1id == -1 ? -1 : item->rightdep(S1id));
-  const int & S1l2did = (S1id == -1 ? -1 : item->left2dep(S1id));
-  const int & S1r2did = (S1id == -1 ? -1 : item->right2dep(S1id));
-  const int & N0id = item->size() >= m_lCache.size() ? -1 : item->size();
-  const int & N1id = item->size() + 1 >= m_lCache.size() ? -1 : item->size() + 1;
-
 #define REF(prefix) const CTaggedWord<CTag, TAG_SEPARATOR> & prefix##wt = (\
     prefix##id == -1 ? g_emptyTaggedWord : m_lCache[prefix##id]);
-#define REFw(prefix) const CWord & prefix##w = prefix##wt.word;
-#define REFt(prefix) const CTag & prefix##t = prefix##wt.tag;
-#define REFd(prefix) const int & prefix##d = (\
-    prefix##id == -1 ? CDependencyLabel::NONE : item->label(prefix##id));
-
-  REF(S0); REF(S0l1d); REF(S0r1d); REF(S0l2d); REF(S0r2d);
-  REF(S1); REF(S1l1d); REF(S1r1d); REF(S1l2d); REF(S1r2d);
-  REF(N0); REF(N1);
-
-  REFw(S0); REFw(S0l1d); REFw(S0r1d); REFw(S0l2d); REFw(S0r2d);
-  REFw(S1); REFw(S1l1d); REFw(S1r1d); REFw(S1l2d); REFw(S1r2d);
-  REFw(N0); REFw(N1);
-
-  REFt(S0); REFt(S0l1d); REFt(S0r1d); REFt(S0l2d); REFt(S0r2d);
-  REFt(S1); REFt(S1l1d); REFt(S1r1d); REFt(S1l2d); REFt(S1r2d);
-  REFt(N0); REFt(N1);
-
-  REFd(S0l1d); REFd(S0r1d); REFd(S0l2d); REFd(S0r2d);
-  REFd(S1l1d); REFd(S1r1d); REFd(S1l2d); REFd(S1r2d);
-
-  const int S0ra = (S0id == -1 ? 0 : item->rightarity(S0id));
-  const int S0la = (S0id == -1 ? 0 : item->leftarity(S0id));
-  const int S1ra = (S1id == -1 ? 0 : item->rightarity(S1id));
-  const int S1la = (S1id == -1 ? 0 : item->leftarity(S1id));
-
-  const CSetOfTags<CDependencyLabel> &S0rset = (
-      S0id == -1 ? CSetOfTags<CDependencyLabel>() : item->righttagset(S0id));
-  const CSetOfTags<CDependencyLabel> &S0lset = (
-      S0id == -1 ? CSetOfTags<CDependencyLabel>() : item->lefttagset(S0id));
-  const CSetOfTags<CDependencyLabel> &S1rset = (
-      S1id == -1 ? CSetOfTags<CDependencyLabel>() : item->righttagset(S1id));
-  const CSetOfTags<CDependencyLabel> &S1lset = (
-      S1id == -1 ? CSetOfTags<CDependencyLabel>() : item->lefttagset(S1id));
+#define REFd(prefix, node, dep) const int & prefix##d = (\
+    prefix##id == -1 ? CDependencyLabel::NONE : node->dep##label);
 
 #define __GET_OR_UPDATE_SCORE(temp, feature) \
   cast_weights->temp.getOrUpdateScore(retval, feature, \
       action, m_nScoreIndex, amount, round);
 
-  CTuple2<CWord, CWord>     ww;
-  CTuple2<CWord, CTag>      wt;
-  CTuple2<CTag, CTag>       tt;
+inline void
+CDepParser::GetOrUpdateS0Score(const CStackNode * S0,
+                               CPackedScore& retval,
+                               const unsigned & action,
+                               SCORE_TYPE amount,
+                               int round) {
+  const int & S0id = S0->id;
+  const int & S0l1did = S0->l1;
+  const int & S0r1did = S0->r1;
+  const int & S0l2did = S0->l2;
+  const int & S0r2did = S0->r2;
+
+  REF(S0); REF(S0l1d); REF(S0r1d); REF(S0l2d); REF(S0r2d);
+  REFd(S0l1d, S0, l1); REFd(S0r1d, S0, r1); REFd(S0l2d, S0, l2); REFd(S0r2d, S0, r2);
+
+  const int S0ra = S0->rightarity;
+  const int S0la = S0->leftarity;
+  const CSetOfTags<CDependencyLabel> &S0rset = S0->righttags;
+  const CSetOfTags<CDependencyLabel> &S0lset = S0->lefttags;
+
   CTuple3<CTag, CTag, CTag> ttt;
   CTuple2<CWord, int>       wi;
   CTuple2<CTag, int>        ti;
   CTuple2<CWord, CSetOfTags<CDependencyLabel> > wset;
   CTuple2<CTag,  CSetOfTags<CDependencyLabel> > tset;
 
-  // single
-  if (S0id != -1) {
-    __GET_OR_UPDATE_SCORE(S0w,    S0wt.word); //  0
-    __GET_OR_UPDATE_SCORE(S0t,    S0wt.tag);  //  1
-    __GET_OR_UPDATE_SCORE(S0wS0t, S0wt);      //  2
-  }
-
-  if (S1id != -1) {
-    __GET_OR_UPDATE_SCORE(S1w,    S1wt.word); //  3
-    __GET_OR_UPDATE_SCORE(S1t,    S1wt.tag);  //  4
-    __GET_OR_UPDATE_SCORE(S1wS1t, S1wt);      //  5
-  }
-
-  if (N0id != -1) {
-    __GET_OR_UPDATE_SCORE(N0w,    N0wt.word); //  6
-    __GET_OR_UPDATE_SCORE(N0t,    N0wt.tag);  //  7
-    __GET_OR_UPDATE_SCORE(N0wN0t, N0wt);      //  8
-  }
-
-  if (N1id != -1) {
-    __GET_OR_UPDATE_SCORE(N1w,    N1wt.word); //  9
-    __GET_OR_UPDATE_SCORE(N1t,    N1wt.tag);  //  10
-    __GET_OR_UPDATE_SCORE(N1wN1t, N1wt);      //  11
-  }
-
-  if (-1 != S0id && -1 != S1id) {
-    refer_or_allocate_tuple2(ww, &S0wt.word, &S1wt.word);
-    __GET_OR_UPDATE_SCORE(S0wS1w, ww);        //  12
-
-    refer_or_allocate_tuple2(wt, &S0wt.word, &S1wt.tag);
-    __GET_OR_UPDATE_SCORE(S0wS1t, wt);        //  13
-
-    refer_or_allocate_tuple2(wt, &S1wt.word, &S0wt.tag);
-    __GET_OR_UPDATE_SCORE(S0tS1w, wt);        //  14
-
-    refer_or_allocate_tuple2(tt, &S0wt.tag,  &S1wt.tag);
-    __GET_OR_UPDATE_SCORE(S0tS1t, tt);        //  15
-  }
-
-  if (-1 != S0id && -1 != N0id) {
-    refer_or_allocate_tuple2(ww, &S0wt.word, &N0wt.word);
-    __GET_OR_UPDATE_SCORE(S0wN0w, ww);        //  16
-
-    refer_or_allocate_tuple2(wt, &S0wt.word, &N0wt.tag);
-    __GET_OR_UPDATE_SCORE(S0wN0t, wt);        //  17
-
-    refer_or_allocate_tuple2(wt, &N0wt.word, &S0wt.tag);
-    __GET_OR_UPDATE_SCORE(S0tN0w, wt);        //  18
-
-    refer_or_allocate_tuple2(tt, &S0wt.tag,  &N0wt.tag);
-    __GET_OR_UPDATE_SCORE(S0tN0t, tt);        //  19
-  }
+  __GET_OR_UPDATE_SCORE(S0w,    S0wt.word); //  0
+  __GET_OR_UPDATE_SCORE(S0t,    S0wt.tag);  //  1
+  __GET_OR_UPDATE_SCORE(S0wS0t, S0wt);      //  2
 
   if (-1 != S0l1did) {
     __GET_OR_UPDATE_SCORE(S0l1dw,       S0l1dwt.word);  //  20
@@ -208,20 +147,6 @@ CDepParser::GetOrUpdateStackScore(const CStateItem * item,
     __GET_OR_UPDATE_SCORE(S0r1dd,       S0r1dd);        //  27
   }
 
-  if (-1 != S1l1did) {
-    __GET_OR_UPDATE_SCORE(S1l1dw,       S1l1dwt.word);  //  28
-    __GET_OR_UPDATE_SCORE(S1l1dt,       S1l1dwt.tag);   //  29
-    __GET_OR_UPDATE_SCORE(S1l1dwS1l1dt, S1l1dwt);       //  30
-    __GET_OR_UPDATE_SCORE(S1l1dd,       S1l1dd);        //  31
-  }
-
-  if (-1 != S1r1did) {
-    __GET_OR_UPDATE_SCORE(S1r1dw,       S1r1dwt.word);  //  32
-    __GET_OR_UPDATE_SCORE(S1r1dt,       S1r1dwt.tag);   //  33
-    __GET_OR_UPDATE_SCORE(S1r1dwS1r1dt, S1r1dwt);       //  34
-    __GET_OR_UPDATE_SCORE(S1r1dd,       S1r1dd);        //  35
-  }
-
   if (-1 != S0l2did) {
     __GET_OR_UPDATE_SCORE(S0l2dw,       S0l2dwt.word);  //  36
     __GET_OR_UPDATE_SCORE(S0l2dt,       S0l2dwt.tag);   //  37
@@ -242,6 +167,78 @@ CDepParser::GetOrUpdateStackScore(const CStateItem * item,
     __GET_OR_UPDATE_SCORE(S0tS0r1dtS0r2dt, ttt);
   }
 
+  // the arity templates are scored twice
+  for (int i = 0; i < 2; ++ i) {
+    refer_or_allocate_tuple2(wi, &S0wt.word, &S0ra);
+    __GET_OR_UPDATE_SCORE(S0wS0ra, wi);
+
+    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0ra);
+    __GET_OR_UPDATE_SCORE(S0tS0ra, ti);
+
+    refer_or_allocate_tuple2(wi, &S0wt.word, &S0la);
+    __GET_OR_UPDATE_SCORE(S0wS0la, wi);
+
+    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0la);
+    __GET_OR_UPDATE_SCORE(S0tS0la, ti);
+  }
+
+  refer_or_allocate_tuple2(wset, &S0wt.word, &S0lset);
+  __GET_OR_UPDATE_SCORE(S0wS0lset, wset);
+
+  refer_or_allocate_tuple2(tset, &S0wt.tag, &S0lset);
+  __GET_OR_UPDATE_SCORE(S0tS0lset, tset);
+
+  refer_or_allocate_tuple2(wset, &S0wt.word, &S0rset);
+  __GET_OR_UPDATE_SCORE(S0wS0rset, wset);
+
+  refer_or_allocate_tuple2(tset, &S0wt.tag, &S0rset);
+  __GET_OR_UPDATE_SCORE(S0tS0rset, tset);
+}
+
+inline void
+CDepParser::GetOrUpdateS1Score(const CStackNode * S1,
+                               CPackedScore& retval,
+                               const unsigned & action,
+                               SCORE_TYPE amount,
+                               int round) {
+  const int & S1id = S1->id;
+  const int & S1l1did = S1->l1;
+  const int & S1r1did = S1->r1;
+  const int & S1l2did = S1->l2;
+  const int & S1r2did = S1->r2;
+
+  REF(S1); REF(S1l1d); REF(S1r1d); REF(S1l2d); REF(S1r2d);
+  REFd(S1l1d, S1, l1); REFd(S1r1d, S1, r1); REFd(S1l2d, S1, l2); REFd(S1r2d, S1, r2);
+
+  const int S1ra = S1->rightarity;
+  const int S1la = S1->leftarity;
+  const CSetOfTags<CDependencyLabel> &S1rset = S1->righttags;
+  const CSetOfTags<CDependencyLabel> &S1lset = S1->lefttags;
+
+  CTuple3<CTag, CTag, CTag> ttt;
+  CTuple2<CWord, int>       wi;
+  CTuple2<CTag, int>        ti;
+  CTuple2<CWord, CSetOfTags<CDependencyLabel> > wset;
+  CTuple2<CTag,  CSetOfTags<CDependencyLabel> > tset;
+
+  __GET_OR_UPDATE_SCORE(S1w,    S1wt.word); //  3
+  __GET_OR_UPDATE_SCORE(S1t,    S1wt.tag);  //  4
+  __GET_OR_UPDATE_SCORE(S1wS1t, S1wt);      //  5
+
+  if (-1 != S1l1did) {
+    __GET_OR_UPDATE_SCORE(S1l1dw,       S1l1dwt.word);  //  28
+    __GET_OR_UPDATE_SCORE(S1l1dt,       S1l1dwt.tag);   //  29
+    __GET_OR_UPDATE_SCORE(S1l1dwS1l1dt, S1l1dwt);       //  30
+    __GET_OR_UPDATE_SCORE(S1l1dd,       S1l1dd);        //  31
+  }
+
+  if (-1 != S1r1did) {
+    __GET_OR_UPDATE_SCORE(S1r1dw,       S1r1dwt.word);  //  32
+    __GET_OR_UPDATE_SCORE(S1r1dt,       S1r1dwt.tag);   //  33
+    __GET_OR_UPDATE_SCORE(S1r1dwS1r1dt, S1r1dwt);       //  34
+    __GET_OR_UPDATE_SCORE(S1r1dd,       S1r1dd);        //  35
+  }
+
   if (-1 != S1l2did) {
     __GET_OR_UPDATE_SCORE(S1l2dw,       S1l2dwt.word);  //  44
     __GET_OR_UPDATE_SCORE(S1l2dt,       S1l2dwt.tag);   //  45
@@ -262,6 +259,156 @@ CDepParser::GetOrUpdateStackScore(const CStateItem * item,
     __GET_OR_UPDATE_SCORE(S1tS1r1dtS1r2dt, ttt);
   }
 
+  // the arity templates are scored twice
+  for (int i = 0; i < 2; ++ i) {
+    refer_or_allocate_tuple2(wi, &S1wt.word, &S1ra);
+    __GET_OR_UPDATE_SCORE(S1wS1ra, wi);
+
+    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1ra);
+    __GET_OR_UPDATE_SCORE(S1tS1ra, ti);
+
+    refer_or_allocate_tuple2(wi, &S1wt.word, &S1la);
+    __GET_OR_UPDATE_SCORE(S1wS1la, wi);
+
+    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1la);
+    __GET_OR_UPDATE_SCORE(S1tS1la, ti);
+  }
+
+  refer_or_allocate_tuple2(wset, &S1wt.word, &S1lset);
+  __GET_OR_UPDATE_SCORE(S1wS1lset, wset);
+
+  refer_or_allocate_tuple2(tset, &S1wt.tag, &S1lset);
+  __GET_OR_UPDATE_SCORE(S1tS1lset, tset);
+
+  refer_or_allocate_tuple2(wset, &S1wt.word, &S1rset);
+  __GET_OR_UPDATE_SCORE(S1wS1rset, wset);
+
+  refer_or_allocate_tuple2(tset, &S1wt.tag, &S1rset);
+  __GET_OR_UPDATE_SCORE(S1tS1rset, tset);
+}
+
+/*---------------------------------------------------------------
+ *
+ * GetOrUpdateNextScore - manipulate the score from the templates
+ * of the next words alone
+ *
+ *---------------------------------------------------------------*/
+inline void
+CDepParser::GetOrUpdateNextScore(const int & N0id,
+                                 CPackedScore& retval,
+                                 const unsigned & action,
+                                 SCORE_TYPE amount,
+                                 int round) {
+  const int N1id = N0id + 1 >= m_lCache.size() ? -1 : N0id + 1;
+
+  REF(N0); REF(N1);
+
+  __GET_OR_UPDATE_SCORE(N0w,    N0wt.word); //  6
+  __GET_OR_UPDATE_SCORE(N0t,    N0wt.tag);  //  7
+  __GET_OR_UPDATE_SCORE(N0wN0t, N0wt);      //  8
+
+  if (N1id != -1) {
+    __GET_OR_UPDATE_SCORE(N1w,    N1wt.word); //  9
+    __GET_OR_UPDATE_SCORE(N1t,    N1wt.tag);  //  10
+    __GET_OR_UPDATE_SCORE(N1wN1t, N1wt);      //  11
+  }
+}
+
+/*---------------------------------------------------------------
+ *
+ * getOrUpdateStackScore - manipulate the score from stack
+ *
+ * When decoding, the scores of S0 alone, S1 alone and the next
+ * words are taken from the caches of the sentence, and only the
+ * templates across them are looked up for each state.
+ *
+ *---------------------------------------------------------------*/
+inline void
+CDepParser::GetOrUpdateStackScore(const CStateItem * item,
+                                  CPackedScore& retval,
+                                  const unsigned & action,
+                                  SCORE_TYPE amount,
+                                  int round) {
+
+  const CStackNode * S0 = item->stacktopnode();
+  const CStackNode * S1 = item->stack2topnode();
+  const int & S0id = (S0 == 0 ? -1 : S0->id);
+  const int & S0l1did = (S0 == 0 ? -1 : S0->l1);
+  const int & S0r1did = (S0 == 0 ? -1 : S0->r1);
+  const int & S0l2did = (S0 == 0 ? -1 : S0->l2);
+  const int & S0r2did = (S0 == 0 ? -1 : S0->r2);
+  const int & S1id = (S1 == 0 ? -1 : S1->id);
+  const int & S1l1did = (S1 == 0 ? -1 : S1->l1);
+  const int & S1r1did = (S1 == 0 ? -1 : S1->r1);
+  const int & S1l2did = (S1 == 0 ? -1 : S1->l2);
+  const int & S1r2did = (S1 == 0 ? -1 : S1->r2);
+  const int & N0id = item->size() >= m_lCache.size() ? -1 : item->size();
+
+  if (amount == 0) {
+    CPackedScore * scores;
+    if (S0id != -1) {
+      if (!s0_scores_.find(*S0, scores)) {
+        GetOrUpdateS0Score(S0, *scores, action);
+      }
+      retval += *scores;
+    }
+    if (S1id != -1) {
+      if (!s1_scores_.find(*S1, scores)) {
+        GetOrUpdateS1Score(S1, *scores, action);
+      }
+      retval += *scores;
+    }
+    if (N0id != -1) {
+      if (!next_scores_.find(N0id, scores)) {
+        GetOrUpdateNextScore(N0id, *scores, action);
+      }
+      retval += *scores;
+    }
+  } else {
+    if (S0id != -1) { GetOrUpdateS0Score(S0, retval, action, amount, round); }
+    if (S1id != -1) { GetOrUpdateS1Score(S1, retval, action, amount, round); }
+    if (N0id != -1) { GetOrUpdateNextScore(N0id, retval, action, amount, round); }
+  }
+
+  REF(S0); REF(S0l1d); REF(S0r1d); REF(S0l2d); REF(S0r2d);
+  REF(S1); REF(S1l1d); REF(S1r1d); REF(S1l2d); REF(S1r2d);
+  REF(N0);
+
+  CTuple2<CWord, CWord>     ww;
+  CTuple2<CWord, CTag>      wt;
+  CTuple2<CTag, CTag>       tt;
+  CTuple3<CTag, CTag, CTag> ttt;
+  CTuple2<CWord, int>       wi;
+  CTuple2<CTag, int>        ti;
+
+  if (-1 != S0id && -1 != S1id) {
+    refer_or_allocate_tuple2(ww, &S0wt.word, &S1wt.word);
+    __GET_OR_UPDATE_SCORE(S0wS1w, ww);        //  12
+
+    refer_or_allocate_tuple2(wt, &S0wt.word, &S1wt.tag);
+    __GET_OR_UPDATE_SCORE(S0wS1t, wt);        //  13
+
+    refer_or_allocate_tuple2(wt, &S1wt.word, &S0wt.tag);
+    __GET_OR_UPDATE_SCORE(S0tS1w, wt);        //  14
+
+    refer_or_allocate_tuple2(tt, &S0wt.tag,  &S1wt.tag);
+    __GET_OR_UPDATE_SCORE(S0tS1t, tt);        //  15
+  }
+
+  if (-1 != S0id && -1 != N0id) {
+    refer_or_allocate_tuple2(ww, &S0wt.word, &N0wt.word);
+    __GET_OR_UPDATE_SCORE(S0wN0w, ww);        //  16
+
+    refer_or_allocate_tuple2(wt, &S0wt.word, &N0wt.tag);
+    __GET_OR_UPDATE_SCORE(S0wN0t, wt);        //  17
+
+    refer_or_allocate_tuple2(wt, &N0wt.word, &S0wt.tag);
+    __GET_OR_UPDATE_SCORE(S0tN0w, wt);        //  18
+
+    refer_or_allocate_tuple2(tt, &S0wt.tag,  &N0wt.tag);
+    __GET_OR_UPDATE_SCORE(S0tN0t, tt);        //  19
+  }
+
   if (-1 != S0id && -1 != S1id) {
     if (-1 != S0l1did) {
       refer_or_allocate_tuple3(ttt, &S0wt.tag, &S1wt.tag, &S0l1dwt.tag);
@@ -304,91 +451,6 @@ CDepParser::GetOrUpdateStackScore(const CStateItem * item,
     }
   }
 
-  if (-1 != S0id) {
-    refer_or_allocate_tuple2(wi, &S0wt.word, &S0ra);
-    __GET_OR_UPDATE_SCORE(S0wS0ra, wi);
-
-    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0ra);
-    __GET_OR_UPDATE_SCORE(S0tS0ra, ti);
-
-    refer_or_allocate_tuple2(wi, &S0wt.word, &S0la);
-    __GET_OR_UPDATE_SCORE(S0wS0la, wi);
-
-    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0la);
-    __GET_OR_UPDATE_SCORE(S0tS0la, ti);
-  }
-
-  if (-1 != S1id) {
-    refer_or_allocate_tuple2(wi, &S1wt.word, &S1ra);
-    __GET_OR_UPDATE_SCORE(S1wS1ra, wi);
-
-    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1ra);
-    __GET_OR_UPDATE_SCORE(S1tS1ra, ti);
-
-    refer_or_allocate_tuple2(wi, &S1wt.word, &S1la);
-    __GET_OR_UPDATE_SCORE(S1wS1la, wi);
-
-    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1la);
-    __GET_OR_UPDATE_SCORE(S1tS1la, ti);
-  }
-
-  if (-1 != S0id) {
-    refer_or_allocate_tuple2(wi, &S0wt.word, &S0ra);
-    __GET_OR_UPDATE_SCORE(S0wS0ra, wi);
-
-    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0ra);
-    __GET_OR_UPDATE_SCORE(S0tS0ra, ti);
-
-    refer_or_allocate_tuple2(wi, &S0wt.word, &S0la);
-    __GET_OR_UPDATE_SCORE(S0wS0la, wi);
-
-    refer_or_allocate_tuple2(ti, &S0wt.tag, &S0la);
-    __GET_OR_UPDATE_SCORE(S0tS0la, ti);
-  }
-
-  if (-1 != S1id) {
-    refer_or_allocate_tuple2(wi, &S1wt.word, &S1ra);
-    __GET_OR_UPDATE_SCORE(S1wS1ra, wi);
-
-    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1ra);
-    __GET_OR_UPDATE_SCORE(S1tS1ra, ti);
-
-    refer_or_allocate_tuple2(wi, &S1wt.word, &S1la);
-    __GET_OR_UPDATE_SCORE(S1wS1la, wi);
-
-    refer_or_allocate_tuple2(ti, &S1wt.tag, &S1la);
-    __GET_OR_UPDATE_SCORE(S1tS1la, ti);
-  }
-
-  if (-1 != S0id) {
-    refer_or_allocate_tuple2(wset, &S0wt.word, &S0lset);
-    __GET_OR_UPDATE_SCORE(S0wS0lset, wset);
-
-    refer_or_allocate_tuple2(tset, &S0wt.tag, &S0lset);
-    __GET_OR_UPDATE_SCORE(S0tS0lset, tset);
-
-    refer_or_allocate_tuple2(wset, &S0wt.word, &S0rset);
-    __GET_OR_UPDATE_SCORE(S0wS0rset, wset);
-
-    refer_or_allocate_tuple2(tset, &S0wt.tag, &S0rset);
-    __GET_OR_UPDATE_SCORE(S0tS0rset, tset);
-  }
-
-  if (-1 != S1id) {
-    refer_or_allocate_tuple2(wset, &S1wt.word, &S1lset);
-    __GET_OR_UPDATE_SCORE(S1wS1lset, wset);
-
-    refer_or_allocate_tuple2(tset, &S1wt.tag, &S1lset);
-    __GET_OR_UPDATE_SCORE(S1tS1lset, tset);
-
-    refer_or_allocate_tuple2(wset, &S1wt.word, &S1rset);
-    __GET_OR_UPDATE_SCORE(S1wS1rset, wset);
-
-    refer_or_allocate_tuple2(tset, &S1wt.tag, &S1rset);
-    __GET_OR_UPDATE_SCORE(S1tS1rset, tset);
-  }
-
-
   if (-1 != S0id && -1 != S1id) {
     int dist = encodeLinkDistance(S1id, S0id);
     refer_or_allocate_tuple2(wi, &S0wt.word, &dist);
@@ -418,21 +480,20 @@ CDepParser::UpdateScoresForStates(const CStateItem* predicated_state,
   static CPackedScore empty;
   // do not update those steps where they are correct
 
-  const CStateItem * predicated_state_chain[kMaxSentenceSize * 2];
-  const CStateItem * correct_state_chain[kMaxSentenceSize * 2];
+  std::vector<const CStateItem *> predicated_state_chain;
+  std::vector<const CStateItem *> correct_state_chain;
 
-  int num_predicated_states = 0;
-  int num_correct_states = 0;
   for (const CStateItem * p = predicated_state; p; p = p->previous_) {
-    predicated_state_chain[num_predicated_states] = p;
-    ++ num_predicated_states;
+    predicated_state_chain.push_back(p);
   }
 
   for (const CStateItem * p = correct_state; p; p = p->previous_) {
-    correct_state_chain[num_correct_states] = p;
-    ++ num_correct_states;
+    correct_state_chain.push_back(p);
   }
 
+  const int num_predicated_states = predicated_state_chain.size();
+  const int num_correct_states = correct_state_chain.size();
+
   ASSERT(num_correct_states == num_predicated_states,
          "Number of predicated action don't equals the correct one");
 
@@ -468,8 +529,8 @@ CDepParser::UpdateScoresForStates(const CStateItem* predicated_state,
 inline void
 CDepParser::arcleft(const CStateItem *item,
                     const CPackedScore& scores) {
-  static CScoredTransition transition;
-  static unsigned label;
+  CScoredTransition transition;
+  unsigned label;
 
 #ifdef LABELED
   for (label=CDependencyLabel::FIRST; label<CDependencyLabel::COUNT; ++label) {
@@ -494,8 +555,8 @@ CDepParser::arcleft(const CStateItem *item,
 inline void
 CDepParser::arcright(const CStateItem * item,
                      const CPackedScore& scores) {
-  static CScoredTransition transition;
-  static unsigned label;
+  CScoredTransition transition;
+  unsigned label;
 
 #ifdef LABELED
   for (label=CDependencyLabel::FIRST; label<CDependencyLabel::COUNT; ++label) {
@@ -520,7 +581,7 @@ CDepParser::arcright(const CStateItem * item,
 inline void
 CDepParser::shift(const CStateItem * item,
                   const CPackedScore& scores) {
-  static CScoredTransition transition;
+  CScoredTransition transition;
   // update stack score
   transition.source = item;
   transition.action = action::kShift;
@@ -537,7 +598,7 @@ CDepParser::shift(const CStateItem * item,
 inline void
 CDepParser::poproot(const CStateItem *item,
                     const CPackedScore& scores) {
-  static CScoredTransition transition;
+  CScoredTransition transition;
   // update stack score
   transition.source = item;
   transition.action = action::kPopRoot;
@@ -545,36 +606,11 @@ CDepParser::poproot(const CStateItem *item,
   InsertIntoBeam(transition);
 }
 
-bool
-ScoredTransitionMore(const CScoredTransition& x, const CScoredTransition& y) {
-  return x.score > y.score;
-}
-
 bool
 StateMore(const CStateItem& x, const CStateItem& y) {
   return x.score > y.score;
 }
 
-int
-CDepParser::InsertIntoBeam(const CScoredTransition & transition) {
-  if (current_beam_size_ == max_beam_size_) {
-    if (transition.score > m_kBestTransitions[0].score) {
-      std::pop_heap(m_kBestTransitions, m_kBestTransitions + max_beam_size_,
-          ScoredTransitionMore);
-      m_kBestTransitions[max_beam_size_- 1] = transition;
-      std::push_heap(m_kBestTransitions, m_kBestTransitions+ max_beam_size_,
-          ScoredTransitionMore);
-    }
-    return 0;
-  }
-
-  m_kBestTransitions[current_beam_size_] = transition;
-  std::push_heap(m_kBestTransitions, m_kBestTransitions+ current_beam_size_+ 1,
-      ScoredTransitionMore);
-  ++ current_beam_size_;
-  return 1;
-}
-
 CStateItem *
 CDepParser::GetLattice(int max_lattice_size) {
   if (0 == lattice_) {
@@ -586,7 +622,8 @@ CDepParser::GetLattice(int max_lattice_size) {
     lattice_ = new CStateItem[max_lattice_size];
   }
 
-  for (int i = 0; i < max_lattice_size; ++ i) { lattice_[i].clear(); }
+  // only the start state is read before it is written, so it is the
+  // only one that work() clears
   return lattice_;
 }
 
@@ -627,6 +664,8 @@ CDepParser::work(const bool is_train,
                  const CDependencyParse & oracle_tree,
                  int nbest,
                  SCORE_TYPE *scores) {
+  PROFILE_PHASE(kDecode);
+  PROFILE_COUNT(kSentences, 1);
 #ifdef DEBUG
   clock_t total_start_time = clock();
 #endif
@@ -635,25 +674,27 @@ CDepParser::work(const bool is_train,
   const int max_round = length * 2 + 1;
   const int max_lattice_size = (kAgendaSize + 1) * max_round;
 
-  ASSERT(length < MAX_SENTENCE_SIZE,
-         "The size of sentence is too long.");
-
   CStateItem * lattice = GetLattice(max_lattice_size);
-  CStateItem * lattice_index[max_round];
+  // the states of each round start at lattice_index[round], and the
+  // last round ends at lattice_index[max_round]
+  lattice_index_.resize(max_round + 1);
+  CStateItem ** lattice_index = &lattice_index_[0];
   CStateItem * correct_state = lattice;
 
-  for (int i = 0; i < max_lattice_size; ++ i) {
-    lattice[i].len_ = length;
-  }
-
+  // the other states take the length from their sources when moved
   lattice[0].clear();
+  lattice[0].len_ = length;
   correct_state = lattice;
   lattice_index[0] = lattice;
   lattice_index[1] = lattice_index[0] + 1;
 
-  static CPackedScore packed_scores;
   TRACE("Initialising the decoding process ...");
 
+  // the cached scores are only valid for the weights of this sentence
+  s0_scores_.clear();
+  s1_scores_.clear();
+  next_scores_.clear();
+
   m_lCache.clear();
   for (int i = 0; i < length; ++ i) {
     m_lCache.push_back(CTaggedWord<CTag, TAG_SEPARATOR>(sentence[i].first,
@@ -670,6 +711,11 @@ CDepParser::work(const bool is_train,
   int round = 0;
   bool is_correct; // used for training to specify correct state in lattice
 
+  // training always searches with the compiled beam
+  const bool prune = !is_train && m_nBeamMargin > 0;
+  beam_.clear();
+  beam_.setWidth((is_train || m_nBeamWidth == 0) ? kAgendaSize : m_nBeamWidth);
+
   // loop with the next word to process in the sentence, 'round' represent the
   // generators, and the condidates should be inserted into the 'round + 1'
   for (round = 1; round < max_round; ++ round) {
@@ -683,38 +729,48 @@ CDepParser::work(const bool is_train,
       break;
     }
 
-    current_beam_size_ = 0;
+    beam_.clear();
     // loop over the generator states
     // std::cout << "round : " << round << std::endl;
     for (CStateItem * q = lattice_index[round - 1]; q != lattice_index[round];
         ++ q) {
       const CStateItem * generator = q;
-      packed_scores.reset();
-      GetOrUpdateStackScore(generator, packed_scores, action::kNoAction);
-      Transit(generator, packed_scores);
+      packed_scores_.reset();
+      PROFILE_PHASE(kScore);
+      GetOrUpdateStackScore(generator, packed_scores_, action::kNoAction);
+      PROFILE_STOP(kScore);
+      PROFILE_PHASE(kBeam);
+      Transit(generator, packed_scores_);
+    }
+
+    PROFILE_PHASE(kBeam);
+    if (prune) {
+      beam_.prune(m_nBeamMargin);
     }
+    const int beam_size = beam_.size();
 
-    for (unsigned i = 0; i < current_beam_size_; ++ i) {
-      const CScoredTransition& transition = m_kBestTransitions[i];
+    PROFILE_PHASE(kMove);
+    for (int i = 0; i < beam_size; ++ i) {
+      const CScoredTransition& transition = *beam_.item(i);
       CStateItem* target = lattice_index[round]+ i;
-      (*target) = (*transition.source);
-      // generate candidate state according to the states in beam
-      target->Move(transition.action);
+      // generate candidate state according to the states in beam, which
+      // shares the stack of its source
+      target->Move(transition.source, transition.action);
       target->score = transition.score;
-      target->previous_ = transition.source;
     }
 
-    lattice_index[round + 1] = lattice_index[round] + current_beam_size_;
+    PROFILE_STOP(kMove);
+    lattice_index[round + 1] = lattice_index[round] + beam_size;
 
     if (is_train) {
-      CStateItem next_correct_state(*correct_state);
-      next_correct_state.StandardMoveStep(oracle_tree
+      CStateItem next_correct_state;
+      next_correct_state.Move(correct_state,
+                              correct_state->StandardMove(oracle_tree
 #ifdef LABELED
-          , m_lCacheLabel
+                                  , m_lCacheLabel
 #endif // end for LABELED
-          );
+                                  ));
 
-      next_correct_state.previous_ = correct_state;
       is_correct = false;
 
       for (CStateItem *p = lattice_index[round]; p != lattice_index[round + 1];
@@ -765,6 +821,7 @@ CDepParser::work(const bool is_train,
   }
 
   TRACE("Output sentence");
+  PROFILE_PHASE(kOutput);
   std::sort(lattice_index[round - 1], lattice_index[round], StateMore);
   num_results = lattice_index[round] - lattice_index[round - 1];
 
@@ -791,7 +848,7 @@ CDepParser::parse(const CTwoStringVector & sentence,
                   CDependencyParse * retval,
                   int nBest,
                   SCORE_TYPE *scores) {
-  static CDependencyParse empty;
+  const CDependencyParse empty;
   assert(!m_bCoNLL);
 
   for (int i=0; i<nBest; ++i) {
@@ -803,6 +860,30 @@ CDepParser::parse(const CTwoStringVector & sentence,
   work(false, sentence, retval, empty, nBest, scores);
 }
 
+/*---------------------------------------------------------------
+ *
+ * setBeam - set the beam width and score margin for decoding
+ *
+ *--------------------------------------------------------------*/
+void
+CDepParser::setBeam(const unsigned &nWidth, const SCORE_TYPE &nMargin) {
+  ASSERT(nWidth <= AGENDA_SIZE,
+         "The beam width can not be larger than the agenda size " << AGENDA_SIZE);
+  ASSERT(nMargin >= 0, "The beam margin can not be negative");
+  m_nBeamWidth = nWidth;
+  m_nBeamMargin = nMargin;
+}
+
+/*---------------------------------------------------------------
+ *
+ * reserve - allocate the lattice for the longest sentence to come
+ *
+ *--------------------------------------------------------------*/
+void
+CDepParser::reserve(const unsigned &nLength) {
+  GetLattice((kAgendaSize + 1) * (nLength * 2 + 1));
+}
+
 /*---------------------------------------------------------------
  *
  * train - train the models with an example
@@ -830,7 +911,8 @@ CDepParser::train(const CDependencyParse &correct , int round) {
  *---------------------------------------------------------------*/
 void
 CDepParser::extract_features(const CDependencyParse &input) {
-  CStateItem item;
+  // each item is moved from the one before, whose stack it shares
+  std::vector<CStateItem> items(input.size() * 2 + 1);
   unsigned action;
   CPackedScoreType<SCORE_TYPE, action::kMax> empty;
 
@@ -850,16 +932,16 @@ CDepParser::extract_features(const CDependencyParse &input) {
   }
 
   // make standard item
-  item.clear(); item.len_ = input.size();
+  items[0].clear(); items[0].len_ = input.size();
   for (int i = 0; i < input.size() * 2; ++ i) {
-    unsigned action = item.StandardMove(input
+    unsigned action = items[i].StandardMove(input
 #ifdef LABELED
         , m_lCacheLabel
 #endif
         );
 
-    GetOrUpdateStackScore(&item, empty, action, 1, 1);
-    item.Move(action);
+    GetOrUpdateStackScore(&items[i], empty, action, 1, 1);
+    items[i + 1].Move(&items[i], action);
   }
 }
 
@@ -896,9 +978,9 @@ CDepParser::parse_conll(const CCoNLLInput & sentence,
                         int nBest,
                         SCORE_TYPE *scores) {
 
-  static CDependencyParse empty;
-  static CTwoStringVector input;
-  static CDependencyParse output[AGENDA_SIZE];
+  const CDependencyParse empty;
+  CTwoStringVector input;
+  CDependencyParse output[AGENDA_SIZE];
 
   assert(m_bCoNLL);
 
@@ -26,8 +26,8 @@ class CDepParser : public CDepParserBase {
 private:
   typedef CPackedScoreType<depparser::SCORE_TYPE, depparser::action::kMax> CPackedScore;
 
-  //! The scored transition beam.
-  depparser::CScoredTransition* m_kBestTransitions;
+  //! The scored transitions of a round, from which the beam is selected.
+  CAgendaSelect<depparser::CScoredTransition> beam_;
 
   //! The caches for input sentence.
   std::vector< CTaggedWord<CTag, TAG_SEPARATOR> > m_lCache;
@@ -51,16 +51,34 @@ private:
 
   //! The actual memory for storing the StateItems
   depparser::CStateItem * lattice_;
-  //! Control the current number of elements in beam.
-  int current_beam_size_;
-  int max_beam_size_;
   int max_lattice_size_;
+  //! The start of the states of each round in the lattice.
+  std::vector<depparser::CStateItem *> lattice_index_;
+  //! The scores of the actions from the current state.
+  CPackedScore packed_scores_;
+  //! The scores of the templates of S0 alone, S1 alone and the next
+  //! words for the sentence, by the node or the index of N0.
+  CScoreCache<depparser::CStackNode, CPackedScore> s0_scores_;
+  CScoreCache<depparser::CStackNode, CPackedScore> s1_scores_;
+  CScoreCache<int, CPackedScore> next_scores_;
 public:
   // constructor and destructor
   CDepParser(const std::string &sFeatureDBPath,
              bool bTrain,
              bool bCoNLL = false);
 
+  /**
+   * Create a decoder that shares the weights of a loaded parser. The
+   * decoder keeps its own lattice, beam and caches, so that each thread
+   * can parse with its own decoder against one copy of the model.
+   *
+   *  @param[in]  model     The decoding parser that owns the weights, which
+   *                        must outlive the decoder.
+   *  @param[in]  bCoNLL    Whether the decoder parses CoNLL input.
+   */
+  CDepParser(const CDepParser &model,
+             bool bCoNLL);
+
   ~CDepParser();
 
   /**
@@ -77,6 +95,24 @@ public:
              int nBest = 1,
              depparser::SCORE_TYPE *scores = 0);
 
+  /**
+   * Set the beam used when decoding.
+   *
+   *  @param[in]  nWidth    The number of states kept each round, at most
+   *                        AGENDA_SIZE; zero keeps AGENDA_SIZE.
+   *  @param[in]  nMargin   The score by which a state may trail the best
+   *                        state of its round; zero keeps them all.
+   */
+  void setBeam(const unsigned &nWidth,
+               const depparser::SCORE_TYPE &nMargin);
+
+  /**
+   * Allocate the lattice for sentences of up to the given length.
+   *
+   *  @param[in]  nLength   The number of words in the longest sentence.
+   */
+  void reserve(const unsigned &nLength);
+
   /**
    * Perform the training.
    *
@@ -130,7 +166,9 @@ private:
   template<typename CCoNLLInputOrOutput>
     void initCoNLLCache(const CCoNLLInputOrOutput &sentence);
 
-  int InsertIntoBeam(const depparser::CScoredTransition & transition);
+  void InsertIntoBeam(const depparser::CScoredTransition & transition) {
+    beam_.insertItem(&transition);
+  }
 
   inline void Transit(const depparser::CStateItem * item,
                       const CPackedScore& scores);
@@ -154,6 +192,24 @@ private:
                                     depparser::SCORE_TYPE amount=0,
                                     int round=0);
 
+  inline void GetOrUpdateS0Score(const depparser::CStackNode* S0,
+                                 CPackedScore& retval,
+                                 const unsigned& action,
+                                 depparser::SCORE_TYPE amount=0,
+                                 int round=0);
+
+  inline void GetOrUpdateS1Score(const depparser::CStackNode* S1,
+                                 CPackedScore& retval,
+                                 const unsigned& action,
+                                 depparser::SCORE_TYPE amount=0,
+                                 int round=0);
+
+  inline void GetOrUpdateNextScore(const int& N0id,
+                                   CPackedScore& retval,
+                                   const unsigned& action,
+                                   depparser::SCORE_TYPE amount=0,
+                                   int round=0);
+
   void UpdateScoresForStates(const depparser::CStateItem * output,
                              const depparser::CStateItem * correct,
                              depparser::SCORE_TYPE amount_add,
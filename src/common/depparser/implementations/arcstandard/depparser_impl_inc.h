@@ -6,6 +6,7 @@
 #include "pair_stream.h"
 
 #include "learning/perceptron/hashmap_score_packed.h"
+#include "learning/perceptron/score_cache.h"
 
 #include "bigram.h"
 #include "tuple2.h"
@@ -29,8 +29,9 @@ typedef int64_t SCORE_TYPE ;
 // the implementation supports the extraction of features as a command
 #define SUPPORT_FEATURE_EXTRACTION
 
-// The size of a sentence and the words
-const unsigned MAX_SENTENCE_SIZE = 256 ;
+// The size of a sentence and the words; the states grow with the
+// sentence, so that there is no limit on its size
+const unsigned MAX_SENTENCE_SIZE = UINT_MAX ;
 const unsigned MAX_SENTENCE_SIZE_BITS = 8 ;
 
 // normalise link size and the direction
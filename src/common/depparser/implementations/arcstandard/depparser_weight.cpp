@@ -35,6 +35,15 @@ void TARGET_LANGUAGE::depparser::CWeight::loadScores() {
       std::cerr << " empty." << std::endl; return;
    }
 
+   if (CBinaryModelReader::detect(m_sRecordPath)) {
+      file.close();
+      loadBinaryHeader();
+      iterate_templates(,.attachBinary(*m_binary););
+      ASSERT(m_binary->finished(), "The binary model has more score maps than the parser");
+      std::cerr << " done. (binary, " << double(clock()-time_start)/CLOCKS_PER_SEC << "s)" << std::endl;
+      return;
+   }
+
 #ifdef LABELED
    getline(file, s);
    ASSERT(s=="Dependency labels:", "Dependency labels not found in model file") ;
@@ -92,6 +101,36 @@ void TARGET_LANGUAGE::depparser::CWeight::saveScores() {
    std::cerr<<" done."<<std::endl;
 }
 
+/*---------------------------------------------------------------
+ *
+ * saveBinaryScores - save scores as a binary model for decoding,
+ *                    optionally quantized to 16 or 8 bits
+ *
+ *--------------------------------------------------------------*/
+
+void TARGET_LANGUAGE::depparser::CWeight::saveBinaryScores(const std::string &sPath, const unsigned &nValueBits) {
+   std::cerr<<"Saving binary scores..."; std::cerr.flush();
+   CBinaryModelWriter<SCORE_TYPE> model(sPath, nValueBits);
+   saveBinaryHeader(model);
+   iterate_templates(,.saveBinary(model););
+   model.close();
+   std::cerr<<" done ("<<model.values()<<" scores";
+   if (nValueBits) std::cerr<<" quantized to "<<nValueBits<<" bits, largest error "<<model.maxError();
+   std::cerr<<")."<<std::endl;
+}
+
+/*---------------------------------------------------------------
+ *
+ * freezeScores - replace the score maps with read only tables
+ *                of the averaged scores for decoding
+ *
+ *--------------------------------------------------------------*/
+
+void TARGET_LANGUAGE::depparser::CWeight::freezeScores() {
+   ASSERT(!m_bTrain, "Only the scores of a decoding model can be frozen");
+   iterate_templates(,.freeze(CScore<SCORE_TYPE>::eAverage););
+}
+
 /*--------------------------------------------------------------
  *
  * computeAverageFeatureWeights - compute average feature weights
@@ -374,6 +374,8 @@ public:
   // MEHTODS
   virtual void loadScores();
   virtual void saveScores();
+  void saveBinaryScores(const std::string &sPath, const unsigned &nValueBits=0);
+  void freezeScores();
   void computeAverageFeatureWeights(int round);
   SCORE_TYPE dotProduct(const CWeight &w);
 
@@ -2,45 +2,96 @@
 #ifndef DEPPARSER_ARC_STANDARD_STATE_H
 #define DEPPARSER_ARC_STANDARD_STATE_H
 
-class CStateItem {
-protected:
-  //! stack of words that are currently processed
-  std::vector<int> m_Stack;
-
-  //! index for the next word
-  int m_nNextWord;
+/**
+ * A word on the stack, with the dependents it has collected so far.
+ *
+ * Stack nodes are never modified once they are reachable from a state. A
+ * transition makes at most one new node, which points to the nodes below it
+ * in the stack of its predecessor, so that states share their stacks and a
+ * transition takes constant time and memory whatever the sentence length.
+ */
+struct CStackNode {
+  //! the index of the word
+  int id;
+
+  //! the leftmost and second-leftmost dependents
+  int l1, l2;
+
+  //! the rightmost and second-rightmost dependents
+  int r1, r2;
 
-  //! the lexical head for each word
-  int m_lHeads[MAX_SENTENCE_SIZE];
+#ifdef LABELED
+  //! the labels of the leftmost and rightmost dependents
+  unsigned long l1label, l2label, r1label, r2label;
+#endif
 
-  //! the leftmost dependency for each word (just for cache, temporary info)
-  int m_lDepsL[MAX_SENTENCE_SIZE];
+  //! the number of left and right dependents
+  int leftarity, rightarity;
 
-  //! the rightmost dependency for each word (just for cache, temporary info)
-  int m_lDepsR[MAX_SENTENCE_SIZE];
+  //! the sets of left and right dependency labels
+  CSetOfTags<CDependencyLabel> lefttags, righttags;
 
-  //! the second-leftmost dependency for each word
-  int m_lDepsL2[MAX_SENTENCE_SIZE];
+  //! the node below in the stack
+  const CStackNode * below;
 
-  //! the second-rightmost dependency for each word
-  int m_lDepsR2[MAX_SENTENCE_SIZE];
+  //! the size of the stack from this node down
+  int depth;
 
-  //! the number of left dependencies
-  int m_lDepNumL[MAX_SENTENCE_SIZE];
+  void clear(const int & word, const CStackNode * node) {
+    id = word;
+    l1 = l2 = r1 = r2 = DEPENDENCY_LINK_NO_HEAD;
+#ifdef LABELED
+    l1label = l2label = r1label = r2label = CDependencyLabel::NONE;
+#endif
+    leftarity = rightarity = 0;
+    lefttags.clear();
+    righttags.clear();
+    below = node;
+    depth = node ? node->depth + 1 : 1;
+  }
+};
 
-  //! the number of right dependencies
-  int m_lDepNumR[MAX_SENTENCE_SIZE];
+/**
+ * Nodes with the same word and dependents have the same features of their
+ * own, wherever they are in their stacks, so the scores of these features
+ * are cached by the word and the dependents, leaving out the nodes below.
+ */
+inline bool operator == (const CStackNode & x, const CStackNode & y) {
+  return x.id == y.id && x.l1 == y.l1 && x.l2 == y.l2 && x.r1 == y.r1 && x.r2 == y.r2
+#ifdef LABELED
+      && x.l1label == y.l1label && x.l2label == y.l2label
+      && x.r1label == y.r1label && x.r2label == y.r2label
+#endif
+      && x.leftarity == y.leftarity && x.rightarity == y.rightarity
+      && x.lefttags == y.lefttags && x.righttags == y.righttags;
+}
+
+inline unsigned long hash(const CStackNode & node) {
+  unsigned long retval = node.id;
+  retval = retval * 31 + node.l1;
+  retval = retval * 31 + node.r1;
+  retval = retval * 31 + node.l2;
+  retval = retval * 31 + node.r2;
+#ifdef LABELED
+  retval = retval * 31 + node.l1label;
+  retval = retval * 31 + node.r1label;
+#endif
+  retval = retval * 31 + node.leftarity;
+  retval = retval * 31 + node.rightarity;
+  return retval;
+}
 
-  //! the set of left tags
-  CSetOfTags<CDependencyLabel> m_lDepTagL[MAX_SENTENCE_SIZE];
+class CStateItem {
+protected:
+  //! the top of the stack of words that are currently processed
+  const CStackNode * m_Stack;
 
-  //! the set of right tags
-  CSetOfTags<CDependencyLabel> m_lDepTagR[MAX_SENTENCE_SIZE];
+  //! the node made by the last action; the stack of this or a later state
+  //! may point to it, so it must not be changed once the state is moved from
+  CStackNode m_Node;
 
-#ifdef LABELED
-  //! the label of each dependency link
-  unsigned long m_lLabels[MAX_SENTENCE_SIZE];
-#endif
+  //! index for the next word
+  int m_nNextWord;
 
 public:
   //! score of stack - predicting how potentially this is the correct one
@@ -61,6 +112,10 @@ public:
     clear();
   }
 
+  CStateItem(const CStateItem & item) {
+    (*this) = item;
+  }
+
   ~CStateItem() { }
 public:
   //! comparison
@@ -82,56 +137,29 @@ public:
 
   // propty
   inline int stacksize() const {
-    return m_Stack.size();
+    return m_Stack ? m_Stack->depth : 0;
   }
 
   inline bool stackempty() const {
-    return m_Stack.empty();
+    return m_Stack == 0;
   }
 
   inline int stacktop() const {
-    if (m_Stack.empty()) { return -1; }
-    return m_Stack.back();
+    return m_Stack ? m_Stack->id : -1;
   }
 
   inline int stack2top() const {
-    if (m_Stack.size() < 2) { return -1; }
-    return m_Stack[m_Stack.size() - 2];
-  }
-
-  inline int stackbottom() const {
-    assert(!m_Stack.empty());
-    return m_Stack.front();
-  }
-
-  inline int stackitem(const int & id) const {
-    assert (id < m_Stack.size());
-    return m_Stack[id];
-  }
-
-  inline int head(const int & id) const {
-    assert (id < m_nNextWord);
-    return m_lHeads[id];
-  }
-
-  inline int leftdep(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepsL[id];
-  }
-
-  inline int rightdep(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepsR[id];
+    return (m_Stack && m_Stack->below) ? m_Stack->below->id : -1;
   }
 
-  inline int left2dep(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepsL2[id];
+  //! the top node of the stack, 0 if the stack is empty
+  inline const CStackNode * stacktopnode() const {
+    return m_Stack;
   }
 
-  inline int right2dep(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepsR2[id];
+  //! the second top node of the stack, 0 if there is none
+  inline const CStackNode * stack2topnode() const {
+    return m_Stack ? m_Stack->below : 0;
   }
 
   inline int size() const {
@@ -140,77 +168,37 @@ public:
 
   inline bool terminated() const {
     return (last_action == action::kPopRoot
-            && m_Stack.empty()
+            && m_Stack == 0
             && m_nNextWord == len_);
   }
 
   inline bool complete() const {
-    return (m_Stack.size() == 1
+    return (stacksize() == 1
             && m_nNextWord == len_);
   }
-#ifdef LABELED
-  inline int label(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lLabels[id];
-  }
-#endif
-
-  inline int leftarity(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepNumL[id];
-  }
-
-  inline int rightarity(const int & id) const {
-    assert(id < m_nNextWord);
-    return m_lDepNumR[id];
-  }
-
-  inline const CSetOfTags<CDependencyLabel> &lefttagset(const int &id) const {
-    assert(id < m_nNextWord);
-    return m_lDepTagL[id];
-  }
-
-  inline const CSetOfTags<CDependencyLabel> &righttagset(const int &id) const {
-    assert(id < m_nNextWord);
-    return m_lDepTagR[id];
-  }
 
   void clear() {
     m_nNextWord = 0;
-    m_Stack.clear();
+    m_Stack = 0;
     score = 0;
     previous_ = 0;
     last_action = action::kNoAction;
-    ClearNext();
   }
 
+  // the stack may be this item's own node, which the copy takes over
   void operator = (const CStateItem &item) {
-    m_Stack = item.m_Stack;
+    m_Node = item.m_Node;
+    m_Stack = (item.m_Stack == &item.m_Node) ? &m_Node : item.m_Stack;
     m_nNextWord = item.m_nNextWord;
 
     last_action = item.last_action;
     score       = item.score;
     len_        = item.len_;
     previous_   = item.previous_;
-
-    for (int i = 0; i <= m_nNextWord; ++ i) { // only copy active word (including m_nNext)
-      m_lHeads[i] = item.m_lHeads[i];
-      m_lDepsL[i] = item.m_lDepsL[i];
-      m_lDepsR[i] = item.m_lDepsR[i];
-      m_lDepsL2[i] = item.m_lDepsL2[i];
-      m_lDepsR2[i] = item.m_lDepsR2[i];
-      m_lDepNumL[i] = item.m_lDepNumL[i];
-      m_lDepNumR[i] = item.m_lDepNumR[i];
-#ifdef LABELED
-      m_lLabels[i] = item.m_lLabels[i];
-      m_lDepTagL[i] = item.m_lDepTagL[i];
-      m_lDepTagR[i] = item.m_lDepTagR[i];
-#endif
-    }
   }
 
 //-----------------------------------------------------------------------------
-public:
+protected:
   // Perform Arc-Left operation in the arc-standard algorithm
   void ArcLeft(
 #ifdef LABELED
@@ -218,33 +206,39 @@ public:
 #endif
       ) {
     // At least, there must be two elements in the stack.
-    assert(m_Stack.size() > 1);
-    assert(m_lHeads[m_Stack.back()] == DEPENDENCY_LINK_NO_HEAD);
+    assert(stacksize() > 1);
 
-    int stack_size = m_Stack.size();
-    int top0 = m_Stack[stack_size - 1];
-    int top1 = m_Stack[stack_size - 2];
-
-    m_Stack.pop_back();
-    m_Stack.back() = top0;
-
-    m_lHeads[top1] = top0;
-    m_lDepNumL[top0] ++;
+    const CStackNode * top0 = m_Stack;
+    const CStackNode * top1 = m_Stack->below;
 
+    m_Node = (*top0);
+    m_Node.below = top1->below;
+    m_Node.depth = top1->depth;
+    m_Node.leftarity ++;
 
 #ifdef LABELED
-    m_lLabels[top1] = lab;
-    m_lDepTagL[top0].add(lab);
+    m_Node.lefttags.add(lab);
 #endif
 
-    if (m_lDepsL[top0] == DEPENDENCY_LINK_NO_HEAD) {
-      m_lDepsL[top0] = top1;
-    } else if (top1 < m_lDepsL[top0]) {
-      m_lDepsL2[top0] = m_lDepsL[top0];
-      m_lDepsL[top0] = top1;
-    } else if (top1 < m_lDepsL2[top0]) {
-      m_lDepsL2[top0] = top1;
+    if (m_Node.l1 == DEPENDENCY_LINK_NO_HEAD) {
+      m_Node.l1 = top1->id;
+#ifdef LABELED
+      m_Node.l1label = lab;
+#endif
+    } else if (top1->id < m_Node.l1) {
+      m_Node.l2 = m_Node.l1;
+      m_Node.l1 = top1->id;
+#ifdef LABELED
+      m_Node.l2label = m_Node.l1label;
+      m_Node.l1label = lab;
+#endif
+    } else if (top1->id < m_Node.l2) {
+      m_Node.l2 = top1->id;
+#ifdef LABELED
+      m_Node.l2label = lab;
+#endif
     }
+    m_Stack = &m_Node;
 
     last_action = action::EncodeAction(action::kArcLeft
 #ifdef LABELED
@@ -259,29 +253,37 @@ public:
       unsigned long lab
 #endif
       ) {
-    assert(m_Stack.size() > 1);
+    assert(stacksize() > 1);
 
-    int stack_size = m_Stack.size();
-    int top0 = m_Stack[stack_size - 1];
-    int top1 = m_Stack[stack_size - 2];
+    const CStackNode * top0 = m_Stack;
+    const CStackNode * top1 = m_Stack->below;
 
-    m_Stack.pop_back();
-    m_lHeads[top0] = top1;
-    m_lDepNumR[top1] ++;
+    m_Node = (*top1);
+    m_Node.rightarity ++;
 
 #ifdef LABELED
-    m_lLabels[top0] = lab;
-    m_lDepTagR[top1].add(lab);
+    m_Node.righttags.add(lab);
 #endif
 
-    if (m_lDepsR[top1] == DEPENDENCY_LINK_NO_HEAD) {
-      m_lDepsR[top1] = top0;
-    } else if (m_lDepsR[top1] < top0) {
-      m_lDepsR2[top1] = m_lDepsR[top1];
-      m_lDepsR[top1] = top0;
-    } else if (m_lDepsR2[top1] < top0) {
-      m_lDepsR2[top1] = top0;
+    if (m_Node.r1 == DEPENDENCY_LINK_NO_HEAD) {
+      m_Node.r1 = top0->id;
+#ifdef LABELED
+      m_Node.r1label = lab;
+#endif
+    } else if (m_Node.r1 < top0->id) {
+      m_Node.r2 = m_Node.r1;
+      m_Node.r1 = top0->id;
+#ifdef LABELED
+      m_Node.r2label = m_Node.r1label;
+      m_Node.r1label = lab;
+#endif
+    } else if (m_Node.r2 < top0->id) {
+      m_Node.r2 = top0->id;
+#ifdef LABELED
+      m_Node.r2label = lab;
+#endif
     }
+    m_Stack = &m_Node;
 
     last_action = action::EncodeAction(action::kArcRight
 #ifdef LABELED
@@ -292,46 +294,32 @@ public:
 
   // the shift action does pushing
   void Shift() {
-    m_Stack.push_back(m_nNextWord);
+    m_Node.clear(m_nNextWord, m_Stack);
+    m_Stack = &m_Node;
     m_nNextWord ++;
-    ClearNext();
     last_action = action::EncodeAction(action::kShift);
   }
 
   // this is used for the convenience of scoring and updating
   void PopRoot() {
-    assert(m_Stack.size() == 1
-           && m_lHeads[m_Stack.back()] == DEPENDENCY_LINK_NO_HEAD);
     // make sure only one root item in stack
-
-#ifdef LABELED
-    m_lLabels[m_Stack.back()] = CDependencyLabel::ROOT;
-#endif
-
+    assert(stacksize() == 1);
     last_action = action::EncodeAction(action::kPopRoot);
-    m_Stack.pop_back(); // pop it
+    m_Stack = 0; // pop it
   }
 
-  // the clear next action is used to clear the next word, used 
-  // with forwarding the next word index
-  void ClearNext() {
-    m_lHeads[m_nNextWord]   = DEPENDENCY_LINK_NO_HEAD;
-    m_lDepsL[m_nNextWord]   = DEPENDENCY_LINK_NO_HEAD;
-    m_lDepsL2[m_nNextWord]  = DEPENDENCY_LINK_NO_HEAD;
-    m_lDepsR[m_nNextWord]   = DEPENDENCY_LINK_NO_HEAD;
-    m_lDepsR2[m_nNextWord]  = DEPENDENCY_LINK_NO_HEAD;
-    m_lDepNumL[m_nNextWord] = 0;
-    m_lDepNumR[m_nNextWord] = 0;
-    m_lDepTagL[m_nNextWord].clear();
-    m_lDepTagR[m_nNextWord].clear();
-
-#ifdef LABELED
-    m_lLabels[m_nNextWord] = CDependencyLabel::NONE;
-#endif
-  }
+public:
+  // the move action makes this item the successor of the source item by
+  // the given action; the source item must stay in place while this item
+  // or its successors are in use
+  void Move(const CStateItem * source, const unsigned long &ac) {
+    m_Stack = source->m_Stack;
+    m_nNextWord = source->m_nNextWord;
+    score = source->score;
+    len_ = source->len_;
+    previous_ = source;
+    last_action = source->last_action;
 
-  // the move action is a simple call to do action according to the action code
-  void Move (const unsigned long &ac) {
     switch (action::DecodeUnlabeledAction(ac)) {
       case action::kNoAction: { return; }
       case action::kShift:    { Shift();  return; }
@@ -358,12 +346,12 @@ public:
 
 public:
   unsigned StandardMove(const CDependencyParse & tree,
-                        const std::vector<CDependencyLabel> & m_lCacheLabel) {
+                        const std::vector<CDependencyLabel> & m_lCacheLabel) const {
     if (terminated()) {
       return action::EncodeAction(action::kNoAction);
     }
 
-    int stack_size = m_Stack.size();
+    int stack_size = stacksize();
     if (0 == stack_size) {
       return action::EncodeAction(action::kShift);
     }
@@ -375,8 +363,8 @@ public:
       }
     }
     else {
-      int top0 = m_Stack[stack_size - 1];
-      int top1 = m_Stack[stack_size - 2];
+      int top0 = stacktop();
+      int top1 = stack2top();
 
       bool has_right_child = false;
       for (int i = m_nNextWord; i < tree.size(); ++ i) {
@@ -403,31 +391,56 @@ public:
     }
   }
 
-  void StandardMoveStep(const CDependencyParse & tree,
-                        const std::vector<CDependencyLabel> & m_lCacheLabel) {
-    unsigned action = StandardMove(tree, m_lCacheLabel);
-    Move(action);
-  }
-
   // we want to pop the root item after the whole tree done
   // on the one hand this seems more natural
   // on the other it is easier to score
   void StandardFinish() {
-    assert(m_Stack.size() == 0);
+    assert(m_Stack == 0);
   }
 
+  // the arcs are recovered from the actions on the way to this item,
+  // since no state keeps the whole tree
   void GenerateTree(const CTwoStringVector &input, CDependencyParse &output) const {
+    std::vector<int> heads(size(), DEPENDENCY_LINK_NO_HEAD);
+#ifdef LABELED
+    std::vector<unsigned long> labels(size(), CDependencyLabel::NONE);
+#endif
+    for (const CStateItem * item = this; item->previous_; item = item->previous_) {
+      const CStateItem * source = item->previous_;
+      switch (action::DecodeUnlabeledAction(item->last_action)) {
+        case action::kArcLeft:
+          heads[source->stack2top()] = source->stacktop();
+#ifdef LABELED
+          labels[source->stack2top()] = action::DecodeLabel(item->last_action);
+#endif
+          break;
+        case action::kArcRight:
+          heads[source->stacktop()] = source->stack2top();
+#ifdef LABELED
+          labels[source->stacktop()] = action::DecodeLabel(item->last_action);
+#endif
+          break;
+#ifdef LABELED
+        case action::kPopRoot:
+          labels[source->stacktop()] = CDependencyLabel::ROOT;
+          break;
+#endif
+        default:
+          break;
+      }
+    }
+
     output.clear();
     for (int i = 0; i < size(); ++ i) {
 #ifdef LABELED
       output.push_back(CLabeledDependencyTreeNode(input.at(i).first,
                                                   input.at(i).second,
-                                                  m_lHeads[i],
-                                                  CDependencyLabel(m_lLabels[i]).str()));
+                                                  heads[i],
+                                                  CDependencyLabel(labels[i]).str()));
 #else
       output.push_back(CDependencyTreeNode(input.at(i).first,
                                            input.at(i).second,
-                                           m_lHeads[i]));
+                                           heads[i]));
 #endif
     }
   }
@@ -437,9 +450,13 @@ public:
         << "-" << action::DecodeLabel(item.last_action)
         << " (" << item.score
         << "): (";
-    for (int i = 0; i < item.m_Stack.size(); ++ i) {
-      out << item.m_Stack[i];
-      if (i + 1 < item.m_Stack.size()) { out << "|"; }
+    std::vector<int> stack;
+    for (const CStackNode * node = item.m_Stack; node; node = node->below) {
+      stack.push_back(node->id);
+    }
+    for (int i = stack.size() - 1; i >= 0; -- i) {
+      out << stack[i];
+      if (i > 0) { out << "|"; }
     }
     out << ") ";
     out << item.m_nNextWord << std::endl;
@@ -454,6 +471,8 @@ struct CScoredTransition {
   unsigned action;
   //! The resulted in score.
   SCORE_TYPE score;
+
+  bool operator > (const CScoredTransition &other) const { return score > other.score; }
 };
 
 #endif  //  end for DEPPARSER_ARC_STANDARD_STATE_H
@@ -27,26 +27,6 @@ const CTag g_noneTag = CTag::NONE;
  *
  *==============================================================*/
 
-/*---------------------------------------------------------------
- *
- * getCrossLinkScore - get the score from a single dependency link
- *
- *---------------------------------------------------------------*/
-
-SCORE_TYPE CDepParser::getCrossLinkScore( const CSpan *span ) {
-
-#include "templates/define.cpp"
-
-   assert( span->getType()!=CSpan::BF ) ;
-
-   const int &left_index = span->getLeftBoundary() ;
-   const int &right_index = span->getRightBoundary() ;
-   head_index = span->getType() == CSpan::LF ? left_index : right_index ;
-   dep_index = span->getType() == CSpan::LF ? right_index : left_index ;
-
-   return getCrossLinkScore(head_index, dep_index);
-}
-
 /*---------------------------------------------------------------
  *
  * getCrossLinkScore - get the score from a single dependency link
@@ -89,8 +69,6 @@ SCORE_TYPE CDepParser::getCrossLinkScore( int head_index, int dep_index ) {
 
 void CDepParser::updateCrossLinkScore( int head_index, int dep_index, const CDependencyParse &tree, SCORE_UPDATE method, int round ) {
 
-   CSpan::SPAN_TYPE sptype = head_index < dep_index ? CSpan::LF : CSpan::RF ;
-
 #include "templates/shared.cpp"
 #include "templates/update.cpp"
 
@@ -222,14 +200,16 @@ void CDepParser::updateScores(const CDependencyParse & parsed , const CDependenc
  *
  *---------------------------------------------------------------*/
 
-void generate(const CSpan &span, const CTwoStringVector &sentence, CDepParser *depparser, CDependencyParse &retval) {
+void generate(const CSpanChart &chart, const CTwoStringVector &sentence, CDependencyParse &retval) {
    retval.clear() ;
-   if (!span.isActive()) return;
-   assert ( span.getLeftBoundary() == 0 && span.getRightBoundary() == sentence.size() ) ;
+   const int length = sentence.size() ;
+   if (!chart.isActive(0, length, CSpanChart::RF)) return;
+   std::vector<int> links(length+1, DEPENDENCY_LINK_NO_HEAD);
+   chart.getLinks(0, length, CSpanChart::RF, links);
    bool bFoundHead = false;
-   for ( int i=0; i<sentence.size(); ++i ) {
-      int head = span.getLink(i);
-      if (head==sentence.size()) {
+   for ( int i=0; i<length; ++i ) {
+      int head = links[i];
+      if (head==length) {
          head = DEPENDENCY_LINK_NO_HEAD;
          assert( !bFoundHead );
          bFoundHead = true;
@@ -242,6 +222,10 @@ void generate(const CSpan &span, const CTwoStringVector &sentence, CDepParser *d
  *
  * parse - do dependency parsing to a sentence
  *
+ * The score of every link is computed once before the chart is
+ * built, and the chart only adds up scores, looking at the spans
+ * on either side of a split in contiguous memory.
+ *
  * Returns: makes a new instance of CDependencyParse
  *
  *--------------------------------------------------------------*/
@@ -250,27 +234,18 @@ void CDepParser::parse( const CTwoStringVector &sentence , CDependencyParse *ret
 
    clock_t total_start_time = clock();
    const int length = sentence.size() ; // length of the sentence
+   // note that the end of sentence is extended with the special EOS token; therefore length+1
+   const int size = length + 1 ;
 
-   static CSpan chart[depparser::MAX_SENTENCE_SIZE][depparser::MAX_SENTENCE_SIZE][3];
-
-   int span_length, left_length ;
-   int span_starting_index ;
-
-   CSpan *left_span, *right_span, *total_span ;
-   CSpan temp_span;
+   int span_length, split ;
+   int span_starting_index, span_ending_index ;
+   int head, dep ;
 
    assert(length<MAX_SENTENCE_SIZE);
    assert(nBest==1);
 
    TRACE("Initialising the decoding process...");
-   // clear all spans from length 3 to sentence len + 1
-   // note that the end of sentence is extended with the special EOS token; therefore length+1
-   for ( span_length = 3; span_length <= length + 1; ++span_length )
-      for ( span_starting_index = 0; span_starting_index <= length + 1 - span_length; ++span_starting_index ) {
-      chart[span_starting_index][span_length][CSpan::LF].clear();
-      chart[span_starting_index][span_length][CSpan::RF].clear();
-      chart[span_starting_index][span_length][CSpan::BF].clear();
-   }
+   m_Chart.reset(size);
 
    // put the sentence into a cache
    m_lCache.clear();
@@ -278,166 +253,116 @@ void CDepParser::parse( const CTwoStringVector &sentence , CDependencyParse *ret
       m_lCache.push_back( CTaggedWord<CTag, TAG_SEPARATOR>(sentence[index].first , sentence[index].second) );
    m_lCache.push_back( CTaggedWord<CTag, TAG_SEPARATOR>( "", CTag(CTag::SENTENCE_END).str() ) ); // EOS is appended to the tail of sentence
 
+   // score the links; a link ruled out by the supertags is inactive,
+   // and only the last word can be linked to EOS, by a binary span
+   m_lArcScores.assign(size*size, CSpanChart::inactive());
+   for ( head = 0; head < size; ++head ) {
+      for ( dep = 0; dep < size; ++dep ) {
+         if ( dep == head || ( dep == length && head+1 != length ) )
+            continue;
+         if ( head == length || dep == length || m_supertags == 0 || m_supertags->getSuperTag(head, dep) )
+            m_lArcScores[head*size+dep] = getCrossLinkScore(head, dep);
+      }
+   }
+
    TRACE("Decoding started");
 
    // initialise binary
    // note that because of the special EOS token, span_start reaches length-1
    for ( span_starting_index = 0; span_starting_index < length; ++span_starting_index ) {
-      total_span = &(chart[span_starting_index][2][CSpan::LF]) ;
-      if ( span_starting_index+1 == length || m_supertags == 0 || m_supertags->getSuperTag(span_starting_index, span_starting_index+1) ) {
-         total_span->setBinarySpan(span_starting_index, CSpan::LF);
-         total_span->score() = getCrossLinkScore(total_span);
-      }
-      else
-         total_span->clear();
-
-      total_span = &(chart[span_starting_index][2][CSpan::RF]) ;
-      if ( span_starting_index+1 == length || m_supertags == 0 || m_supertags->getSuperTag(span_starting_index+1, span_starting_index) ) {
-         total_span->setBinarySpan(span_starting_index, CSpan::RF);
-         total_span->score() = getCrossLinkScore(total_span);
-      }
-      else
-         total_span->clear();
-
-      total_span = &(chart[span_starting_index][2][CSpan::BF]) ;
-      total_span->setBinarySpan(span_starting_index, CSpan::BF);
-      total_span->score() = 0 ;
+      span_ending_index = span_starting_index + 1;
+      if ( m_lArcScores[span_starting_index*size+span_ending_index] != CSpanChart::inactive() )
+         m_Chart.set(span_starting_index, span_ending_index, CSpanChart::LF, CSpanChart::BINARY, 0, m_lArcScores[span_starting_index*size+span_ending_index]);
+      if ( m_lArcScores[span_ending_index*size+span_starting_index] != CSpanChart::inactive() )
+         m_Chart.set(span_starting_index, span_ending_index, CSpanChart::RF, CSpanChart::BINARY, 0, m_lArcScores[span_ending_index*size+span_starting_index]);
+      m_Chart.set(span_starting_index, span_ending_index, CSpanChart::BF, CSpanChart::BINARY, 0, 0);
    }
 
    // compute multiple
    // build spans from the smaller spans up to the biggest one
    // note that the span length can be sentence length+1 (EOS)
-   for ( span_length = 3 ; span_length <= length + 1 ; ++ span_length ) {
+   for ( span_length = 3 ; span_length <= size ; ++ span_length ) {
+
+      for ( span_starting_index = 0 ; span_starting_index + span_length <= size ; ++ span_starting_index ) {
+
+         span_ending_index = span_starting_index + span_length - 1;
 
-      // the start index is the end index of the last word
-      for ( left_length = 2 ; left_length < span_length ; ++ left_length ) {
+         // the minimal spans on the left and the spans on the right of a split
+         const SCORE_TYPE *left_lf = m_Chart.minimalFrom(span_starting_index, CSpanChart::LF);
+         const SCORE_TYPE *left_bf = m_Chart.minimalFrom(span_starting_index, CSpanChart::BF);
+         const SCORE_TYPE *left_rf = m_Chart.minimalFrom(span_starting_index, CSpanChart::RF);
+         const SCORE_TYPE *right_lf = m_Chart.scoresTo(span_ending_index, CSpanChart::LF);
+         const SCORE_TYPE *right_bf = m_Chart.scoresTo(span_ending_index, CSpanChart::BF);
+         const SCORE_TYPE *right_rf = m_Chart.scoresTo(span_ending_index, CSpanChart::RF);
 
-         // for each generator
-         for ( span_starting_index = 0 ; span_starting_index <= length + 1 - span_length ; ++ span_starting_index ) {
+         // the covering links, there is no LF for the spans that include EOS
+         const bool bEOS = span_ending_index == length;
+         const SCORE_TYPE left_link = bEOS ? CSpanChart::inactive() : m_lArcScores[span_starting_index*size+span_ending_index];
+         const SCORE_TYPE right_link = m_lArcScores[span_ending_index*size+span_starting_index];
 
-            int span_ending_index = span_starting_index + span_length - 1;
+         SCORE_TYPE best[CSpanChart::SPAN_TYPES];
+         CSpanChart::SPAN_RULE rule[CSpanChart::SPAN_TYPES];
+         int best_split[CSpanChart::SPAN_TYPES];
+         for ( int type = 0; type < CSpanChart::SPAN_TYPES; ++type ) {
+            best[type] = CSpanChart::inactive();
+            rule[type] = CSpanChart::NONE;
+            best_split[type] = 0;
+         }
+         SCORE_TYPE score, linked;
+
+#define update_span(type, span_rule, span_score) if ( span_score > best[CSpanChart::type] ) { best[CSpanChart::type] = span_score; rule[CSpanChart::type] = CSpanChart::span_rule; best_split[CSpanChart::type] = split; }
+
+         for ( split = span_starting_index + 1 ; split < span_ending_index ; ++ split ) {
 
             // LF + LF = LF
-            left_span = &(chart[span_starting_index][left_length][CSpan::LF]) ;
-            right_span = &(chart[span_starting_index+left_length-1][span_length-left_length+1][CSpan::LF]) ;
-            total_span = &(chart[span_starting_index][span_length][CSpan::LF]) ;
-
-            if ( left_span->isActive() && right_span->isActive() && left_span->isMinimal() ) {
-               if ( !total_span->isActive() || left_span->score() + right_span->score() > total_span->score() ) {
-                  total_span->setCombinedSpan(*left_span, *right_span, CSpan::LF) ;
-                  total_span->score() = left_span->score() + right_span->score() ;
-               }
-            }
+            score = left_lf[split] + right_lf[split];
+            update_span(LF, LF_LF, score);
 
             // LF + BF = LF / BF / RF for the spans that do not include EOS
-            //           RF for the cover EOS span
-            left_span = &(chart[span_starting_index][left_length][CSpan::LF]) ;
-            right_span = &(chart[span_starting_index+left_length-1][span_length-left_length+1][CSpan::BF]) ;
-
-            if ( left_span->isActive() && right_span->isActive() && left_span->isMinimal() ) {
-
-               // for a span that does not include the end of the sentence
-               if ( span_ending_index < length ) {
-
-                  // LF
-                  if ( m_supertags == 0 || m_supertags->getSuperTag(span_starting_index, span_ending_index) ) {
-                     total_span = &(chart[span_starting_index][span_length][CSpan::LF]) ;
-                     temp_span.setCombinedSpan(*left_span, *right_span, CSpan::LF) ;
-                     temp_span.score() = left_span->score() + right_span->score() ;
-                     temp_span.score() += getCrossLinkScore(&temp_span) ;
-                     if ( !total_span->isActive() || temp_span.score() > total_span->score() ) {
-                        total_span->copy( temp_span ) ;
-                     }
-                  }
-               }
-
-               // BF
-               total_span = &(chart[span_starting_index][span_length][CSpan::BF]) ;
-               if ( !total_span->isActive() || left_span->score() + right_span->score() > total_span->score() ) {
-                  total_span->setCombinedSpan(*left_span, *right_span, CSpan::BF) ;
-                  total_span->score() = left_span->score() + right_span->score() ;
-               }
-
-               // RF
-               // When adding right link to EOS, make sure on one has linked to it.
-               if ( ( span_ending_index < length || !right_span->isRightLinkedTo() ) &&
-                    ( span_ending_index == length || m_supertags == 0 || m_supertags->getSuperTag(span_ending_index, span_starting_index) )
-                  ) {
-                  total_span = &(chart[span_starting_index][span_length][CSpan::RF]) ;
-                  temp_span.setCombinedSpan(*left_span, *right_span, CSpan::RF) ;
-                  temp_span.score() = left_span->score() + right_span->score() ;
-                  temp_span.score() += getCrossLinkScore(&temp_span) ;
-                  if ( !total_span->isActive() || temp_span.score() > total_span->score() ) {
-                     total_span->copy( temp_span ) ;
-                  }
-               }
+            //           BF / RF for the cover EOS span
+            score = left_lf[split] + right_bf[split];
+            linked = score + left_link;
+            update_span(LF, LF_BF, linked);
+            update_span(BF, LF_BF, score);
+            // When adding right link to EOS, make sure on one has linked to it.
+            if ( !bEOS || !m_Chart.isRightLinkedTo(split, span_ending_index, CSpanChart::BF) ) {
+               linked = score + right_link;
+               update_span(RF, LF_BF, linked);
             }
 
             // BF + RF = LF / BF / RF for the spans that do not include EOS
             //           RF for the cover EOS span
-            left_span = &(chart[span_starting_index][left_length][CSpan::BF]) ;
-            right_span = &(chart[span_starting_index+left_length-1][span_length-left_length+1][CSpan::RF]) ;
-            //           for a span that does not include the end of the sentence
-            if ( left_span->isActive() && right_span->isActive() && left_span->isMinimal() ) {
-
-               // for a span that does not include the end of the sentence
-               if ( span_ending_index < length ) {
-
-                  // LF
-                  if ( m_supertags == 0 || m_supertags->getSuperTag(span_starting_index, span_ending_index) ) {
-                     total_span = &(chart[span_starting_index][span_length][CSpan::LF]) ;
-                     temp_span.setCombinedSpan(*left_span, *right_span, CSpan::LF) ;
-                     temp_span.score() = left_span->score() + right_span->score() ;
-                     temp_span.score() += getCrossLinkScore(&temp_span) ;
-                     if ( !total_span->isActive() || temp_span.score() > total_span->score() ) {
-                        total_span->copy( temp_span ) ;
-                     }
-                  }
-
-                  // BF
-                  total_span = &(chart[span_starting_index][span_length][CSpan::BF]) ;
-                  if ( !total_span->isActive() || left_span->score() + right_span->score() > total_span->score() ) {
-                     total_span->setCombinedSpan(*left_span, *right_span, CSpan::BF) ;
-                     total_span->score() = left_span->score() + right_span->score() ;
-                  }
-               }
-
-               // RF
-               // When adding right link to EOS, make sure on one has linked to it.
-               if ( ( span_ending_index < length || !right_span->isRightLinkedTo() ) &&
-                    ( span_ending_index == length || m_supertags == 0 || m_supertags->getSuperTag(span_ending_index, span_starting_index) )
-                  ) {
-                  total_span = &(chart[span_starting_index][span_length][CSpan::RF]) ;
-                  temp_span.setCombinedSpan(*left_span, *right_span, CSpan::RF) ;
-                  temp_span.score() = left_span->score() + right_span->score() ;
-                  temp_span.score() += getCrossLinkScore(&temp_span) ;
-                  if ( !total_span->isActive() || temp_span.score() > total_span->score() ) {
-                     total_span->copy( temp_span ) ;
-                  }
-               }
+            score = left_bf[split] + right_rf[split];
+            linked = score + left_link;
+            update_span(LF, BF_RF, linked);
+            if ( !bEOS ) {
+               update_span(BF, BF_RF, score);
+            }
+            if ( !bEOS || !m_Chart.isRightLinkedTo(split, span_ending_index, CSpanChart::RF) ) {
+               linked = score + right_link;
+               update_span(RF, BF_RF, linked);
             }
 
             // RF + RF = RF
-            left_span = &(chart[span_starting_index][left_length][CSpan::RF]) ;
-            right_span = &(chart[span_starting_index+left_length-1][span_length-left_length+1][CSpan::RF]) ;
-            total_span = &(chart[span_starting_index][span_length][CSpan::RF]) ;
-
-            if ( left_span->isActive() && right_span->isActive() && left_span->isMinimal() ) {
-               if ( !total_span->isActive() || left_span->score() + right_span->score() > total_span->score() ) {
-                  total_span->setCombinedSpan(*left_span, *right_span, CSpan::RF) ;
-                  total_span->score() = left_span->score() + right_span->score() ;
-               }
-            }
-         } // for span_starting_index
+            score = left_rf[split] + right_rf[split];
+            update_span(RF, RF_RF, score);
+
+         } // for split
+
+#undef update_span
+
+         for ( int type = 0; type < CSpanChart::SPAN_TYPES; ++type )
+            if ( rule[type] != CSpanChart::NONE )
+               m_Chart.set(span_starting_index, span_ending_index, static_cast<CSpanChart::SPAN_TYPE>(type), rule[type], best_split[type], best[type]);
 
-      } // for left_length
+      } // for span_starting_index
 
    } // for span_length
 
    TRACE("Outputing sentence");
-   generate( chart[ 0 ][ length+1 ][ CSpan::RF ] , sentence , this , *retval ) ;
-   if (scores) scores[ 0 ] = chart[ 0 ][ length+1 ][ CSpan::RF ].score() ;
-   TRACE("Done, the highest score is: " << chart[ 0 ][ length ][ CSpan::RF ].score() ) ;
+   generate( m_Chart , sentence , *retval ) ;
+   if (scores) scores[ 0 ] = m_Chart.score( 0, length, CSpanChart::RF ) ;
+   TRACE("Done, the highest score is: " << m_Chart.score( 0, length, CSpanChart::RF ) ) ;
    TRACE("The total time spent: " << double(clock() - total_start_time)/CLOCKS_PER_SEC) ;
 }
 
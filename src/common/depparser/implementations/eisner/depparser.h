@@ -12,6 +12,7 @@
 #ifndef _DEPPARSER_IMPL_H
 #define _DEPPARSER_IMPL_H
 
+#include <limits>
 #include "depparser_base.h"
 
 /*===============================================================
@@ -49,6 +50,9 @@ private:
    bool m_bScoreModified;
    int m_nScoreIndex;
 
+   depparser::CSpanChart m_Chart;
+   std::vector<depparser::SCORE_TYPE> m_lArcScores; // [head][dep] for the sentence being parsed
+
 public:
    // constructor and destructor
    CDepParser( const std::string &sFeatureDBPath , bool bTrain , bool bCoNLL=false ) : CDepParserBase(sFeatureDBPath, bTrain, bCoNLL) {
@@ -82,7 +86,6 @@ private:
    enum SCORE_UPDATE {eAdd=0, eSubtract};
 
    // get the global score for a parsed sentence or section
-   inline depparser::SCORE_TYPE getCrossLinkScore(const depparser::CSpan *span);
    inline depparser::SCORE_TYPE getCrossLinkScore(const int head, const int dep);
 
    // update the built-in weight std::vector for this feature object specifically
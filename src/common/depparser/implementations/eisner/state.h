@@ -12,184 +12,117 @@
 
 /*===============================================================
  *
- * CSpan - span definition
+ * CSpanChart - the chart of spans for a sentence
+ *
+ * A span keeps its score, how it was made and whether its right
+ * word has got a dependent, but not its links, which are only
+ * followed back from the span that covers the sentence when the
+ * parse is output. The chart is sized to the sentence.
+ *
+ * The scores are kept twice, so that the spans that are combined
+ * into a span are contiguous in memory as the split point moves:
+ * those of minimal spans by their left boundary for the left of
+ * a combination, and those of all spans by their right boundary
+ * for the right of it. The score of a span that is not active
+ * is minus infinity, so that no combination with it is ever
+ * better than any other.
  *
  *==============================================================*/
 
-class CSpan {
+class CSpanChart {
 
 public:
-   enum SPAN_TYPE { LF=0 /*left free*/, RF=1 /*right free*/, BF=2 /*both free*/};
+   enum SPAN_TYPE { LF=0 /*left free*/, RF=1 /*right free*/, BF=2 /*both free*/, SPAN_TYPES };
+   // how a span is made; LF_BF and BF_RF add the covering link for LF and RF spans
+   enum SPAN_RULE { NONE=0, BINARY, LF_LF, LF_BF, BF_RF, RF_RF };
 
 protected:
-   int m_nLeft;                     // the left boundary
-   int m_nRight;                    // the right boundary
-   int m_lLinks[MAX_SENTENCE_SIZE]; // the dependency links
-   SPAN_TYPE m_nType;               // the type of span, see SPAN_TYPE
-   bool m_bMinimal;                 // minimal span
-   bool m_bActive;                  // active means being useful
-   SCORE_TYPE m_nScore;             // score
-   int m_nLeftArity;                // the arity of the left word 
-   int m_nRightArity;               // the arity of the right word
+   int m_nSize;                                      // the number of words including EOS
+   std::vector<SCORE_TYPE> m_lMinimal[SPAN_TYPES];   // [left][right] the scores of minimal spans
+   std::vector<SCORE_TYPE> m_lScore[SPAN_TYPES];     // [right][left] the scores of all spans
+   std::vector<int> m_lSplit[SPAN_TYPES];            // [left][right] the word shared by the two smaller spans
+   std::vector<unsigned char> m_lRule[SPAN_TYPES];   // [left][right] see SPAN_RULE
+   std::vector<unsigned char> m_lRightLinked[SPAN_TYPES]; // [left][right] whether the right word has a dependent
 
 public:
-   CSpan() { clear(); }
-   virtual ~CSpan() {};
+   CSpanChart() : m_nSize(0) { }
+   virtual ~CSpanChart() {}
 
 public:
-   inline int getLeftBoundary() const { return m_nLeft; }
-   inline int getRightBoundary() const { return m_nRight; }
-   inline SPAN_TYPE getType()const  { return m_nType; }
-   inline int getLink( int index ) const { return m_lLinks[index]; }
-   inline int getHeadArity() const { assert(m_nType!=BF); return m_nType==LF ? m_nLeftArity : m_nRightArity; }
-   inline bool isMinimal() const { return m_bMinimal; }
-   inline bool isActive() const { return m_bActive; }
-   // the the score which can be assigned
-   inline SCORE_TYPE &score() { return m_nScore; }
-   inline bool isRightLinkedTo() const { return m_nRightArity != 0; }
-
-private:
-   // this method simply combines two spans
-   // it does not set the type of the new span
-   // nor does it add any links on it
-   // it is only called as private method
-   void setConcatenateSpan(const CSpan &left, const CSpan &right) {
+   static inline SCORE_TYPE inactive() { return -std::numeric_limits<SCORE_TYPE>::infinity(); }
 
-      static int j;
-      m_nLeft = left.m_nLeft;
-      m_nRight = right.m_nRight;
-      for ( j=m_nLeft; j<left.m_nRight; j++ )
-         m_lLinks[j] = left.m_lLinks[j];
-      if ( left.m_lLinks[left.m_nRight] != DEPENDENCY_LINK_NO_HEAD ) {
-         assert( right.m_lLinks[right.m_nLeft] == DEPENDENCY_LINK_NO_HEAD );
-         m_lLinks[left.m_nRight] = left.m_lLinks[left.m_nRight];
+   // clear the chart for a sentence of size words including EOS
+   void reset(const int &size) {
+      m_nSize = size;
+      for (int type=0; type<SPAN_TYPES; ++type) {
+         m_lMinimal[type].assign(size*size, inactive());
+         m_lScore[type].assign(size*size, inactive());
+         m_lSplit[type].assign(size*size, 0);
+         m_lRule[type].assign(size*size, NONE);
+         m_lRightLinked[type].assign(size*size, 0);
       }
-      else {
-         assert( right.m_lLinks[right.m_nLeft] != DEPENDENCY_LINK_NO_HEAD );
-         m_lLinks[right.m_nLeft] = right.m_lLinks[right.m_nLeft];
-      }
-      for ( j=right.m_nLeft+1; j<=m_nRight; j++ )
-         m_lLinks[j] = right.m_lLinks[j];
-      m_bActive = true;
-      m_nLeftArity = left.m_nLeftArity;
-      m_nRightArity = right.m_nRightArity;
-   }
-   // this method adds a covering link modifying minimal
-   void addCoveringLink(SPAN_TYPE type) {
-      if ( type == LF ) {      // add link to result in a new LF
-         m_lLinks[m_nRight] = m_nLeft;
-         m_bMinimal = true;
-         m_nLeftArity ++;
-      }
-      else if ( type == RF ) { // add link to result in a new RF
-         m_lLinks[m_nLeft] = m_nRight;
-         m_bMinimal = true;
-         m_nRightArity ++;
-      }
-      else {                   // do not add covering link
-         m_bMinimal = false;
-      }
-      m_nType = type;          // according to desired type
    }
 
-public:
-   // make the span a basic binary span - this method does not assign scores!
-   void setBinarySpan(int start, SPAN_TYPE type) { 
-      m_nLeft = start; 
-      m_nRight = start + 1;
-      if ( type == LF ) {
-         m_lLinks[m_nLeft] = DEPENDENCY_LINK_NO_HEAD; 
-         m_lLinks[m_nRight] = m_nLeft; 
-         m_nLeftArity = 1;
-         m_nRightArity = 0;
-      }
-      else if ( type == RF ) {
-         m_lLinks[m_nLeft] = m_nRight;
-         m_lLinks[m_nRight] = DEPENDENCY_LINK_NO_HEAD;
-         m_nLeftArity = 0;
-         m_nRightArity = 1;
+   inline int size() const { return m_nSize; }
+   inline bool isActive(const int &left, const int &right, const SPAN_TYPE &type) const { return m_lRule[type][left*m_nSize+right] != NONE; }
+   inline SCORE_TYPE score(const int &left, const int &right, const SPAN_TYPE &type) const { return m_lScore[type][right*m_nSize+left]; }
+   inline bool isRightLinkedTo(const int &left, const int &right, const SPAN_TYPE &type) const { return m_lRightLinked[type][left*m_nSize+right]; }
+
+   // the scores of the minimal spans from left, indexed by their right boundary
+   inline const SCORE_TYPE *minimalFrom(const int &left, const SPAN_TYPE &type) const { return &m_lMinimal[type][left*m_nSize]; }
+   // the scores of the spans to right, indexed by their left boundary
+   inline const SCORE_TYPE *scoresTo(const int &right, const SPAN_TYPE &type) const { return &m_lScore[type][right*m_nSize]; }
+
+   // set a span that is made by rule, split at the given word unless binary
+   void set(const int &left, const int &right, const SPAN_TYPE &type, const SPAN_RULE &rule, const int &split, const SCORE_TYPE &score) {
+      assert(rule != NONE);
+      const int index = left*m_nSize+right;
+      bool bMinimal, bRightLinked;
+      if (rule == BINARY) {
+         bMinimal = true;
+         bRightLinked = type == RF;
       }
       else {
-         m_lLinks[m_nLeft] = DEPENDENCY_LINK_NO_HEAD;
-         m_lLinks[m_nRight] = DEPENDENCY_LINK_NO_HEAD;
-         m_nLeftArity = 0;
-         m_nRightArity = 0;
+         bMinimal = type != BF && (rule == LF_BF || rule == BF_RF);
+         bRightLinked = (type == RF && bMinimal) || isRightLinkedTo(split, right, rule == LF_BF ? BF : rule == LF_LF ? LF : RF);
       }
-      m_nType = type;
-      m_bMinimal = true;
-      m_bActive = true;
+      m_lScore[type][right*m_nSize+left] = score;
+      m_lMinimal[type][index] = bMinimal ? score : inactive();
+      m_lSplit[type][index] = split;
+      m_lRule[type][index] = rule;
+      m_lRightLinked[type][index] = bRightLinked;
    }
-   // make the span a combined type - this method does not assign scores!
-   void setCombinedSpan(const CSpan &left, const CSpan &right, SPAN_TYPE type) {
-      assert( left.m_nRight == right.m_nLeft );
-      assert( left.m_bActive && right.m_bActive );
-      assert( left.m_bMinimal );
-      static int j;
-      // ====== Left is LF ======
-      if ( left.m_nType == LF ) { 
-         if ( right.m_nType == LF ) {     
-            // LF + LF = LF
-            setConcatenateSpan(left, right);
-            m_nType = LF;
-            m_bMinimal = false;
-         }
-         else if ( right.m_nType == RF ) { 
-            // LF + RF = None
-            clear();
-         }
-         else {                            
-            // LF + BF = LF / RF / BF
-            setConcatenateSpan(left, right);
-            addCoveringLink(type);
-         }
-      }
-      // ====== Left is BF ======
-      else if ( left.m_nType == BF ) { 
-         if ( right.m_nType == RF ) {
-            // BF + RF = LF / RF / BF
-            setConcatenateSpan(left, right);
-            m_nType = type; // according to desired type
-            addCoveringLink(type);
-         }
-         else{
-            // BF + BF / LF = None
-            clear();
-         }
-      }
-      // ====== Left is RF ======
-      else {
-         if ( right.m_nType == RF ) {
-            // RF + RF = RF
-            setConcatenateSpan(left, right);
-            m_nType = RF;
-            m_bMinimal = false;
-         }
-         else {
-            // RF + LF / BF = None
-            clear();
-         }
+
+   // the links of the words in a span, following the spans it is made from
+   void getLinks(const int &left, const int &right, const SPAN_TYPE &type, std::vector<int> &links) const {
+      const int index = left*m_nSize+right;
+      const int split = m_lSplit[type][index];
+      assert(m_lRule[type][index] != NONE);
+      switch (m_lRule[type][index]) {
+      case BINARY:
+         break;
+      case LF_LF:
+         getLinks(left, split, LF, links);
+         getLinks(split, right, LF, links);
+         return;
+      case RF_RF:
+         getLinks(left, split, RF, links);
+         getLinks(split, right, RF, links);
+         return;
+      case LF_BF:
+         getLinks(left, split, LF, links);
+         getLinks(split, right, BF, links);
+         break;
+      case BF_RF:
+         getLinks(left, split, BF, links);
+         getLinks(split, right, RF, links);
+         break;
       }
+      // the covering link
+      if (type == LF)
+         links[right] = left;
+      else if (type == RF)
+         links[left] = right;
    }
-   // clear a span
-   inline void clear() { 
-      m_bActive = false ; 
-   }
-   inline void copy( const CSpan &span ) {
-      m_nLeft = span.m_nLeft; 
-      m_nRight = span.m_nRight;
-      m_nType = span.m_nType;
-      m_bMinimal = span.m_bMinimal;
-      m_bActive = span.m_bActive;
-      m_nLeftArity = span.m_nLeftArity;
-      m_nRightArity = span.m_nRightArity;
-      for ( int i=0; i<MAX_SENTENCE_SIZE; ++i )
-         m_lLinks[i] = span.m_lLinks[i];
-      m_nScore = span.m_nScore;
-   }
-
-public:
-   inline bool operator > (const CSpan &span) const { return this->m_nScore > span.m_nScore; }
-   inline bool operator < (const CSpan &span) const { return this->m_nScore < span.m_nScore; }
 };
 
-
@@ -13,17 +13,126 @@
 #include "depparser.h"
 #include "reader.h"
 #include "writer.h"
+#include "window.h"
 #include "stdlib.h"
 
 using namespace TARGET_LANGUAGE;
 
+/*===============================================================
+ *
+ * read and decode - the plain and the CoNLL formats
+ *
+ *==============================================================*/
+
+#ifdef JOINT_MORPH
+typedef CStringVector CInputSentence;
+#else
+typedef CTwoStringVector CInputSentence;
+#endif
+
+bool read(CSentenceReader *input_reader, std::ifstream *is, CInputSentence &sentence) {
+#ifdef JOINT_MORPH
+   return input_reader->readRawSentence(&sentence, false, true);
+#else
+   return input_reader->readTaggedSentence(&sentence, false, TAG_SEPARATOR);
+#endif
+}
+
+bool read(CSentenceReader *input_reader, std::ifstream *is, CCoNLLInput &sentence) {
+   return (*is) >> sentence;
+}
+
+void decode(CDepParser &parser, const CInputSentence &sentence, CDependencyParse *retval, const unsigned long &nBest, depparser::SCORE_TYPE *scores) {
+   parser.parse( sentence , retval , nBest , scores ) ;
+}
+
+void decode(CDepParser &parser, const CCoNLLInput &sentence, CCoNLLOutput *retval, const unsigned long &nBest, depparser::SCORE_TYPE *scores) {
+   parser.parse_conll( sentence , retval , nBest , scores );
+}
+
+/*---------------------------------------------------------------
+ *
+ * decodeWindows - read the input a window at a time, decode the
+ *                 window by length and write it in input order
+ *
+ * Returns the number of sentences.
+ *
+ *--------------------------------------------------------------*/
+
+template<typename CInput, typename COutput>
+int decodeWindows(CDepParser &parser, CSentenceReader *input_reader, std::ifstream *is, std::ofstream &os, std::ofstream *os_scores, const unsigned long &nBest, const unsigned &nWindow, depparser::CSuperTag *supertags, std::ifstream *is_supertags) {
+   CWindow<CInput> window(nWindow);
+   COutput *outputs = new COutput[nWindow*nBest];
+   depparser::SCORE_TYPE *scores = os_scores ? new depparser::SCORE_TYPE[nWindow*nBest] : 0;
+   int nCount = 0;
+   bool bReadSuccessful = true;
+
+   while( bReadSuccessful ) {
+
+      // Read the next window
+      window.clear();
+      while (!window.full()) {
+         if (!read(input_reader, is, window.push())) {
+            window.pop();
+            bReadSuccessful = false;
+            break;
+         }
+      }
+      window.sort();
+      parser.reserve(window.longest() > depparser::MAX_SENTENCE_SIZE ? depparser::MAX_SENTENCE_SIZE : window.longest());
+
+      for (unsigned k=0; k<window.size(); ++k) {
+
+         const unsigned index = window.order(k);
+         const CInput &input = window[index];
+         COutput *output = outputs + index*nBest;
+         depparser::SCORE_TYPE *score = scores ? scores + index*nBest : 0;
+         TRACE("Sentence " << nCount+index);
+
+         // check size
+         if ( input.size() > depparser::MAX_SENTENCE_SIZE ) {
+            WARNING("The sentence is longer than system limitation, skipping it.");
+            for (unsigned i=0; i<nBest; ++i) {
+               output[i].clear();
+               if (score) score[i]=0;
+            }
+         }
+         else {
+
+            // Find decoder output; the supertags are read in input
+            // order, so they are only used with a window of one
+            if (supertags) {
+               supertags->setSentenceSize( input.size() );
+               (*is_supertags) >> *supertags;
+            }
+
+            decode( parser , input , output , nBest , score );
+
+         }
+      }
+
+      // Ouptut sent
+      for (unsigned index=0; index<window.size(); ++index) {
+         for (unsigned i=0; i<nBest; ++i) {
+            os << outputs[index*nBest+i];
+            if (scores) *os_scores << scores[index*nBest+i] << std::endl;
+         }
+      }
+      nCount += window.size();
+   }
+
+   delete [] outputs;
+   if (scores) delete [] scores;
+   return nCount;
+}
+
 /*===============================================================
  *
  * decode
  *
  *==============================================================*/
 
-void process(const std::string sInputFile, const std::string sOutputFile, const std::string sFeatureFile, unsigned long nBest, const bool bScores, const std::string &sSuperPath, bool bCoNLL, const std::string &sMetaPath) {
+void process(const std::string sInputFile, const std::string sOutputFile, const std::string sFeatureFile, unsigned long nBest, const bool bScores, const std::string &sSuperPath, bool bCoNLL, const std::string &sMetaPath, const unsigned &nBeamWidth, const depparser::SCORE_TYPE &nBeamMargin, const unsigned &nWindow) {
 
    std::cerr << "Parsing started" << std::endl;
 
@@ -34,20 +143,14 @@ void process(const std::string sInputFile, const std::string sOutputFile, const
    if (!sMetaPath.empty() )
       parser.loadMeta(sMetaPath);
 #endif
+   // the compiled beam unless asked otherwise
+   if (nBeamWidth != 0 || nBeamMargin != 0)
+      parser.setBeam(nBeamWidth, nBeamMargin);
    CSentenceReader *input_reader;
    std::ifstream *is;
    std::ofstream os(sOutputFile.c_str());
    std::ofstream *os_scores=0;
-   depparser::SCORE_TYPE *scores=0;
    assert(os.is_open());
-#ifdef JOINT_MORPH
-   CStringVector input_sent;
-#else
-   CTwoStringVector input_sent;
-#endif
-   CCoNLLInput input_conll;
-   CDependencyParse *output_sent;
-   CCoNLLOutput *output_conll;
    depparser::CSuperTag *supertags;
    std::ifstream *is_supertags = 0;
 
@@ -65,95 +168,20 @@ void process(const std::string sInputFile, const std::string sOutputFile, const
    else
       input_reader = new CSentenceReader(sInputFile);
 
-   int nCount=0;
-   bool bReadSuccessful;
-
-   if (bScores) {
-      scores = new depparser::SCORE_TYPE[nBest];
+   if (bScores)
       os_scores = new std::ofstream(std::string(sOutputFile+".scores").c_str());
-   }
-
-   output_conll = 0;
-   output_sent = 0;
-   if (bCoNLL)
-      output_conll = new CCoNLLOutput[nBest];
-   else
-      output_sent = new CDependencyParse[nBest];
 
-   // Read the next example
+   int nCount;
    if (bCoNLL)
-      bReadSuccessful = ( (*is) >> input_conll );
+      nCount = decodeWindows<CCoNLLInput, CCoNLLOutput>(parser, input_reader, is, os, os_scores, nBest, nWindow, supertags, is_supertags);
    else
-#ifdef JOINT_MORPH
-	  bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
-#else
-      bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
-#endif
-   while( bReadSuccessful ) {
-
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-
-      // check size
-      if ( (bCoNLL && input_conll.size() > depparser::MAX_SENTENCE_SIZE) ||
-           (!bCoNLL && input_sent.size() > depparser::MAX_SENTENCE_SIZE) ) {
-         WARNING("The sentence is longer than system limitation, skipping it.");
-         for (unsigned i=0; i<nBest; ++i) {
-            if (bCoNLL)
-               output_conll[i].clear();
-            else
-               output_sent[i].clear();
-            if (bScores) scores[i]=0;
-         }
-      }
-      else {
-
-         // Find decoder output
-         if (supertags) {
-            if (bCoNLL)
-               supertags->setSentenceSize( input_conll.size() );
-            else
-               supertags->setSentenceSize( input_sent.size() );
-            (*is_supertags) >> *supertags;
-         }
+      nCount = decodeWindows<CInputSentence, CDependencyParse>(parser, input_reader, is, os, os_scores, nBest, nWindow, supertags, is_supertags);
 
-         if (bCoNLL)
-            parser.parse_conll( input_conll , output_conll , nBest , scores );
-         else
-            parser.parse( input_sent , output_sent , nBest , scores ) ;
-
-      }
-
-      // Ouptut sent
-      for (unsigned i=0; i<nBest; ++i) {
-         if (bCoNLL)
-            os << output_conll[i];
-         else
-            os << output_sent[i] ;
-         if (bScores) *os_scores << scores[i] << std::endl;
-      }
-
-      // Read the next example
-      if (bCoNLL)
-         bReadSuccessful = ( (*is) >> input_conll );
-      else
-#ifdef JOINT_MORPH
-	  bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
-#else
-      bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
-#endif
-   }
-
-   if (bCoNLL)
-      delete [] output_conll;
-   else
-      delete [] output_sent ;
    os.close();
 
    if (bScores) {
       os_scores->close();
       delete os_scores;
-      delete []scores;
    }
 
    if (bCoNLL)
@@ -167,7 +195,9 @@ void process(const std::string sInputFile, const std::string sOutputFile, const
       delete is_supertags;
    }
 
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+   const double dTime = double(clock()-time_start)/CLOCKS_PER_SEC;
+   std::cerr << "Parsing has finished successfully. Total time taken is: " << dTime << std::endl;
+   std::cerr << "Sentences per second: " << (dTime > 0 ? nCount/dTime : 0) << std::endl;
 }
 
 /*===============================================================
@@ -194,6 +224,9 @@ int main(int argc, char* argv[]) {
       configurations.defineConfiguration("n", "N", "N best list output", "1");
       configurations.defineConfiguration("s", "", "output scores to output_file.scores", "");
       configurations.defineConfiguration("p", "path", "supertags", "");
+      configurations.defineConfiguration("b", "N", "beam width, no larger than the compiled agenda size (0 for the agenda size)", "0");
+      configurations.defineConfiguration("m", "M", "drop the states that trail the best one by more than M (0 for none)", "0");
+      configurations.defineConfiguration("w", "N", "read ahead N sentences and decode them from the longest, writing them in input order", "1");
 #ifdef SUPPORT_META_FEATURE_DEFINITION
       configurations.defineConfiguration("t", "path", "meta feature types", "");
 #endif
@@ -213,6 +246,25 @@ int main(int argc, char* argv[]) {
       bool bScores = configurations.getConfiguration("s").empty() ? false : true;
       bool bCoNLL = configurations.getConfiguration("c").empty() ? false : true;
       std::string sSuperPath = configurations.getConfiguration("p");
+      unsigned nBeamWidth = 0;
+      if (!fromString(nBeamWidth, configurations.getConfiguration("b"))) {
+         std::cout << "The beam width must be an integer." << std::endl;
+         return 1;
+      }
+      depparser::SCORE_TYPE nBeamMargin = 0;
+      if (!fromString(nBeamMargin, configurations.getConfiguration("m")) || nBeamMargin < 0) {
+         std::cout << "The beam margin must be a non-negative number." << std::endl;
+         return 1;
+      }
+      unsigned nWindow = 1;
+      if (!fromString(nWindow, configurations.getConfiguration("w")) || nWindow == 0) {
+         std::cout << "The window must be a positive integer." << std::endl;
+         return 1;
+      }
+      if (nWindow > 1 && !sSuperPath.empty()) {
+         std::cout << "The supertags are read in input order and can not be used with a window." << std::endl;
+         return 1;
+      }
       std::string sMetaPath;
 #ifdef SUPPORT_META_FEATURE_DEFINITION
       sMetaPath = configurations.getConfiguration("t");
@@ -221,7 +273,7 @@ int main(int argc, char* argv[]) {
 //      if (bCoNLL)
 //         process_conll(options.args[1], options.args[2], options.args[3], nBest, bScores, sSuperPath);
 //      else
-      process(options.args[1], options.args[2], options.args[3], nBest, bScores, sSuperPath, bCoNLL, sMetaPath);
+      process(options.args[1], options.args[2], options.args[3], nBest, bScores, sSuperPath, bCoNLL, sMetaPath, nBeamWidth, nBeamMargin, nWindow);
       return 0;
    } catch (const std::string &e) {
       std::cerr << "Error: " << e << std::endl;
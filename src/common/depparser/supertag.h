@@ -22,7 +22,7 @@ public:
    enum type {HL=0, HR, DL, DR, RT};
 
 protected:
-   unsigned long m_tags[MAX_SENTENCE_SIZE];
+   std::vector<unsigned long> m_tags;
    unsigned long m_size;
 
 public:
@@ -47,16 +47,16 @@ public:
 //==============================================================================
 
 inline std::istream & operator >> (std::istream &is, CSuperTag &p) {
-   unsigned long index ;
+   unsigned long tag ;
    std::string s ; 
    getline(is, s);
    if (is && !(s.empty())) {
       std::istringstream iss(s) ; 
-      index = 0;
-      while ( iss >> p.m_tags[index] ) {
-         ++index;
+      p.m_tags.clear();
+      while ( iss >> tag ) {
+         p.m_tags.push_back(tag);
       }
-      ASSERT(p.m_size==index, "The size of the supertag sentence from the input does not match the size given by caller");
+      ASSERT(p.m_size==p.m_tags.size(), "The size of the supertag sentence from the input does not match the size given by caller");
    }
    else {
       THROW("No supertags read.");
@@ -85,7 +85,7 @@ namespace depparser {
 class CSuperTag {
 
 protected:
-   unsigned long m_tags[MAX_SENTENCE_SIZE*MAX_SENTENCE_SIZE];
+   std::vector<unsigned long> m_tags;
    unsigned long m_size;
 
 public:
@@ -104,17 +104,16 @@ public:
 //==============================================================================
 
 inline std::istream & operator >> (std::istream &is, CSuperTag &p) {
-   unsigned long index ;
+   unsigned long tag ;
    std::string s ; 
    getline(is, s);
    if (is && !(s.empty())) {
       std::istringstream iss(s) ; 
-      index = 0;
-      while ( iss >> p.m_tags[index] ) {
-         ++index;
-         ASSERT(index <MAX_SENTENCE_SIZE*MAX_SENTENCE_SIZE,"The input supertag sequence does not match the sentence size.");
+      p.m_tags.clear();
+      while ( iss >> tag ) {
+         p.m_tags.push_back(tag);
       }
-      ASSERT(index==p.m_size*p.m_size,"The input supertag sequence does not match the sentence size.");
+      ASSERT(p.m_tags.size()==p.m_size*p.m_size,"The input supertag sequence does not match the sentence size.");
    }
    else {
       THROW("No supertags read.");
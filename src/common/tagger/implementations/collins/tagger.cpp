@@ -71,13 +71,13 @@ void TARGET_LANGUAGE::CTagger::getLocalScore( CPackedScoreType<SCORE_TYPE, CTag:
    CTag prev_tag = item ? item->tag : CTag::SENTENCE_BEGIN;
    CTag second_prev_tag = (item && item->prev) ?  item->prev->tag : CTag::SENTENCE_BEGIN;
 
-   static int i;
-   static int word_size;
-   static char letter;
-   static bool bContainHyphen;
-   static bool bContainNumber;
-   static bool bContainCapitalLetter;
-   static std::string prefix, suffix;
+   int i;
+   int word_size;
+   char letter;
+   bool bContainHyphen;
+   bool bContainNumber;
+   bool bContainCapitalLetter;
+   std::string prefix, suffix;
 
    m_weights->m_mapCurrentTag.getScore(retval, word, m_nScoreIndex) ;
    m_weights->m_mapLastTagByTag.getScore(retval, prev_tag, m_nScoreIndex) ;
@@ -258,7 +258,7 @@ void TARGET_LANGUAGE::CTagger::finishTraining() {
  *--------------------------------------------------------------*/
 
 unsigned long long TARGET_LANGUAGE::CTagger::getPossibleTagsForWord( const CWord &word ) {
-   static unsigned long long possible_tags;
+   unsigned long long possible_tags;
    possible_tags = m_TagDict ? m_TagDict->lookup(word) : 0LL;
    // when there is not an open tag for this word
    if (possible_tags ==0) possible_tags |= m_opentags;
@@ -331,13 +331,11 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
    clock_t total_start_time = clock();;
    // initialise the return value, the agenda and cache
    TRACE("Initialising the tagging process...");
-   static int index, temp_index, j;
-   static unsigned tag, last_tag;
-   static CPackedScoreType<SCORE_TYPE, CTag::MAX_COUNT> scores;
+   int index, temp_index, j;
+   unsigned tag, last_tag;
+   CPackedScoreType<SCORE_TYPE, CTag::MAX_COUNT> scores;
    const CStateItem *pGenerator;
-   static CStateItem best_bigram[1<<CTag::SIZE][1<<CTag::SIZE];
-   static int done_bigram[1<<CTag::SIZE][1<<CTag::SIZE];
-   static CStateItem temp;
+   CStateItem temp;
 
    m_CacheSize = sentence->size();
 
@@ -351,9 +349,11 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
       delete []stateindice;
       delete []stateitems;
       delete []m_possibletags;
+      delete []m_Cache;
       stateitems = new CStateItem[AGENDA_SIZE*m_nMaxSentenceSize];
       stateindice = new unsigned[m_nMaxSentenceSize];
       m_possibletags = new unsigned long long[m_nMaxSentenceSize];
+      m_Cache = new CWord[m_nMaxSentenceSize];
    }
 
    if (m_CacheSize == 0) {
@@ -400,16 +400,17 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
    }
    stateindice[2] = stateindice[1];
 
-   if (nBest == 1) {
-//      for ( tag=0; tag<CTag::COUNT; ++tag )
-//         for ( last_tag=0; last_tag<CTag::COUNT; ++last_tag )
-//            done_bigram[last_tag][tag] = -1;
-      memset(done_bigram, 0, (1<<CTag::SIZE)*(1<<CTag::SIZE)*sizeof(int));
+   // the bigrams are marked with a stamp that is new for each word of
+   // each sentence, so that they need clearing only when it wraps
+   if (nBest == 1 && m_nBigramStamp > INT_MAX - static_cast<int>(m_CacheSize)) {
+      memset(m_DoneBigram, 0, (1<<CTag::SIZE)*(1<<CTag::SIZE)*sizeof(int));
+      m_nBigramStamp = 0;
    }
 
    for ( index=1; index<m_CacheSize; index++ ) {
 
       m_Agenda->clear();
+      const int stamp = m_nBigramStamp + index;
       for ( j=stateindice[index-1]; j<stateindice[index]; ++j ) {
 
          pGenerator = &stateitems[j];
@@ -425,9 +426,9 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
 //               temp.m_nScore = pGenerator->m_nScore + getLocalScore(sentence, &temp, index);
                temp.m_nScore = pGenerator->m_nScore + scores[tag];
                if (nBest==1) {
-                  if ( done_bigram[last_tag][tag] != index || temp.m_nScore > best_bigram[last_tag][tag].m_nScore ) {
-                     done_bigram[last_tag][tag] = index;
-                     best_bigram[last_tag][tag] = temp ;
+                  if ( m_DoneBigram[(last_tag<<CTag::SIZE)+tag] != stamp || temp.m_nScore > m_BestBigram[(last_tag<<CTag::SIZE)+tag].m_nScore ) {
+                     m_DoneBigram[(last_tag<<CTag::SIZE)+tag] = stamp;
+                     m_BestBigram[(last_tag<<CTag::SIZE)+tag] = temp ;
                   }
                }
                else {
@@ -441,8 +442,8 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
       if (nBest==1) {
          for ( tag=CTag::FIRST; tag<CTag::COUNT; ++tag ) {
             for ( last_tag=0; last_tag<CTag::COUNT; ++last_tag ) {
-               if ( done_bigram[last_tag][tag]==index ) {
-                  m_Agenda->insertItem(&best_bigram[last_tag][tag]);
+               if ( m_DoneBigram[(last_tag<<CTag::SIZE)+tag]==stamp ) {
+                  m_Agenda->insertItem(&m_BestBigram[(last_tag<<CTag::SIZE)+tag]);
                }
             }
          }
@@ -455,6 +456,8 @@ void TARGET_LANGUAGE::CTagger::tag( CStringVector * sentence , CTwoStringVector
       stateindice[index+2] = stateindice[index+1];
 //      TRACE("The time for iteration" << index << ":was " << double(clock() - total_start_time)/CLOCKS_PER_SEC);
    }
+   if (nBest == 1)
+      m_nBigramStamp += m_CacheSize;
 
    // output
    TRACE("Outputing sentence");
@@ -73,23 +73,53 @@ private:
 
    unsigned long long m_opentags;
 
+   tagger::CStateItem *m_BestBigram; // the best item for each tag bigram
+   int *m_DoneBigram;                // the stamp by which the bigram is set
+   int m_nBigramStamp;               // the stamp before the current sentence
+
+   bool m_bSharedModel;        // whether the weights and dictionaries belong to another tagger
+
 public:
    CTagger(const std::string &sFeatureDBPath, bool bTrain=false) : CTaggerImpl() , m_sFeatureDB(sFeatureDBPath) , m_bTrain(bTrain) , m_TagDict(0), m_TopTags(0), m_CacheSize(0), m_nMaxSentenceSize(tagger::MAX_SENTENCE_SIZE), m_opentags(~0LL) { 
       m_weights = new tagger::CWeight(m_sFeatureDB, bTrain); 
       loadScores();
+      if (!m_bTrain) m_weights->freezeScores();
       if (m_bTrain) m_nTrainingRound = 0;
       if (m_bTrain) m_nScoreIndex = CScore<tagger::SCORE_TYPE>::eNonAverage; else m_nScoreIndex = CScore<tagger::SCORE_TYPE>::eAverage;
       stateitems = new tagger::CStateItem[tagger::AGENDA_SIZE*m_nMaxSentenceSize];
       stateindice = new unsigned[m_nMaxSentenceSize];
       m_possibletags = new unsigned long long[m_nMaxSentenceSize];
       m_Cache = new CWord[m_nMaxSentenceSize];
+      m_BestBigram = new tagger::CStateItem[(1<<CTag::SIZE)*(1<<CTag::SIZE)];
+      m_DoneBigram = new int[(1<<CTag::SIZE)*(1<<CTag::SIZE)];
+      memset(m_DoneBigram, 0, (1<<CTag::SIZE)*(1<<CTag::SIZE)*sizeof(int));
+      m_nBigramStamp = 0;
+      m_bSharedModel = false;
+   }
+   // a tagger sharing the weights and dictionaries of a loaded tagger, for tagging in another thread
+   CTagger(const CTagger *model) : CTaggerImpl() , m_sFeatureDB(model->m_sFeatureDB) , m_bTrain(false) , m_TagDict(model->m_TagDict), m_TopTags(model->m_TopTags), m_CacheSize(0), m_nMaxSentenceSize(tagger::MAX_SENTENCE_SIZE), m_opentags(model->m_opentags) {
+      ASSERT(!model->m_bTrain, "Only the weights of a decoding tagger can be shared");
+      m_weights = model->m_weights;
+      m_nScoreIndex = CScore<tagger::SCORE_TYPE>::eAverage;
+      stateitems = new tagger::CStateItem[tagger::AGENDA_SIZE*m_nMaxSentenceSize];
+      stateindice = new unsigned[m_nMaxSentenceSize];
+      m_possibletags = new unsigned long long[m_nMaxSentenceSize];
+      m_Cache = new CWord[m_nMaxSentenceSize];
+      m_BestBigram = new tagger::CStateItem[(1<<CTag::SIZE)*(1<<CTag::SIZE)];
+      m_DoneBigram = new int[(1<<CTag::SIZE)*(1<<CTag::SIZE)];
+      memset(m_DoneBigram, 0, (1<<CTag::SIZE)*(1<<CTag::SIZE)*sizeof(int));
+      m_nBigramStamp = 0;
+      m_bSharedModel = true;
    }
    ~CTagger() { 
-      delete m_weights; 
       delete []stateitems;
       delete []stateindice;
       delete []m_possibletags;
       delete []m_Cache;
+      delete []m_BestBigram;
+      delete []m_DoneBigram;
+      if (m_bSharedModel) return;
+      delete m_weights; 
       if (m_TagDict) delete m_TagDict;
       if (m_TopTags) delete m_TopTags;
    }
@@ -80,5 +80,17 @@ void TARGET_LANGUAGE::tagger::CWeight::computeAverageFeatureWeights(int round) {
    std::cerr << " Done" << std::endl;
 }
 
+/*--------------------------------------------------------------
+ *
+ * freezeScores - replace the score maps with read only tables
+ *                of the averaged scores for decoding
+ *
+ *-------------------------------------------------------------*/
+
+void TARGET_LANGUAGE::tagger::CWeight::freezeScores() {
+   ASSERT(!m_bTrain, "Only the scores of a decoding model can be frozen");
+   iterate_templates(,.freeze(CScore<SCORE_TYPE>::eAverage););
+}
+
 
 
@@ -117,6 +117,7 @@ public:
    void loadScores(); 
    void saveScores(); 
    void computeAverageFeatureWeights(int round);
+   void freezeScores();
  
 };
 
@@ -0,0 +1,530 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * zpar.server.cpp - a parser server, which loads the models    *
+ *                   once and serves requests over a socket     *
+ *                                                              *
+ * The server listens on a unix socket or a tcp port. A client  *
+ * sends framed requests on a connection, and may send more     *
+ * requests without waiting for the responses. The requests are *
+ * processed by a pool of worker threads, and each response     *
+ * carries the id of its request, since the responses to the    *
+ * requests on a connection are sent as they are finished.      *
+ *                                                              *
+ * All integers are unsigned and in network byte order.         *
+ *                                                              *
+ * request:  length   32 bits, the bytes after this field       *
+ *           id       32 bits, chosen by the client             *
+ *           timeout  32 bits, milliseconds, 0 for the default  *
+ *           command   8 bits, 't' tag, 'd' dependency parse,   *
+ *                             'c' constituent parse            *
+ *           body     the sentences, one in a line              *
+ *                                                              *
+ * response: length   32 bits, the bytes after this field       *
+ *           id       32 bits, the id of the request            *
+ *           status    8 bits, 0 ok, 1 error, 2 timeout         *
+ *           body     the output in the format of zpar.en, or   *
+ *                    the error message                         *
+ *                                                              *
+ * A request is a batch of sentences, which are processed by    *
+ * one worker in order. An empty line gives an empty line in    *
+ * the output. A request that is not finished by its deadline   *
+ * is answered with the timeout status and no output; the       *
+ * deadline is checked as each sentence is started.             *
+ *                                                              *
+ ****************************************************************/
+
+#define SIMPLE_HASH
+
+#include "definitions.h"
+#include "options.h"
+#include "utils.h"
+#include "tagger.h"
+#include "conparser.h"
+#include "depparser.h"
+#include "reader.h"
+#include "thread.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace english;
+
+static const unsigned SERVER_REQUEST_HEADER = 9;
+static const unsigned SERVER_RESPONSE_HEADER = 5;
+static const unsigned SERVER_READ_SIZE = 65536;
+static const int SERVER_POLL_INTERVAL = 200;
+
+enum { SERVER_OK = 0, SERVER_ERROR = 1, SERVER_TIMEOUT = 2 };
+
+static volatile sig_atomic_t g_bStop = 0;
+
+void stopServer(int signal) { g_bStop = 1; }
+
+/*---------------------------------------------------------------
+ *
+ * milliseconds - the monotonic clock in milliseconds
+ *
+ *--------------------------------------------------------------*/
+
+uint64_t milliseconds() {
+   timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return static_cast<uint64_t>(now.tv_sec)*1000 + now.tv_nsec/1000000;
+}
+
+uint32_t readInt(const char *p) {
+   uint32_t value;
+   memcpy(&value, p, sizeof(value));
+   return ntohl(value);
+}
+
+void writeInt(std::string &s, const uint32_t &value) {
+   const uint32_t n = htonl(value);
+   s.append(reinterpret_cast<const char*>(&n), sizeof(n));
+}
+
+/*===============================================================
+ *
+ * CConnection - a client connection
+ *
+ * The connection is read by the io thread only, and written by
+ * the workers under its mutex. It is referred to by the io
+ * thread until the client closes it, and by the requests on it
+ * that are not answered yet; the socket is closed with the last
+ * reference, so that it is not reused while it is referred to.
+ *
+ *==============================================================*/
+
+struct CConnection {
+   int fd;
+   unsigned long references;  // guarded by the server mutex
+   std::string buffer;        // the bytes read and not yet framed
+   CMutex mutex;              // held while writing
+
+   CConnection(int socket) : fd(socket), references(1) { }
+   ~CConnection() { close(fd); }
+
+   // errors are ignored, since the client may have gone
+   void respond(const uint32_t &id, const unsigned char &status, const std::string &body) {
+      std::string frame;
+      frame.reserve(sizeof(uint32_t) + SERVER_RESPONSE_HEADER + body.size());
+      writeInt(frame, SERVER_RESPONSE_HEADER + body.size());
+      writeInt(frame, id);
+      frame.push_back(static_cast<char>(status));
+      frame.append(body);
+      CScopedLock lock(mutex);
+      unsigned long sent = 0;
+      while (sent < frame.size()) {
+         const ssize_t n = send(fd, frame.data()+sent, frame.size()-sent, MSG_NOSIGNAL);
+         if (n < 0 && errno == EINTR) continue;
+         if (n <= 0) return;
+         sent += n;
+      }
+   }
+};
+
+/*===============================================================
+ *
+ * CRequest - a framed request
+ *
+ *==============================================================*/
+
+struct CRequest {
+   CConnection *connection;
+   uint32_t id;
+   char command;
+   uint64_t deadline;         // 0 for none
+   std::string body;
+};
+
+class CServer;
+
+/*===============================================================
+ *
+ * CServerWorker - a worker thread with its own decoders
+ *
+ * The tagger and the dependency parser share the weights of the
+ * loaded models. The constituent parser has no such sharing,
+ * so there is one of it, which the workers take in turn.
+ *
+ *==============================================================*/
+
+class CServerWorker : public CThread {
+protected:
+   CServer *m_server;
+   CTagger m_tagger;
+   CDepParser *m_depparser;
+   CTwoStringVector m_tagged;
+   CDependencyParse m_parsed;
+   CCFGTree m_tree;
+public:
+   CServerWorker(CServer *server, const CTagger *tagger, const CDepParser *depparser) : m_server(server), m_tagger(tagger), m_depparser(0) {
+      if (depparser) m_depparser = new CDepParser(*depparser, false);
+   }
+   ~CServerWorker() {
+      if (m_depparser) delete m_depparser;
+   }
+   void run();
+   bool process(const CRequest &request, std::string &output);
+};
+
+/*===============================================================
+ *
+ * CServer - the listening socket, the io thread and the queue
+ *
+ *==============================================================*/
+
+class CServer {
+protected:
+   int m_listener;
+   std::vector<CConnection*> m_connections;  // the connections being read
+   std::deque<CRequest*> m_queue;
+   CMutex m_mutex;
+   CCondition m_queued;       // signalled when a request is queued or the server stops
+   CCondition m_taken;        // signalled when a request is taken from a full queue
+   bool m_bStop;
+   const unsigned long m_nMaxQueue;
+   const unsigned long m_nMaxRequest;
+   const unsigned long m_nTimeout;
+
+public:
+   CTagger *tagger;
+   CDepParser *depparser;
+   CConParser *conparser;
+   CMutex conparser_mutex;
+
+public:
+   CServer(const unsigned long &nMaxQueue, const unsigned long &nMaxRequest, const unsigned long &nTimeout) : m_listener(-1), m_bStop(false), m_nMaxQueue(nMaxQueue), m_nMaxRequest(nMaxRequest), m_nTimeout(nTimeout), tagger(0), depparser(0), conparser(0) { }
+   ~CServer() {
+      if (m_listener >= 0) close(m_listener);
+      for (unsigned long i=0; i<m_connections.size(); ++i)
+         release(m_connections[i]);
+   }
+
+public:
+   void listenUnix(const std::string &sPath) {
+      sockaddr_un address;
+      memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      ASSERT(sPath.size() < sizeof(address.sun_path), "The socket path " << sPath << " is too long");
+      strcpy(address.sun_path, sPath.c_str());
+      unlink(sPath.c_str());
+      m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+      ASSERT(m_listener >= 0, "Cannot create socket");
+      ASSERT(bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, "Cannot bind socket " << sPath);
+      ASSERT(listen(m_listener, SOMAXCONN) == 0, "Cannot listen on socket " << sPath);
+   }
+
+   void listenTcp(const std::string &sHost, const unsigned &nPort) {
+      sockaddr_in address;
+      memset(&address, 0, sizeof(address));
+      address.sin_family = AF_INET;
+      address.sin_port = htons(nPort);
+      ASSERT(inet_pton(AF_INET, sHost.c_str(), &address.sin_addr) == 1, "The host " << sHost << " is not an ipv4 address");
+      m_listener = socket(AF_INET, SOCK_STREAM, 0);
+      ASSERT(m_listener >= 0, "Cannot create socket");
+      int on = 1;
+      setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+      ASSERT(bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0, "Cannot bind " << sHost << ":" << nPort);
+      ASSERT(listen(m_listener, SOMAXCONN) == 0, "Cannot listen on " << sHost << ":" << nPort);
+   }
+
+   // the io thread: accepts connections and queues their requests
+   // until the server is stopped by a signal
+   void serve() {
+      std::vector<pollfd> fds;
+      char *data = new char[SERVER_READ_SIZE];
+      while (!g_bStop) {
+         fds.resize(m_connections.size()+1);
+         fds[0].fd = m_listener;
+         fds[0].events = POLLIN;
+         for (unsigned long i=0; i<m_connections.size(); ++i) {
+            fds[i+1].fd = m_connections[i]->fd;
+            fds[i+1].events = POLLIN;
+         }
+         if (poll(&fds[0], fds.size(), SERVER_POLL_INTERVAL) <= 0)
+            continue;
+         // connections are read before new ones are added
+         unsigned long kept = 0;
+         for (unsigned long i=0; i<m_connections.size(); ++i) {
+            CConnection *connection = m_connections[i];
+            bool open = true;
+            if (fds[i+1].revents) {
+               const ssize_t n = recv(connection->fd, data, SERVER_READ_SIZE, 0);
+               if (n > 0) {
+                  connection->buffer.append(data, n);
+                  open = frame(connection);
+               }
+               else if (n == 0 || errno != EINTR)
+                  open = false;
+            }
+            if (open)
+               m_connections[kept++] = connection;
+            else
+               release(connection);
+         }
+         m_connections.resize(kept);
+         if (fds[0].revents & POLLIN) {
+            const int fd = accept(m_listener, 0, 0);
+            if (fd >= 0) {
+               int on = 1;
+               setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+               m_connections.push_back(new CConnection(fd));
+            }
+         }
+      }
+      delete [] data;
+      CScopedLock lock(m_mutex);
+      m_bStop = true;
+      m_queued.broadcast();
+   }
+
+   // the next request for a worker, 0 when the server has stopped
+   // and the queue is empty
+   CRequest *take() {
+      CScopedLock lock(m_mutex);
+      while (m_queue.empty() && !m_bStop)
+         m_queued.wait(m_mutex);
+      if (m_queue.empty())
+         return 0;
+      CRequest *request = m_queue.front();
+      m_queue.pop_front();
+      m_taken.signal();
+      return request;
+   }
+
+   void answer(CRequest *request, const unsigned char &status, const std::string &body) {
+      request->connection->respond(request->id, status, body);
+      release(request->connection);
+      delete request;
+   }
+
+protected:
+   // queue the complete requests in the buffer of the connection,
+   // returns false if the client does not follow the protocol
+   bool frame(CConnection *connection) {
+      const std::string &buffer = connection->buffer;
+      unsigned long start = 0;
+      while (buffer.size()-start >= sizeof(uint32_t)) {
+         const uint32_t length = readInt(buffer.data()+start);
+         if (length < SERVER_REQUEST_HEADER || length > m_nMaxRequest)
+            return false;
+         if (buffer.size()-start < sizeof(uint32_t)+length)
+            break;
+         const char *header = buffer.data()+start+sizeof(uint32_t);
+         CRequest *request = new CRequest;
+         request->connection = connection;
+         request->id = readInt(header);
+         const uint32_t timeout = readInt(header+sizeof(uint32_t));
+         request->command = header[2*sizeof(uint32_t)];
+         request->deadline = 0;
+         if (timeout || m_nTimeout)
+            request->deadline = milliseconds() + (timeout ? timeout : m_nTimeout);
+         request->body.assign(header+SERVER_REQUEST_HEADER, length-SERVER_REQUEST_HEADER);
+         queue(request);
+         start += sizeof(uint32_t)+length;
+      }
+      connection->buffer.erase(0, start);
+      return true;
+   }
+
+   // the io thread waits for the workers when the queue is full,
+   // so that clients sending faster than they are served are
+   // slowed down rather than using up the memory
+   void queue(CRequest *request) {
+      CScopedLock lock(m_mutex);
+      while (m_queue.size() >= m_nMaxQueue)
+         m_taken.wait(m_mutex);
+      ++request->connection->references;
+      m_queue.push_back(request);
+      m_queued.signal();
+   }
+
+   void release(CConnection *connection) {
+      bool last;
+      {
+         CScopedLock lock(m_mutex);
+         last = --connection->references == 0;
+      }
+      if (last) delete connection;
+   }
+};
+
+/*---------------------------------------------------------------
+ *
+ * CServerWorker::run - answer requests until the server stops
+ *
+ *--------------------------------------------------------------*/
+
+void CServerWorker::run() {
+   CRequest *request;
+   std::string output;
+   while ((request = m_server->take()) != 0) {
+      output.clear();
+      try {
+         if (process(*request, output))
+            m_server->answer(request, SERVER_OK, output);
+         else
+            m_server->answer(request, SERVER_TIMEOUT, "");
+      } catch (const std::string &e) {
+         m_server->answer(request, SERVER_ERROR, e);
+      }
+   }
+}
+
+/*---------------------------------------------------------------
+ *
+ * CServerWorker::process - decode the sentences of a request,
+ *                          returns false on the deadline
+ *
+ *--------------------------------------------------------------*/
+
+bool CServerWorker::process(const CRequest &request, std::string &output) {
+   if (request.command == 'd' && m_depparser == 0)
+      THROW("The dependency parser model is not loaded");
+   if (request.command == 'c' && m_server->conparser == 0)
+      THROW("The constituent parser model is not loaded");
+   if (request.command != 't' && request.command != 'd' && request.command != 'c')
+      THROW("Unknown command " << request.command);
+   std::istringstream input(request.body);
+   CSentenceReader reader(&input);
+   CStringVector sentence;
+   std::ostringstream os;
+   while (reader.readSegmentedSentenceAndTokenize(&sentence)) {
+      if (request.deadline && milliseconds() > request.deadline)
+         return false;
+      if ( !sentence.empty() && sentence.back()=="\n" ) {
+         sentence.pop_back();
+      }
+      if (sentence.empty()) {
+         os << std::endl;
+         continue;
+      }
+      m_tagger.tag(&sentence, &m_tagged, 1, NULL);
+      if (request.command == 't') {
+         for (unsigned long i=0; i<m_tagged.size(); ++i) {
+            if (i>0) os << ' ';
+            os << m_tagged[i].first << '/' << m_tagged[i].second;
+         }
+         os << std::endl;
+      }
+      else if (request.command == 'd') {
+         m_depparser->parse(m_tagged, &m_parsed, 1, NULL);
+         os << m_parsed;
+      }
+      else {
+         CScopedLock lock(m_server->conparser_mutex);
+         m_server->conparser->parse(m_tagged, &m_tree);
+         os << m_tree.str_unbinarized() << std::endl;
+      }
+   }
+   output = os.str();
+   return true;
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char* argv[]) {
+   try {
+      COptions options(argc, argv);
+      CConfigurations configurations;
+      configurations.defineConfiguration("socket", "path", "listen on the unix socket at path", "");
+      configurations.defineConfiguration("port", "N", "listen on the tcp port N", "0");
+      configurations.defineConfiguration("host", "address", "the ipv4 address to listen on with --port", "127.0.0.1");
+      configurations.defineConfiguration("threads", "N", "the number of worker threads", "1");
+      configurations.defineConfiguration("timeout", "ms", "the deadline of requests that do not give one, 0 for none", "0");
+      configurations.defineConfiguration("queue", "N", "the number of requests waiting for workers before reading stops", "1024");
+      configurations.defineConfiguration("max-request", "bytes", "the size limit of a request", "16777216");
+
+      if (options.args.size() != 2) {
+         std::cout << "\nUsage: " << argv[0] << " feature_path" << std::endl;
+         std::cout << configurations.message() << std::endl;
+         return 1;
+      }
+      std::string warning = configurations.loadConfigurations(options.opts);
+      if (!warning.empty()) {
+         std::cout << "Warning: " << warning << std::endl;
+      }
+
+      const std::string sSocket = configurations.getConfiguration("socket");
+      unsigned nPort, nThreads;
+      unsigned long nTimeout, nMaxQueue, nMaxRequest;
+      if (!fromString(nPort, configurations.getConfiguration("port")) || nPort > 65535)
+         THROW("the port must be an integer below 65536");
+      if (sSocket.empty() == (nPort == 0))
+         THROW("either a socket or a port must be given");
+      if (!fromString(nThreads, configurations.getConfiguration("threads")) || nThreads < 1)
+         THROW("the number of threads must be a positive integer");
+      if (!fromString(nTimeout, configurations.getConfiguration("timeout")))
+         THROW("the timeout must be a number of milliseconds");
+      if (!fromString(nMaxQueue, configurations.getConfiguration("queue")) || nMaxQueue < 1)
+         THROW("the queue size must be a positive integer");
+      if (!fromString(nMaxRequest, configurations.getConfiguration("max-request")) || nMaxRequest < SERVER_REQUEST_HEADER || nMaxRequest > 0xffffffffUL)
+         THROW("the request size limit is not valid");
+
+      // the parser models are optional, the tagger is needed by all
+      const std::string sFeaturePath = options.args[1];
+      std::string sTaggerFeatureFile = sFeaturePath + "/tagger";
+      std::string sDepParserFeatureFile = sFeaturePath + "/depparser";
+      std::string sConParserFeatureFile = sFeaturePath + "/conparser";
+      if (!FileExists(sTaggerFeatureFile))
+         THROW("Tagger model does not exists. It should be put at model_path/tagger");
+
+      CServer server(nMaxQueue, nMaxRequest, nTimeout);
+      std::cerr << "[tagger] ";
+      server.tagger = new CTagger(sTaggerFeatureFile, false);
+      if (FileExists(sDepParserFeatureFile)) {
+         std::cerr << "[depparser] ";
+         server.depparser = new CDepParser(sDepParserFeatureFile, false);
+      }
+      if (FileExists(sConParserFeatureFile)) {
+         std::cerr << "[conparser] ";
+         server.conparser = new CConParser(sConParserFeatureFile, false);
+      }
+      CWord().freezeDictionary();
+
+      signal(SIGPIPE, SIG_IGN);
+      signal(SIGINT, stopServer);
+      signal(SIGTERM, stopServer);
+      if (!sSocket.empty())
+         server.listenUnix(sSocket);
+      else
+         server.listenTcp(configurations.getConfiguration("host"), nPort);
+
+      std::vector<CServerWorker*> workers;
+      for (unsigned i=0; i<nThreads; ++i) {
+         workers.push_back(new CServerWorker(&server, server.tagger, server.depparser));
+         workers.back()->start();
+      }
+      std::cerr << "Serving on " << (sSocket.empty() ? configurations.getConfiguration("host") + ":" + configurations.getConfiguration("port") : sSocket) << " with " << nThreads << " threads" << std::endl;
+      server.serve();
+
+      // the queued requests are answered before the workers stop
+      for (unsigned i=0; i<workers.size(); ++i) {
+         workers[i]->join();
+         delete workers[i];
+      }
+      if (!sSocket.empty())
+         unlink(sSocket.c_str());
+      delete server.tagger;
+      if (server.depparser) delete server.depparser;
+      if (server.conparser) delete server.conparser;
+      std::cerr << "The server has stopped." << std::endl;
+      return 0;
+   } catch(const std::string&e) {
+      std::cerr<<"Error: "<<e;
+      std::cerr<<std::endl;
+      return 1;
+   }
+}
@@ -16,6 +16,7 @@
 #include "deplabeler.h"
 #include "reader.h"
 #include "writer.h"
+#include "pipeline.h"
 #include "stdlib.h"
 
 using namespace generic;
@@ -172,6 +173,117 @@ void depparse(const std::string sInputFile, const std::string sOutputFile, const
    std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
 }
 
+/*===============================================================
+ *
+ * batch - tag or depparse with a pool of worker threads
+ *
+ * The models are loaded once and shared by the workers; the
+ * output is in the same order as the input. The dictionary of
+ * words is frozen once the models are loaded, so that unknown
+ * words in the input are not added to it.
+ *
+ *==============================================================*/
+
+struct CBatchOutput {
+   CTwoStringVector tagged;
+   CLabeledDependencyTree parsed;
+};
+
+typedef CPipeline<CStringVector, CBatchOutput> CBatchPipeline;
+
+class CBatchReader : public CBatchPipeline::CReader {
+protected:
+   CSentenceReader m_reader;
+   bool m_bStripNewline;
+public:
+   CBatchReader(const std::string &sInputFile, bool bStripNewline) : m_reader(sInputFile), m_bStripNewline(bStripNewline) { }
+   bool read(CStringVector &input) {
+      if (!m_reader.readSegmentedSentence(&input))
+         return false;
+      if ( m_bStripNewline && !input.empty() && input.back()=="\n" ) {
+         input.pop_back();
+      }
+      return true;
+   }
+};
+
+class CBatchWorker : public CBatchPipeline::CWorker {
+protected:
+   CTagger m_tagger;
+   CDepParser *m_depparser;
+public:
+   CBatchWorker(const CTagger *tagger, const CDepParser *depparser) : m_tagger(tagger), m_depparser(0) {
+      if (depparser) m_depparser = new CDepParser(*depparser, false);
+   }
+   ~CBatchWorker() {
+      if (m_depparser) delete m_depparser;
+   }
+   void process(CStringVector &input, CBatchOutput &output) {
+      m_tagger.tag(&input, &output.tagged, 1, NULL);
+      if (m_depparser)
+         m_depparser->parse(output.tagged, &output.parsed, 1, NULL);
+   }
+};
+
+class CBatchWriter : public CBatchPipeline::CWriter {
+protected:
+   CSentenceWriter *m_tagged_writer;
+   std::ostream *m_outs;
+public:
+   CBatchWriter(CSentenceWriter *tagged_writer, std::ostream *outs) : m_tagged_writer(tagged_writer), m_outs(outs) { }
+   void write(const CBatchOutput &output) {
+      if (m_tagged_writer)
+         m_tagged_writer->writeSentence(&output.tagged, '/');
+      else
+         (*m_outs) << output.parsed;
+   }
+};
+
+void batch(const std::string sInputFile, const std::string sOutputFile, const std::string sFeaturePath, bool bParse, unsigned nThreads) {
+   std::cerr << (bParse ? "Parsing" : "Tagging") << " started with " << nThreads << " threads" << std::endl;
+   time_t time_start = time(NULL);
+   // the tagging mode takes the tagger model itself as the feature path
+   std::string sTaggerFeatureFile = bParse ? sFeaturePath + "/tagger" : sFeaturePath;
+   std::string sParserFeatureFile = sFeaturePath + "/depparser";
+   if (bParse && !FileExists(sTaggerFeatureFile))
+      THROW("Tagger model does not exists. It should be put at model_path/tagger");
+   if (bParse && !FileExists(sParserFeatureFile))
+      THROW("Parser model does not exists. It should be put at model_path/depparser");
+   std::cerr << "[POS tagging module] "; std::cerr.flush();
+   CTagger tagger(sTaggerFeatureFile, false);
+   CDepParser *depparser = 0;
+   if (bParse) {
+      std::cerr << "[Parsing module] "; std::cerr.flush();
+      depparser = new CDepParser(sParserFeatureFile, false);
+   }
+   CWord().freezeDictionary();
+
+   std::vector<CBatchPipeline::CWorker*> workers;
+   for (unsigned i=0; i<nThreads; ++i)
+      workers.push_back(new CBatchWorker(&tagger, depparser));
+
+   CBatchReader reader(sInputFile, bParse);
+   CSentenceWriter *tagged_writer = 0;
+   std::ostream *outs = 0;
+   if (!bParse)
+      tagged_writer = new CSentenceWriter(sOutputFile);
+   else if (sOutputFile=="")
+      outs = &std::cout;
+   else
+      outs = new std::ofstream(sOutputFile.c_str());
+   CBatchWriter writer(tagged_writer, outs);
+
+   CBatchPipeline pipeline(nThreads*16);
+   pipeline.run(reader, workers, writer);
+
+   for (unsigned i=0; i<workers.size(); ++i)
+      delete workers[i];
+   if (depparser) delete depparser;
+   if (tagged_writer) delete tagged_writer;
+   if (bParse && sOutputFile!="") delete outs;
+   std::cerr << (bParse ? "Parsing" : "Tagging") << " has finished successfully. Total time taken is: " << difftime(time(NULL), time_start) << std::endl;
+}
+
 /*===============================================================
  *
  * main
@@ -183,6 +295,7 @@ int main(int argc, char* argv[]) {
       COptions options(argc, argv);
       CConfigurations configurations;
       configurations.defineConfiguration("o", "{t|d|c}", "output format; 't' pos-tagged format in sentences, 'd' refers to labeled dependency tree format, and 'c' refers to constituent parse tree format", "d");
+      configurations.defineConfiguration("threads", "N", "the number of worker threads for the 't' and 'd' output formats", "1");
 
       if (options.args.size() < 2 || options.args.size() > 4) {
          std::cout << "\nUsage: " << argv[0] << " feature_path [input_file [output_file]]" << std::endl;
@@ -197,12 +310,19 @@ int main(int argc, char* argv[]) {
       std::string sInputFile = options.args.size() > 2 ? options.args[2] : "";
       std::string sToFile = options.args.size() > 3 ? options.args[3] : "";
       std::string sOutFormat = configurations.getConfiguration("o");
+      const int nThreads = atoi(configurations.getConfiguration("threads").c_str());
+      if (nThreads < 1)
+         THROW("the number of threads must be a positive integer");
+      if (nThreads > 1 && sOutFormat == "c")
+         std::cerr << "Warning: the constituent parser runs in a single thread" << std::endl;
 
-      if (sOutFormat == "t")
+      if (nThreads > 1 && (sOutFormat == "t" || sOutFormat == "d"))
+          batch(sInputFile, sToFile, options.args[1], sOutFormat == "d", nThreads);
+      else if (sOutFormat == "t")
           tag(sInputFile, sToFile, options.args[1]);
-      if (sOutFormat == "c" )
+      else if (sOutFormat == "c" )
           parse(sInputFile, sToFile, options.args[1]);
-      if (sOutFormat == "d" )
+      else if (sOutFormat == "d" )
           depparse(sInputFile, sToFile, options.args[1]);
       return 0;
    } catch(const std::string&e) {std::cerr<<"Error: "<<e<<std::endl;return 1;}
@@ -0,0 +1,161 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *
+ * hashbench.cpp - benchmark score map lookups, comparing the
+ *                 chained hash map with the frozen table
+ *
+ * Usage: hashbench [keys [lookups]]
+ *
+ * Half of the lookups are for keys that are not in the map,
+ * as is the case for most feature lookups during decoding.
+ * Word keys are interned in order, which gives the chained
+ * map a perfect layout; word pair keys, like most feature
+ * keys, do not.
+ *
+ ****************************************************************/
+
+#include "definitions.h"
+#include "linguistics/word.h"
+#include "tuple2.h"
+#include "learning/perceptron/hashmap_score.h"
+#include "learning/perceptron/hashmap_score_packed.h"
+
+static const unsigned BENCH_PACKED_SIZE = 16;
+
+typedef CTuple2<CWord, CWord> CWordPair;
+
+/*---------------------------------------------------------------
+ *
+ * makeWords - intern the keys and the queries
+ *
+ *--------------------------------------------------------------*/
+
+void makeWords(const unsigned long &nKeys, const unsigned long &nLookups, std::vector<CWord> &keys, std::vector<CWord> &queries) {
+   std::ostringstream os;
+   for (unsigned long i=0; i<nKeys*2; ++i) {
+      os.str("");
+      os << "w" << i;
+      keys.push_back(CWord(os.str()));
+   }
+   srand(0);
+   for (unsigned long i=0; i<nLookups; ++i)
+      queries.push_back(keys[rand()%keys.size()]);
+   keys.resize(nKeys);
+}
+
+void makeWordPairs(const unsigned long &nKeys, const unsigned long &nLookups, std::vector<CWordPair> &keys, std::vector<CWordPair> &queries) {
+   std::vector<CWord> words, unused;
+   makeWords(20000, 0, words, unused);
+   std::set< std::pair<unsigned long, unsigned long> > seen;
+   srand(1);
+   while (keys.size() < nKeys*2) {
+      const CWord &first = words[rand()%words.size()];
+      const CWord &second = words[rand()%words.size()];
+      if (!seen.insert(std::make_pair(first.code(), second.code())).second)
+         continue;
+      keys.push_back(CWordPair());
+      keys.back().allocate(&first, &second);
+   }
+   for (unsigned long i=0; i<nLookups; ++i)
+      queries.push_back(keys[rand()%keys.size()]);
+   keys.resize(nKeys);
+}
+
+/*---------------------------------------------------------------
+ *
+ * report - print the lookup rate
+ *
+ *--------------------------------------------------------------*/
+
+void report(const std::string &sName, const unsigned long &nLookups, const clock_t &time, const long &checksum) {
+   const double seconds = double(time)/CLOCKS_PER_SEC;
+   std::cout << sName << ": " << nLookups/(seconds>0?seconds:1e-9) << " lookups/sec (" << seconds << "s, checksum " << checksum << ")" << std::endl;
+}
+
+/*---------------------------------------------------------------
+ *
+ * benchPacked - CPackedScoreMap
+ *
+ *--------------------------------------------------------------*/
+
+template<typename K>
+void benchPacked(const std::string &sName, const std::vector<K> &keys, const std::vector<K> &queries, const bool &bDense=false) {
+   CPackedScoreMap<K, int, BENCH_PACKED_SIZE> map("Bench", keys.size()*2);
+   for (unsigned long i=0; i<keys.size(); ++i) {
+      map.updateScore(keys[i], i%BENCH_PACKED_SIZE, 1+i%7, 1);
+      map.updateScore(keys[i], (i*7)%BENCH_PACKED_SIZE, -1-int(i%3), 1);
+      // dense keys, like those of the tagger, score most of the packed indices
+      for (unsigned j=0; bDense && j<BENCH_PACKED_SIZE; j+=2)
+         map.updateScore(keys[i], j, 1+int((i+j)%5), 1);
+   }
+   map.computeAverage(2);
+
+   CPackedScoreType<int, BENCH_PACKED_SIZE> scores;
+   long checksum[2];
+   for (unsigned frozen=0; frozen<2; ++frozen) {
+      if (frozen) map.freeze(CScore<int>::eAverage);
+      scores.reset();
+      const clock_t start = clock();
+      for (unsigned long i=0; i<queries.size(); ++i)
+         map.getScore(scores, queries[i], CScore<int>::eAverage);
+      const clock_t time = clock()-start;
+      checksum[frozen] = 0;
+      for (unsigned j=0; j<BENCH_PACKED_SIZE; ++j)
+         checksum[frozen] += scores[j]*(j+1);
+      report("CPackedScoreMap " + sName + (frozen ? " frozen " : " chained"), queries.size(), time, checksum[frozen]);
+   }
+   ASSERT(checksum[0]==checksum[1], "The frozen packed scores differ from the hash map");
+}
+
+/*---------------------------------------------------------------
+ *
+ * bench - CScoreMap
+ *
+ *--------------------------------------------------------------*/
+
+template<typename K>
+void bench(const std::string &sName, const std::vector<K> &keys, const std::vector<K> &queries) {
+   CScoreMap<K, int> map("Bench", keys.size()*2);
+   for (unsigned long i=0; i<keys.size(); ++i)
+      map.updateScore(keys[i], 1+i%7, 1);
+   map.computeAverage(2);
+
+   long checksum[2];
+   for (unsigned frozen=0; frozen<2; ++frozen) {
+      if (frozen) map.freeze(CScore<int>::eAverage);
+      checksum[frozen] = 0;
+      const clock_t start = clock();
+      for (unsigned long i=0; i<queries.size(); ++i)
+         checksum[frozen] += map.getScore(queries[i], CScore<int>::eAverage);
+      const clock_t time = clock()-start;
+      report("CScoreMap       " + sName + (frozen ? " frozen " : " chained"), queries.size(), time, checksum[frozen]);
+   }
+   ASSERT(checksum[0]==checksum[1], "The frozen scores differ from the hash map");
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char *argv[]) {
+   try {
+      const unsigned long nKeys = argc > 1 ? atol(argv[1]) : 1000000;
+      const unsigned long nLookups = argc > 2 ? atol(argv[2]) : 10000000;
+      std::cout << nKeys << " keys, " << nLookups << " lookups" << std::endl;
+      std::vector<CWord> words, word_queries;
+      makeWords(nKeys, nLookups, words, word_queries);
+      benchPacked("word     ", words, word_queries);
+      benchPacked("dense    ", words, word_queries, true);
+      bench("word     ", words, word_queries);
+      std::vector<CWordPair> pairs, pair_queries;
+      makeWordPairs(nKeys, nLookups, pairs, pair_queries);
+      benchPacked("word pair", pairs, pair_queries);
+      bench("word pair", pairs, pair_queries);
+      return 0;
+   } catch (const std::string &e) {
+      std::cerr << "Error: " << e << std::endl;
+      return 1;
+   }
+}
@@ -16,6 +16,26 @@
 
 #include <algorithm>
 
+/*---------------------------------------------------------------
+ *
+ * pruneByMargin - move the items whose score is within margin
+ *                 of the best to the front and return how many
+ *                 there are; the items are swapped, not copied,
+ *                 so that each pointer is still kept once
+ *
+ *--------------------------------------------------------------*/
+
+template <typename CNode, typename SCORE>
+int pruneByMargin(CNode **items, const int &size, const SCORE &margin) {
+   SCORE best = items[0]->score;
+   for (int i=1; i<size; ++i)
+      if (items[i]->score > best) best = items[i]->score;
+   int kept = 0;
+   for (int i=0; i<size; ++i)
+      if (items[i]->score + margin >= best) std::swap(items[kept++], items[i]);
+   return kept;
+}
+
 /*===============================================================
  *
  * CAgendaSimple - an agenda 
@@ -28,6 +48,7 @@ template <typename CNode>
 class CAgendaSimple {
    private:
       const int m_nMaxSize;
+      int m_nWidth;                     // the number of items kept, up to m_nMaxSize
       CNode** m_lBeamPointer;
       CNode* m_lBeam;
       int m_nBeamSize;
@@ -35,7 +56,7 @@ class CAgendaSimple {
       bool m_bItemSorted; 
    public:
       // constructor and destructor method
-      CAgendaSimple(int nBeamSize): m_nMaxSize(nBeamSize) { 
+      CAgendaSimple(int nBeamSize): m_nMaxSize(nBeamSize), m_nWidth(nBeamSize) { 
          TRACE("Initialising CAgendaSimple");
          m_lBeam = new CNode[nBeamSize]; 
          m_lBeamPointer = new CNode*[nBeamSize]; 
@@ -56,6 +77,17 @@ class CAgendaSimple {
       }
       const CNode* item(int index) { assert(index<m_nBeamSize); return m_lBeamPointer[index]; }
       int size() { return m_nBeamSize; }
+      // keep fewer items than the agenda was made for; set when empty
+      void setWidth(int nWidth) { assert(nWidth>0 && nWidth<=m_nMaxSize && m_nBeamSize==0); m_nWidth = nWidth; }
+      int width() const { return m_nWidth; }
+      // drop the items that trail the best by more than margin
+      template <typename SCORE>
+      void prune(const SCORE &margin) {
+         assert( !m_bItemSorted );
+         if (m_nBeamSize < 2) return;
+         m_nBeamSize = pruneByMargin(m_lBeamPointer, m_nBeamSize, margin);
+         std::make_heap(m_lBeamPointer, m_lBeamPointer+m_nBeamSize, more);
+      }
 //      CNode* newItem() {
 //         assert( !m_bItemSorted ); 
 //         if (m_nBeamSize == m_nMaxSize) { 
@@ -70,11 +102,11 @@ class CAgendaSimple {
 //      }
       void insertItem(const CNode *item) {
          assert( !m_bItemSorted );
-         if (m_nBeamSize == m_nMaxSize) {
+         if (m_nBeamSize == m_nWidth) {
             if (*item > *(m_lBeamPointer[0])) {
-               std::pop_heap(m_lBeamPointer, m_lBeamPointer+m_nMaxSize, more);
-               *(m_lBeamPointer[m_nMaxSize-1]) = *item;
-               std::push_heap(m_lBeamPointer, m_lBeamPointer+m_nMaxSize, more);
+               std::pop_heap(m_lBeamPointer, m_lBeamPointer+m_nWidth, more);
+               *(m_lBeamPointer[m_nWidth-1]) = *item;
+               std::push_heap(m_lBeamPointer, m_lBeamPointer+m_nWidth, more);
             }
             return;
          }
@@ -93,6 +125,110 @@ class CAgendaSimple {
       inline static bool less(CNode *x, CNode *y) {return *x < *y;}
 };
 
+/*===============================================================
+ *
+ * CAgendaSelect - an agenda that selects the best items at once
+ *
+ * It can be used in place of CAgendaSimple. Instead of keeping a
+ * heap as the items come, which costs a pop and a push for most
+ * items once the agenda is full, the items of a round are only
+ * appended to a buffer, and the best of them are found with one
+ * nth_element when they are first read. The selected items are
+ * then in order, the best first, so sortItems costs nothing.
+ *
+ * Items of the same score are taken in the order they came in,
+ * so that the selection does not depend on the library. This is
+ * not the order of the heap of CAgendaSimple, so a decoder that
+ * switches can keep another of the items tied at the edge of the
+ * beam, and trains a different model.
+ *
+ *==============================================================*/
+
+template <typename CNode>
+class CAgendaSelect {
+   private:
+      // orders indice into the buffer by their items, best first
+      struct CMore {
+         const CNode *items;
+         CMore(const CNode *items) : items(items) {}
+         bool operator()(const int &x, const int &y) const {
+            if (items[x] > items[y]) return true;
+            if (items[y] > items[x]) return false;
+            return x < y;
+         }
+      };
+      const int m_nMaxSize;
+      int m_nWidth;                     // the number of items kept, up to m_nMaxSize
+      CNode* m_lItems;                  // the items of the round, as they came
+      std::vector<int> m_lOrder;        // indice into m_lItems, the selected first
+      int m_nCapacity;                  // the size of m_lItems, which grows as needed
+      int m_nItems;                     // the number of items in the round
+      int m_nBeamSize;                  // the number of items selected
+      bool m_bSelected;
+   public:
+      // constructor and destructor method
+      CAgendaSelect(int nBeamSize): m_nMaxSize(nBeamSize), m_nWidth(nBeamSize), m_nCapacity(nBeamSize*4) {
+         TRACE("Initialising CAgendaSelect");
+         m_lItems = new CNode[m_nCapacity];
+         clear();
+      }
+      ~CAgendaSelect() { delete[] m_lItems; }
+      // public methods for the agenda manipulation
+      void clear() {
+         m_nItems = 0;
+         m_nBeamSize = 0;
+         m_bSelected = true;
+      }
+      void insertItem(const CNode *item) {
+         if (m_nItems == m_nCapacity)
+            grow();
+         m_lItems[m_nItems++] = *item;
+         m_bSelected = false;
+      }
+      const CNode* item(int index) { if (!m_bSelected) select(); assert(index<m_nBeamSize); return &m_lItems[m_lOrder[index]]; }
+      int size() { if (!m_bSelected) select(); return m_nBeamSize; }
+      void sortItems() { if (!m_bSelected) select(); }
+      const CNode* bestItem( int index=0 ) { return item(index); }
+      // keep fewer items than the agenda was made for; set when empty
+      void setWidth(int nWidth) { assert(nWidth>0 && nWidth<=m_nMaxSize && m_nItems==0); m_nWidth = nWidth; }
+      int width() const { return m_nWidth; }
+      // drop the items that trail the best by more than margin
+      template <typename SCORE>
+      void prune(const SCORE &margin) {
+         if (!m_bSelected) select();
+         if (m_nBeamSize < 2) return;
+         const SCORE best = m_lItems[m_lOrder[0]].score;
+         while (m_lItems[m_lOrder[m_nBeamSize-1]].score + margin < best)
+            -- m_nBeamSize;
+      }
+
+   private:
+      void select() {
+         m_lOrder.resize(m_nItems);
+         for (int i=0; i<m_nItems; ++i)
+            m_lOrder[i] = i;
+         m_nBeamSize = std::min(m_nItems, m_nWidth);
+         const CMore more(m_lItems);
+         if (m_nBeamSize < m_nItems)
+            std::nth_element(m_lOrder.begin(), m_lOrder.begin()+m_nBeamSize, m_lOrder.end(), more);
+         std::sort(m_lOrder.begin(), m_lOrder.begin()+m_nBeamSize, more);
+         m_bSelected = true;
+      }
+      // the nodes are assigned rather than copy constructed, as for
+      // the other agendas
+      void grow() {
+         CNode *items = new CNode[m_nCapacity*2];
+         for (int i=0; i<m_nItems; ++i)
+            items[i] = m_lItems[i];
+         delete[] m_lItems;
+         m_lItems = items;
+         m_nCapacity *= 2;
+      }
+      // not to be copied
+      CAgendaSelect(const CAgendaSelect &);
+      CAgendaSelect &operator=(const CAgendaSelect &);
+};
+
 /*===============================================================
  *
  * CAgendaBeam - an agenda for the beam algorithm
@@ -129,6 +265,7 @@ template <typename CNode>
 class CAgendaBeam {
    private:
       const int m_nMaxSize;
+      int m_nWidth;                     // the number of items kept, up to m_nMaxSize
       CNode** m_lBeamPointer[2];
       CNode* m_lBeam[2];
       int m_nBeamSize[2];
@@ -136,7 +273,7 @@ class CAgendaBeam {
       int m_nGeneratorIndex;
    public:
       // constructor and destructor method
-      CAgendaBeam(int nBeamSize): m_nMaxSize(nBeamSize) { 
+      CAgendaBeam(int nBeamSize): m_nMaxSize(nBeamSize), m_nWidth(nBeamSize) { 
          TRACE("Initialising CAgendaBeam");
          m_lBeam[0] = new CNode[nBeamSize]; m_lBeam[1] = new CNode[nBeamSize]; 
          m_lBeamPointer[0] = new CNode*[nBeamSize]; m_lBeamPointer[1] = new CNode*[nBeamSize]; // don't say new (CNode*)[n], for it will generate "error: array bound forbidden after parenthesized type-id". 
@@ -171,9 +308,9 @@ class CAgendaBeam {
       int generatorSize() { return m_nBeamSize[m_nGenerator]; }
       int candidateSize() { return m_nBeamSize[m_nGenerated]; }
       CNode* candidateItem() {
-         if (m_nBeamSize[m_nGenerated] == m_nMaxSize) { // if reach beam limits
-            std::pop_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nMaxSize, more); // pop the smallest item
-            return m_lBeamPointer[m_nGenerated][m_nMaxSize-1]; // and reuse it.
+         if (m_nBeamSize[m_nGenerated] == m_nWidth) { // if reach beam limits
+            std::pop_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nWidth, more); // pop the smallest item
+            return m_lBeamPointer[m_nGenerated][m_nWidth-1]; // and reuse it.
          }
          // increase the beam size, then return pointer
          return m_lBeamPointer[m_nGenerated][m_nBeamSize[m_nGenerated]++];
@@ -182,10 +319,10 @@ class CAgendaBeam {
          std::push_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nBeamSize[m_nGenerated], more ); 
       }
       void pushCandidate(const CNode *node) { 
-         if (m_nBeamSize[m_nGenerated] == m_nMaxSize) { // if reach beam limits
+         if (m_nBeamSize[m_nGenerated] == m_nWidth) { // if reach beam limits
             if ( ! ( *node > *(m_lBeamPointer[m_nGenerated][0]) ) )
                return;
-            std::pop_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nMaxSize, more); // pop the smallest item
+            std::pop_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nWidth, more); // pop the smallest item
          }
          else {
             m_nBeamSize[m_nGenerated]++;
@@ -195,6 +332,16 @@ class CAgendaBeam {
          std::push_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nBeamSize[m_nGenerated], more ); 
       }
       void nextRound() { m_nGenerator = 1-m_nGenerator; m_nGenerated = 1-m_nGenerated; clear(m_nGenerated); }
+      // keep fewer items than the agenda was made for; set when cleared
+      void setWidth(int nWidth) { assert(nWidth>0 && nWidth<=m_nMaxSize && m_nBeamSize[m_nGenerated]==0); m_nWidth = nWidth; }
+      int width() const { return m_nWidth; }
+      // drop the candidates that trail the best by more than margin
+      template <typename SCORE>
+      void pruneCandidates(const SCORE &margin) {
+         if (m_nBeamSize[m_nGenerated] < 2) return;
+         m_nBeamSize[m_nGenerated] = pruneByMargin(m_lBeamPointer[m_nGenerated], m_nBeamSize[m_nGenerated], margin);
+         std::make_heap(m_lBeamPointer[m_nGenerated], m_lBeamPointer[m_nGenerated]+m_nBeamSize[m_nGenerated], more);
+      }
       CNode* bestGenerator() { assert(m_nBeamSize[m_nGenerator]!=0); return * std::max_element(m_lBeamPointer[m_nGenerator], m_lBeamPointer[m_nGenerator]+m_nBeamSize[m_nGenerator], less); }
       CNode* generator(int n) { if (n>=m_nBeamSize[m_nGenerator]) return 0; return m_lBeamPointer[m_nGenerator][n]; }
       void sortGenerators() { std::sort_heap(m_lBeamPointer[m_nGenerator], m_lBeamPointer[m_nGenerator]+m_nBeamSize[m_nGenerator], more); }
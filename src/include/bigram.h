@@ -12,6 +12,8 @@
 #ifndef _BIGRAM_H
 #define _BIGRAM_H
 
+#include "fingerprint.h"
+
 /*===============================================================
  *
  * Bigram
@@ -101,6 +103,11 @@ protected:
 template<class CUnigram>
 inline unsigned long int hash(const CBigram<CUnigram> &w) { return w.hash(); }
 
+template<class CUnigram>
+inline uint64_t fingerprint(const CBigram<CUnigram> &w, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(fingerprint(*w.first(), dictionary), fingerprint(*w.second(), dictionary));
+}
+
 //===============================================================
 
 template <class CUnigram>
@@ -31,12 +31,14 @@
 #include <map>
 #include <set>
 #include <stack>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <exception>
 #include <algorithm>
 #include <cmath>
+#include <climits>
 
 //using namespace std;
 
@@ -0,0 +1,118 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * fingerprint.h - 64 bit fingerprints for feature keys.        *
+ *                                                              *
+ * A fingerprint identifies a key independently of the process  *
+ * that computes it, so that it can be stored in binary models. *
+ * Types interned through a tokenizer (CWord) are translated    *
+ * into model word ids through a CFingerprintDictionary; other  *
+ * types whose hash() is stable (tags, labels, ints) fall back  *
+ * to their hash.                                               *
+ *                                                              *
+ * Types that need special treatment provide an overload of     *
+ * fingerprint() next to their definition, in the same way as   *
+ * hash() in hash_utils.h.                                      *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _FINGERPRINT_H
+#define _FINGERPRINT_H
+
+#include "hash_utils.h"
+
+/*===============================================================
+ *
+ * mixing functions
+ *
+ *==============================================================*/
+
+inline uint64_t mixFingerprint(uint64_t x) {
+   x ^= x >> 30;
+   x *= 0xbf58476d1ce4e5b9ULL;
+   x ^= x >> 27;
+   x *= 0x94d049bb133111ebULL;
+   x ^= x >> 31;
+   return x;
+}
+
+inline uint64_t combineFingerprint(const uint64_t &seed, const uint64_t &value) {
+   return mixFingerprint(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+/*===============================================================
+ *
+ * CFingerprintDictionary - maps word codes of the running
+ *                          process to the word ids of a model
+ *
+ *==============================================================*/
+
+class CFingerprintDictionary {
+
+public:
+   enum { UNKNOWN_WORD = 0xffffffffu };
+
+protected:
+   std::vector<uint32_t> m_lWordIds;
+   bool m_bIdentity;
+
+public:
+   CFingerprintDictionary(bool bIdentity=false) : m_bIdentity(bIdentity) { }
+   virtual ~CFingerprintDictionary() { }
+
+public:
+   // the dictionary used when writing models from the running process
+   static const CFingerprintDictionary &identity() {
+      static CFingerprintDictionary dictionary(true);
+      return dictionary;
+   }
+
+   void add(const unsigned long &code, const uint32_t &id) {
+      assert(!m_bIdentity);
+      if (code >= m_lWordIds.size())
+         m_lWordIds.resize(code+1, UNKNOWN_WORD);
+      m_lWordIds[code] = id;
+   }
+
+   uint64_t word(const unsigned long &code) const {
+      if (m_bIdentity)
+         return code;
+      return code < m_lWordIds.size() ? m_lWordIds[code] : static_cast<uint64_t>(UNKNOWN_WORD);
+   }
+
+   unsigned long size() const { return m_lWordIds.size(); }
+};
+
+/*===============================================================
+ *
+ * fingerprints for basic types
+ *
+ *==============================================================*/
+
+inline uint64_t fingerprint(const int &i, const CFingerprintDictionary &) { return mixFingerprint(static_cast<uint64_t>(static_cast<int64_t>(i))); }
+inline uint64_t fingerprint(const unsigned int &i, const CFingerprintDictionary &) { return mixFingerprint(i); }
+inline uint64_t fingerprint(const long &i, const CFingerprintDictionary &) { return mixFingerprint(static_cast<uint64_t>(i)); }
+inline uint64_t fingerprint(const unsigned long &i, const CFingerprintDictionary &) { return mixFingerprint(i); }
+inline uint64_t fingerprint(const long long &i, const CFingerprintDictionary &) { return mixFingerprint(static_cast<uint64_t>(i)); }
+inline uint64_t fingerprint(const unsigned long long &i, const CFingerprintDictionary &) { return mixFingerprint(i); }
+inline uint64_t fingerprint(const bool &b, const CFingerprintDictionary &) { return mixFingerprint(b?1:0); }
+
+inline uint64_t fingerprint(const std::string &s, const CFingerprintDictionary &) {
+   uint64_t retval = 0xcbf29ce484222325ULL;
+   for (unsigned long i=0; i<s.size(); ++i) {
+      retval ^= static_cast<unsigned char>(s[i]);
+      retval *= 0x100000001b3ULL;
+   }
+   return mixFingerprint(retval);
+}
+
+// types with a process independent hash
+template<typename T>
+inline uint64_t fingerprint(const T &t, const CFingerprintDictionary &) { return mixFingerprint(hash(t)); }
+
+template<typename T1, typename T2>
+inline uint64_t fingerprint(const std::pair<T1, T2> &o, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(fingerprint(o.first, dictionary), fingerprint(o.second, dictionary));
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * hash_frozen.h - the read only hash table for decoding.       *
+ *                                                              *
+ * The table is built once from a complete set of keys and is   *
+ * then only looked up. The slots are a power of two in number  *
+ * and are probed linearly. The 32 bit hash tags of the slots   *
+ * are kept in an array of their own, apart from the keys and   *
+ * values, so that probing reads few cache lines and keys are   *
+ * only compared when the tags match. Values are meant to be    *
+ * small; large payloads such as packed scores are stored       *
+ * elsewhere, with the value indexing into them.                *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _HASH_FROZEN_H
+#define _HASH_FROZEN_H
+
+#include "hash_utils.h"
+
+/*===============================================================
+ *
+ * CFrozenHashMap - open addressing read only hash table
+ *
+ *==============================================================*/
+
+template <typename K, typename V>
+class CFrozenHashMap {
+
+protected:
+   std::vector<uint32_t> m_tags;            // the high bits of the hash, 0 for empty slots
+   std::vector< std::pair<K, V> > m_slots;
+   std::vector< std::pair<K, V> > m_entries; // the entries before freezing
+   unsigned long m_nMask;
+   unsigned long m_nSize;
+   bool m_bFrozen;
+
+protected:
+   static uint64_t mix(const K &key) {
+      return static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ULL;
+   }
+   static uint32_t tag(const uint64_t &h) {
+      return static_cast<uint32_t>(h>>32) | 1;
+   }
+
+public:
+   CFrozenHashMap() : m_nMask(0), m_nSize(0), m_bFrozen(false) { }
+   virtual ~CFrozenHashMap() { }
+
+public:
+   bool frozen() const { return m_bFrozen; }
+   unsigned long size() const { return m_bFrozen ? m_nSize : m_entries.size(); }
+
+   // keys must be unique, since the table is built without lookups
+   void insert(const K &key, const V &value) {
+      ASSERT(!m_bFrozen, "hash_frozen.h: cannot insert into a frozen table");
+      m_entries.push_back(std::make_pair(key, value));
+   }
+
+   // build the slots, which are kept at most half full
+   void freeze() {
+      ASSERT(!m_bFrozen, "hash_frozen.h: the table is already frozen");
+      unsigned long size = 2;
+      while (size < m_entries.size()*2) size <<= 1;
+      m_nMask = size-1;
+      m_nSize = m_entries.size();
+      m_tags.assign(size, 0);
+      m_slots.resize(size);
+      for (unsigned long i=0; i<m_entries.size(); ++i) {
+         const uint64_t h = mix(m_entries[i].first);
+         unsigned long slot = (h>>32) & m_nMask;
+         while (m_tags[slot])
+            slot = (slot+1) & m_nMask;
+         m_tags[slot] = tag(h);
+         m_slots[slot] = m_entries[i];
+      }
+      std::vector< std::pair<K, V> >().swap(m_entries);
+      m_bFrozen = true;
+   }
+
+   void clear() {
+      std::vector<uint32_t>().swap(m_tags);
+      std::vector< std::pair<K, V> >().swap(m_slots);
+      std::vector< std::pair<K, V> >().swap(m_entries);
+      m_nMask = 0;
+      m_nSize = 0;
+      m_bFrozen = false;
+   }
+
+   const V *find(const K &key) const {
+      assert(m_bFrozen);
+      const uint64_t h = mix(key);
+      const uint32_t t = tag(h);
+      unsigned long slot = (h>>32) & m_nMask;
+      while (m_tags[slot]) {
+         if (m_tags[slot] == t && m_slots[slot].first == key)
+            return &m_slots[slot].second;
+         slot = (slot+1) & m_nMask;
+      }
+      return 0;
+   }
+
+   const V &find(const K &key, const V &val) const {
+      const V *retval = find(key);
+      return retval ? *retval : val;
+   }
+};
+
+#endif
@@ -114,7 +114,7 @@ public:
    }
    virtual ~CHashMap() {
       clear();
-      delete [] m_buckets; m_buckets = 0;
+      free(m_buckets); m_buckets = 0;
       delete m_pool; m_pool = 0;
       c_free = 0;
    }
@@ -125,10 +125,9 @@ public:
    void init() {
       ASSERT(m_buckets==0, "Cannot initialize hashmap after initialization");
       m_pool = new CMemoryPool<CEntry>(m_nTableSize);
-      m_buckets = new CEntry*[m_nTableSize] ;
-//      for (int i=0; i<m_nTableSize; ++i)
-//         m_buckets[i]=0;
-      memset(m_buckets, 0, m_nTableSize*sizeof(CEntry*));
+      // calloc leaves the pages of tables that are never filled untouched
+      m_buckets = static_cast<CEntry**>(calloc(m_nTableSize, sizeof(CEntry*))) ;
+      ASSERT(m_buckets!=0, "Cannot allocate hashmap buckets");
    }
 
 protected:
@@ -138,10 +137,9 @@ protected:
    // static CMemoryPool<CEntry> &getPool() { static CMemoryPool<CEntry> pool(POOL_BLOCK_SIZE); return pool; }
 
    CEntry *allocate() {
-      static CEntry *retval;
       CEntry* &c_freed = c_free;
       if (c_freed) {
-         retval = c_freed;
+         CEntry *retval = c_freed;
          c_freed = c_freed->m_next;
          retval->m_next = 0;
          return retval;
@@ -13,6 +13,7 @@
 #define _HASHMAP_SCORE_H
 
 #include "hash.h"
+#include "hash_frozen.h"
 #include "score.h"
 
 /*===============================================================
@@ -27,6 +28,10 @@ class CScoreMap : public CHashMap< K , CScore<SCORE_TYPE> > {
 protected:
    const CScore<SCORE_TYPE> m_zero ;
 
+   // scores frozen for decoding replace the hash map
+   CFrozenHashMap<K, SCORE_TYPE> m_frozen ;
+   int m_nFrozenWhich ;
+
 #ifdef NO_NEG_FEATURE
 protected:
    const CScoreMap *m_positive;
@@ -57,6 +62,11 @@ public:
 #endif
 
    virtual inline SCORE_TYPE getScore( const K &key , const int &which ) {
+      if ( m_frozen.frozen() ) {
+         assert( which == m_nFrozenWhich );
+         const SCORE_TYPE *score = m_frozen.find( key );
+         return score ? *score : 0;
+      }
       return this->find( key , m_zero ).score( which );
    }
 
@@ -66,6 +76,7 @@ public:
 #endif // update can only happen with defined features
 			{
 //				fprintf(stderr, "update feature by %.2f\n", amount);
+         assert( !m_frozen.frozen() );
       	(*this)[ key ].updateCurrent( amount , round );
 			}
    }
@@ -87,6 +98,20 @@ public:
       }
    }
 
+   // replace the hash map with a read only table of the given scores for decoding
+   void freeze(const int &which) {
+      if ( m_frozen.frozen() ) return;
+      typename CHashMap< K, CScore<SCORE_TYPE> >::iterator it = this->begin();
+      while (it != this->end()) {
+         if ( it.second().score(which) != 0 )
+            m_frozen.insert( it.first() , it.second().score(which) );
+         ++ it;
+      }
+      m_frozen.freeze();
+      m_nFrozenWhich = which;
+      CHashMap< K, CScore<SCORE_TYPE> >::clear();
+   }
+
    void computeAverage(unsigned long int round) {
       count = 0;
       typename CHashMap< K, CScore<SCORE_TYPE> >::iterator it = this->begin();
@@ -0,0 +1,363 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * hashmap_score_fingerprint.h - the definitions for packed     *
+ *                               scores keyed by fingerprints.  *
+ *                                                              *
+ * A feature is identified by the 64 bit fingerprint of its     *
+ * template name mixed with the fingerprint of its key, and     *
+ * the maps of all templates in a weight may share one flat     *
+ * table of fingerprints, so that looking a feature up hashes   *
+ * a few integers and probes one array, instead of combining    *
+ * the hashes of the key objects and comparing them in the      *
+ * buckets of a map per template. Two features with the same    *
+ * fingerprint share their scores; with 64 bits this is not     *
+ * expected to happen in a model.                               *
+ *                                                              *
+ * The keys are only kept when training, to write the model in  *
+ * the text format of CPackedScoreMap, which both maps read.    *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _HASHMAP_SCORE_FINGERPRINT_H
+#define _HASHMAP_SCORE_FINGERPRINT_H
+
+#include "fingerprint.h"
+#include "hashmap_score_packed.h"
+
+/*===============================================================
+ *
+ * CFingerprintScoreTable - packed scores by fingerprint
+ *
+ * The slots are a power of two in number, are probed linearly
+ * and are kept at most half full. The scores are allocated in
+ * blocks apart from the slots, where they do not move when the
+ * slots grow, and the blocks are kept when the table is cleared.
+ *
+ *==============================================================*/
+
+template <typename SCORE_TYPE, unsigned PACKED_SIZE>
+class CFingerprintScoreTable {
+
+public:
+   typedef CPackedScore<SCORE_TYPE, PACKED_SIZE> CScores;
+
+protected:
+   enum { BLOCK_BITS = 10, BLOCK_SIZE = 1<<BLOCK_BITS };
+
+   struct CSlot {
+      uint64_t fingerprint;
+      uint32_t index;   // one more than the index of the scores, zero when empty
+   };
+
+   std::vector<CSlot> m_lSlots;
+   unsigned long m_nMask;
+   std::vector<CScores*> m_lBlocks;
+   uint32_t m_nSize;
+
+public:
+   CFingerprintScoreTable() : m_nMask(0), m_nSize(0) { }
+   virtual ~CFingerprintScoreTable() {
+      for (unsigned long i=0; i<m_lBlocks.size(); ++i)
+         delete [] m_lBlocks[i];
+   }
+
+public:
+   inline unsigned long size() const { return m_nSize; }
+   inline CScores &scores(const uint32_t &index) { return m_lBlocks[index>>BLOCK_BITS][index&(BLOCK_SIZE-1)]; }
+   inline const CScores &scores(const uint32_t &index) const { return m_lBlocks[index>>BLOCK_BITS][index&(BLOCK_SIZE-1)]; }
+
+   // the index of the scores of a fingerprint, or -1 when it is not in the table
+   inline int32_t find(const uint64_t &fingerprint) const {
+      if (m_nSize == 0) return -1;
+      for (unsigned long i=fingerprint&m_nMask; ; i=(i+1)&m_nMask) {
+         const CSlot &slot = m_lSlots[i];
+         if (slot.index == 0) return -1;
+         if (slot.fingerprint == fingerprint) return slot.index-1;
+      }
+   }
+
+   // the index of the scores of a fingerprint, which are added if it is new
+   uint32_t insert(const uint64_t &fingerprint, bool &bNew) {
+      if ((m_nSize+1)*2 > m_lSlots.size())
+         grow();
+      unsigned long i;
+      for (i=fingerprint&m_nMask; m_lSlots[i].index; i=(i+1)&m_nMask) {
+         if (m_lSlots[i].fingerprint == fingerprint) {
+            bNew = false;
+            return m_lSlots[i].index-1;
+         }
+      }
+      bNew = true;
+      if ((m_nSize>>BLOCK_BITS) == m_lBlocks.size())
+         m_lBlocks.push_back(new CScores[BLOCK_SIZE]);
+      m_lSlots[i].fingerprint = fingerprint;
+      m_lSlots[i].index = ++m_nSize;
+      return m_nSize-1;
+   }
+
+   void clear() {
+      if (m_nSize == 0) return;
+      for (uint32_t i=0; i<m_nSize; ++i)
+         scores(i).clear();
+      m_nSize = 0;
+      CSlot empty;
+      empty.fingerprint = 0;
+      empty.index = 0;
+      std::fill(m_lSlots.begin(), m_lSlots.end(), empty);
+   }
+
+protected:
+   void grow() {
+      std::vector<CSlot> slots;
+      slots.swap(m_lSlots);
+      const unsigned long size = slots.empty() ? BLOCK_SIZE : slots.size()*2;
+      CSlot empty;
+      empty.fingerprint = 0;
+      empty.index = 0;
+      m_lSlots.assign(size, empty);
+      m_nMask = size-1;
+      for (unsigned long i=0; i<slots.size(); ++i) {
+         if (slots[i].index == 0) continue;
+         unsigned long j;
+         for (j=slots[i].fingerprint&m_nMask; m_lSlots[j].index; j=(j+1)&m_nMask) ;
+         m_lSlots[j] = slots[i];
+      }
+   }
+};
+
+/*===============================================================
+ *
+ * CFingerprintScoreMap - map to packed score by fingerprint
+ *
+ * It can replace CPackedScoreMap as the map of a template. The
+ * map uses a table of its own unless it is attached to a table
+ * shared by the maps of a weight; the weight then has to clear
+ * all of its maps together, which clears the shared table.
+ *
+ *==============================================================*/
+
+template <typename K, typename SCORE_TYPE, unsigned PACKED_SIZE>
+class CFingerprintScoreMap {
+
+public:
+   typedef CFingerprintScoreTable<SCORE_TYPE, PACKED_SIZE> CTable;
+   typedef CPackedScore<SCORE_TYPE, PACKED_SIZE> CScores;
+
+protected:
+   const CScores m_zero ;
+   const uint64_t m_nTemplate ;
+   CTable m_ownTable ;
+   CTable *m_table ;
+   std::vector<uint64_t> m_lFingerprints ; // the features of this map in the order they were added
+   std::vector<uint32_t> m_lIndices ;
+#ifndef PERCEPTRON_FOR_DECODING
+   std::deque<K> m_lKeys ;
+#endif
+
+#ifdef NO_NEG_FEATURE
+protected:
+   const CFingerprintScoreMap *m_positive;
+#endif
+
+public:
+   const std::string name ;
+   bool initialized ;
+   unsigned count ;
+
+public:
+   CFingerprintScoreMap(std::string input_name, int TABLE_SIZE, bool bInitMap=true) : m_zero() , m_nTemplate(fingerprint(input_name, CFingerprintDictionary::identity())) , m_table(&m_ownTable) ,
+#ifdef NO_NEG_FEATURE
+m_positive(this) ,
+#endif
+name(input_name) , initialized(bInitMap) , count(0) {
+      assert(m_zero.empty());
+   }
+
+public:
+   inline void init() {
+      initialized = true;
+   }
+
+   // share the table of the maps of a weight, before adding any scores
+   void attach(CTable &table) {
+      assert( m_lIndices.empty() && m_ownTable.size() == 0 );
+      m_table = &table;
+   }
+
+   inline uint64_t fingerprintOf(const K &key) const {
+      return combineFingerprint( m_nTemplate , fingerprint( key , CFingerprintDictionary::identity() ) );
+   }
+
+#ifdef NO_NEG_FEATURE
+   inline void setPositiveFeature(const CFingerprintScoreMap &positive) {
+      m_positive = &positive;
+   }
+
+   inline void addPositiveFeature(const K &key, const unsigned &index) {
+      (*this)[key][index];
+   }
+#endif // define features
+
+   inline void getScore( CPackedScoreType<SCORE_TYPE, PACKED_SIZE>&o, const K &key , const int &which ) {
+      const int32_t index = m_table->find( fingerprintOf( key ) );
+      if ( index >= 0 ) m_table->scores( index ).add( o , which );
+      PROFILE_LOOKUP( index >= 0 );
+   }
+
+   inline void updateScore( const K &key , const unsigned &index , const SCORE_TYPE &amount , const int &round ) {
+#ifdef NO_NEG_FEATURE
+      const int32_t positive = m_positive->m_table->find( m_positive->fingerprintOf( key ) );
+      if ( positive >= 0 && m_positive->m_table->scores( positive ).element( index ) )
+#endif // update can only happen with defined features
+      (*this)[ key ].updateCurrent( index , amount , round );
+   }
+
+   inline void getOrUpdateScore( CPackedScoreType<SCORE_TYPE, PACKED_SIZE> &out , const K &key , const unsigned &index , const int &which , const SCORE_TYPE &amount=0 , const int &round=0 ) {
+#ifdef NO_NEG_FEATURE
+      if ( round == -1 ) {
+         addPositiveFeature( key, index );
+         return;
+      }
+#endif
+      if ( amount == 0 ) {
+         getScore( out , key , which );
+      }
+      else {
+         assert( round > 0 );
+         updateScore( key , index , amount , round ) ;
+      }
+   }
+
+   // the scores of a key, which are added if the key is new
+   CScores &operator [](const K &key) {
+      return entry( fingerprintOf( key ) , key );
+   }
+
+   void computeAverage(unsigned long int round) {
+      for (unsigned long i=0; i<m_lIndices.size(); ++i)
+         m_table->scores(m_lIndices[i]).updateAverage(round);
+      count = m_lIndices.size();
+   }
+
+   void clear() {
+      m_table->clear();
+      m_lFingerprints.clear();
+      m_lIndices.clear();
+#ifndef PERCEPTRON_FOR_DECODING
+      m_lKeys.clear();
+#endif
+   }
+
+public:
+   // the maps of the same template in two weights
+   void addCurrent(CFingerprintScoreMap &mp, const int &round) {
+      assert( m_nTemplate == mp.m_nTemplate );
+      for (unsigned long i=0; i<mp.m_lIndices.size(); ++i)
+         mp.other(*this, i).addCurrent(mp.m_table->scores(mp.m_lIndices[i]), round);
+   }
+   void subtractCurrent(CFingerprintScoreMap &mp, const int &round) {
+      assert( m_nTemplate == mp.m_nTemplate );
+      for (unsigned long i=0; i<mp.m_lIndices.size(); ++i)
+         mp.other(*this, i).subtractCurrent(mp.m_table->scores(mp.m_lIndices[i]), round);
+   }
+   void scaleCurrent(const SCORE_TYPE &scale, const int &round) {
+      for (unsigned long i=0; i<m_lIndices.size(); ++i)
+         m_table->scores(m_lIndices[i]).scaleCurrent(scale, round);
+   }
+   SCORE_TYPE squareNorm() {
+      SCORE_TYPE retval = 0;
+      for (unsigned long i=0; i<m_lIndices.size(); ++i)
+         retval += m_table->scores(m_lIndices[i]).squareNorm();
+      return retval;
+   }
+
+   SCORE_TYPE dotProduct(CFingerprintScoreMap &mp) {
+      assert( m_nTemplate == mp.m_nTemplate );
+      SCORE_TYPE retval = 0;
+      for (unsigned long i=0; i<m_lIndices.size(); ++i) {
+         const int32_t index = mp.m_table->find(m_lFingerprints[i]);
+         retval += m_table->scores(m_lIndices[i]).dotProduct(index >= 0 ? mp.m_table->scores(index) : m_zero);
+      }
+      return retval;
+   }
+
+protected:
+   CScores &entry(const uint64_t &fingerprint, const K &key) {
+      bool bNew;
+      const uint32_t index = m_table->insert(fingerprint, bNew);
+      if (bNew) {
+         m_lFingerprints.push_back(fingerprint);
+         m_lIndices.push_back(index);
+#ifndef PERCEPTRON_FOR_DECODING
+         m_lKeys.push_back(key);
+#endif
+      }
+      return m_table->scores(index);
+   }
+
+   // the scores of the i-th feature of this map in the other map
+   CScores &other(CFingerprintScoreMap &mp, const unsigned long &i) {
+#ifdef PERCEPTRON_FOR_DECODING
+      THROW("hashmap_score_fingerprint.h: " << name << " cannot be trained when compiled for decoding");
+#else
+      return mp.entry(m_lFingerprints[i], m_lKeys[i]);
+#endif
+   }
+
+   template<typename K1, typename S1, unsigned P1>
+   friend std::ostream & operator << (std::ostream &os, CFingerprintScoreMap<K1, S1, P1> &score_map);
+};
+
+//===============================================================
+
+template<typename K, typename SCORE_TYPE, unsigned PACKED_SIZE>
+inline
+std::istream & operator >> (std::istream &is, CFingerprintScoreMap<K, SCORE_TYPE, PACKED_SIZE> &score_map) {
+   if (!is) return is ;
+   std::string s ;
+   getline(is, s) ;
+   // match name
+   const unsigned &size = score_map.name.size();
+   if ( s.substr(0, size)!=score_map.name ) THROW("hashmap_score_fingerprint.h: the expected score map " << score_map.name << " is not matched.");
+   if ( !score_map.initialized )
+      score_map.init();
+   K key ;
+   char c ;
+   if (!getline(is, s)) THROW("hash map file ended unexpectedly");
+   while (is && !(s.empty())) {
+      std::istringstream iss(s) ;
+      iss >> key;
+      iss >> c;
+      ASSERT( c == ':' , "Hash map does not match key : value format (column missing); key was: " << key) ;
+      iss >> score_map[key] ;
+      getline(is, s);
+   }
+   return is ;
+}
+
+template<typename K, typename SCORE_TYPE, unsigned PACKED_SIZE>
+inline
+std::ostream & operator << (std::ostream &os, CFingerprintScoreMap<K, SCORE_TYPE, PACKED_SIZE> &score_map) {
+   assert(os);
+#ifdef PERCEPTRON_FOR_DECODING
+   THROW("hashmap_score_fingerprint.h: " << score_map.name << " keeps no keys to save when compiled for decoding");
+#else
+   if (score_map.count)
+      os << score_map.name << ' ' << score_map.count << std::endl ;
+   else
+      os << score_map.name << std::endl ;
+
+   for (unsigned long i=0; i<score_map.m_lIndices.size(); ++i) {
+      const CPackedScore<SCORE_TYPE, PACKED_SIZE> &scores = score_map.m_table->scores(score_map.m_lIndices[i]);
+#ifndef NO_NEG_FEATURE
+      if ( !scores.empty() )
+#endif // do not write zero scores if allow negative scores
+         os << score_map.m_lKeys[i] << "\t:\t" << scores << std::endl ;
+   }
+   os << std::endl ;
+#endif
+   return os ;
+}
+
+#endif
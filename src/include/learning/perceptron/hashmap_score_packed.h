@@ -12,7 +12,11 @@
 
 #include "hash.h"
 #include "hash_small.h"
+#include "hash_frozen.h"
 #include "score.h"
+#include "score_binary.h"
+#include "score_packed_simd.h"
+#include "profile.h"
 
 /*===============================================================
  *
@@ -54,9 +58,12 @@ public:
       assert(index<PACKED_SIZE);
       return scores[index];
    }
+   // adds a row of PACKED_SIZE scores
+   void add(const SCORE_TYPE *row) {
+      packed_score::add(scores, row, PACKED_SIZE);
+   }
    void operator +=(const CPackedScoreType &i) {
-      for (unsigned index=0; index<PACKED_SIZE; ++index)
-         scores[index]+=i.scores[index];
+      add(i.scores);
    }
 };
 
@@ -88,6 +95,18 @@ std::ostream & operator << (std::ostream &os, CPackedScoreType<SCORE_TYPE, PACKE
    return os;
 }
 
+/*===============================================================
+ *
+ * CFrozenPackedScores - the non zero scores of a frozen key
+ *
+ *==============================================================*/
+
+struct CFrozenPackedScores {
+   uint32_t offset;   // into the frozen scores, or the row of dense scores
+   uint32_t count;    // DENSE for a row of dense scores
+   static const uint32_t DENSE = 0xffffffff;
+};
+
 /*===============================================================
  *
  * CPackedScoreMap - map to packed score definition
@@ -99,6 +118,18 @@ class CPackedScoreMap : public CHashMap< K , CPackedScore<SCORE_TYPE, PACKED_SIZ
 
 protected:
    const CPackedScore<SCORE_TYPE, PACKED_SIZE> m_zero ;
+   CBinaryScoreTable<SCORE_TYPE> m_binary ; // scores from a binary model replace the hash map
+
+   // scores frozen for decoding replace the hash map
+   CFrozenHashMap<K, CFrozenPackedScores> m_frozen ;
+   std::vector< std::pair<unsigned, SCORE_TYPE> > m_frozenScores ; // index and score pairs
+   std::vector<SCORE_TYPE> m_frozenRows ; // the scores of dense keys, a row each
+   unsigned long m_nFrozenRowsStart ; // the first score of the rows that is aligned
+   int m_nFrozenWhich ;
+
+   // the map of a worker in iterative parameter mixing holds its changes
+   // to the map of the model, which it reads without locking
+   const CPackedScoreMap *m_base ;
 
 #ifdef NO_NEG_FEATURE
 protected:
@@ -111,7 +142,7 @@ public:
    unsigned count ;
 
 public:
-   CPackedScoreMap(std::string input_name, int TABLE_SIZE, bool bInitMap=true) : name(input_name) , initialized(bInitMap) , count(0) , m_zero() , CHashMap<K,CPackedScore<SCORE_TYPE, PACKED_SIZE> >(TABLE_SIZE, bInitMap)
+   CPackedScoreMap(std::string input_name, int TABLE_SIZE, bool bInitMap=true) : name(input_name) , initialized(bInitMap) , count(0) , m_zero() , CHashMap<K,CPackedScore<SCORE_TYPE, PACKED_SIZE> >(TABLE_SIZE, bInitMap) , m_nFrozenRowsStart(0) , m_base(0)
 #ifdef NO_NEG_FEATURE
 , m_positive(this)
 #endif
@@ -136,13 +167,15 @@ public:
 #endif // define features
 
    virtual inline void getScore( CPackedScoreType<SCORE_TYPE, PACKED_SIZE>&o, const K &key , const int &which ) {
-      this->find( key , m_zero ).add( o , which );
+      const bool hit = lookup( o , key , which );
+      PROFILE_LOOKUP( hit );
    }
 
    virtual inline void updateScore( const K &key , const unsigned &index , const SCORE_TYPE &amount , const int &round ) {
 #ifdef NO_NEG_FEATURE
       if (m_positive->element(key) && (*m_positive)[key].element(index))
 #endif // update can only happen with defined features
+      assert( !m_binary.valid() && !m_frozen.frozen() );
       (*this)[ key ].updateCurrent( index , amount , round );
    }
 
@@ -154,7 +187,8 @@ public:
       }
 #endif
       if ( amount == 0 ) {
-         this->find(key, m_zero).add(out, which) ;
+         const bool hit = lookup( out , key , which );
+         PROFILE_LOOKUP( hit );
       }
       else {
          assert( round > 0 );
@@ -172,6 +206,106 @@ public:
       }
    }
 
+protected:
+   // adds the scores of the key, and returns whether it has any
+   inline bool lookup( CPackedScoreType<SCORE_TYPE, PACKED_SIZE> &o , const K &key , const int &which ) const {
+      if ( m_frozen.frozen() )
+         return getFrozenScore( o , key , which );
+      if ( m_binary.valid() )
+         return m_binary.add( o , fingerprint( key , m_binary.dictionary() ) );
+      const CPackedScore<SCORE_TYPE, PACKED_SIZE> &scores = this->find( key , m_zero );
+      bool hit = &scores != &m_zero;
+      scores.add( o , which );
+      if ( m_base ) {
+         const CPackedScore<SCORE_TYPE, PACKED_SIZE> &base = m_base->find( key , m_zero );
+         hit = hit || &base != &m_zero;
+         base.add( o , which );
+      }
+      return hit;
+   }
+
+   inline bool getFrozenScore( CPackedScoreType<SCORE_TYPE, PACKED_SIZE> &o , const K &key , const int &which ) const {
+      assert( which == m_nFrozenWhich );
+      const CFrozenPackedScores *scores = m_frozen.find( key );
+      if ( scores == 0 ) return false;
+      if ( scores->count == CFrozenPackedScores::DENSE ) {
+         o.add( &m_frozenRows[m_nFrozenRowsStart + scores->offset] );
+         return true;
+      }
+      const std::pair<unsigned, SCORE_TYPE> *score = &m_frozenScores[scores->offset];
+      for ( uint32_t i=0; i<scores->count; ++i )
+         o[score[i].first] += score[i].second;
+      return true;
+   }
+
+public:
+   // replace the hash map with a read only table of the given scores for decoding;
+   // keys with at least half of their scores non zero keep them as an aligned
+   // row, which is added whole, and other keys keep index and score pairs
+   void freeze(const int &which) {
+      if ( m_binary.valid() || m_frozen.frozen() ) return;
+      const unsigned stride = packed_score::stride<SCORE_TYPE>(PACKED_SIZE);
+      std::vector<unsigned> indices;
+      std::vector<SCORE_TYPE> values;
+      unsigned long rows = 0;
+      typename CHashMap< K, CPackedScore<SCORE_TYPE, PACKED_SIZE> >::iterator it = this->begin();
+      while (it != this->end()) {
+         it.second().sparse(indices, values, which);
+         if (indices.size()*2 >= PACKED_SIZE)
+            ++ rows;
+         ++ it;
+      }
+      // one more row leaves room to align the first
+      m_frozenRows.assign( rows ? (rows+1)*stride : 0 , 0 );
+      m_nFrozenRowsStart = 0;
+      while ( rows && reinterpret_cast<uintptr_t>( &m_frozenRows[m_nFrozenRowsStart] ) % PACKED_SCORE_ALIGN )
+         ++ m_nFrozenRowsStart;
+      rows = 0;
+      CFrozenPackedScores scores;
+      it = this->begin();
+      while (it != this->end()) {
+         it.second().sparse(indices, values, which);
+         if (indices.size()*2 >= PACKED_SIZE) {
+            scores.offset = rows*stride;
+            scores.count = CFrozenPackedScores::DENSE;
+            for (unsigned i=0; i<indices.size(); ++i)
+               m_frozenRows[m_nFrozenRowsStart + scores.offset + indices[i]] = values[i];
+            m_frozen.insert(it.first(), scores);
+            ++ rows;
+         }
+         else if (!indices.empty()) {
+            scores.offset = m_frozenScores.size();
+            scores.count = indices.size();
+            for (unsigned i=0; i<indices.size(); ++i)
+               m_frozenScores.push_back(std::make_pair(indices[i], values[i]));
+            m_frozen.insert(it.first(), scores);
+         }
+         ++ it;
+      }
+      m_frozen.freeze();
+      m_nFrozenWhich = which;
+      clear();
+   }
+
+   // maps must be attached in the order they were saved
+   void attachBinary(CBinaryModelReader &model) {
+      m_binary = model.nextTable<SCORE_TYPE>(name);
+   }
+
+   void saveBinary(CBinaryModelWriter<SCORE_TYPE> &model) {
+      ASSERT( !m_binary.valid() && !m_frozen.frozen() , "hashmap_score_packed.h: cannot convert " << name << " from a binary or frozen model" );
+      CBinaryScoreTableBuilder<SCORE_TYPE> table;
+      std::vector<unsigned> indices;
+      std::vector<SCORE_TYPE> values;
+      typename CHashMap< K, CPackedScore<SCORE_TYPE, PACKED_SIZE> >::iterator it = this->begin();
+      while (it != this->end()) {
+         it.second().sparse(indices, values, CScore<SCORE_TYPE>::eAverage);
+         table.insert(fingerprint(it.first(), CFingerprintDictionary::identity()), indices, values);
+         ++ it;
+      }
+      model.addTable(name, table);
+   }
+
 //   void clearScores() {
 //      typename CHashMap< K, CPackedScore<SCORE_TYPE, PACKED_SIZE> >::iterator it = this->begin();
 //      while (it != this->end()) {
@@ -192,6 +326,26 @@ public:
    }
 
 public:
+   void setBase(const CPackedScoreMap *base) {
+      ASSERT( !m_binary.valid() && !m_frozen.frozen() , "hashmap_score_packed.h: cannot train " << name << " from a binary or frozen model" );
+      m_base = base;
+   }
+
+   // adds the changes of a worker in iterative parameter mixing, whose
+   // updates are the number of workers times those of serial training,
+   // so that the weights move by the mean of the changes of the workers
+   // exactly; the averaged weights add up the averaged changes, and the
+   // caller averages the weights of this map over the rounds of all the
+   // workers before mixing
+   void mix(CPackedScoreMap &worker, const SCORE_TYPE &workers) {
+      assert( worker.m_base == this );
+      typename CHashMap< K, CPackedScore<SCORE_TYPE, PACKED_SIZE> >::iterator it = worker.begin();
+      while (it != worker.end()) {
+         (*this)[it.first()].mix(it.second(), workers);
+         ++ it;
+      }
+   }
+
    void addCurrent(CPackedScoreMap &mp, const int &round) {
       typename CHashMap< K, CPackedScore<SCORE_TYPE, PACKED_SIZE> >::iterator it = mp.begin();
       while (it != mp.end()) {
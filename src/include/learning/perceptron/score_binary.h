@@ -0,0 +1,506 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * score_binary.h - the binary model format for packed scores.  *
+ *                                                              *
+ * A binary model is mapped into memory read only, so that it   *
+ * loads without parsing and processes that decode with the     *
+ * same model share the pages.                                  *
+ *                                                              *
+ * Layout (native endian, sections aligned to 8 bytes):         *
+ *    header                                                    *
+ *    string lists - count, offsets[count+1], characters        *
+ *    score tables - name, buckets, values, value bits, scale,  *
+ *                   index bits, keys, offsets, indices, values *
+ *                                                              *
+ * A score table is an open addressing hash table of 64 bit key *
+ * fingerprints. The sparse lists of the non zero scores of the *
+ * keys are stored in the order of their buckets, so that each  *
+ * bucket only keeps the offset of its list, which ends where   *
+ * the list of the next bucket starts. The indices of the lists *
+ * take 8, 16 or 32 bits, the fewest that hold the largest one. *
+ *                                                              *
+ * The values of a table are either of the score type, or are   *
+ * quantized to 16 or 8 bit integers, which are multiplied by   *
+ * the scale of the table when the scores are looked up.        *
+ * Version 1 models have no quantization fields, and versions 1 *
+ * and 2 keep a 16 byte bucket of the key, the offset and the   *
+ * count, with 32 bit indices.                                  *
+ *                                                              *
+ * The names of the tables need not be unique, since two maps   *
+ * of a model can share one, so the tables are read back in the *
+ * order they were written, and the names only check the order. *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _SCORE_BINARY_H
+#define _SCORE_BINARY_H
+
+#include "fingerprint.h"
+#include "mmap_file.h"
+
+/*===============================================================
+ *
+ * definitions
+ *
+ *==============================================================*/
+
+const char BINARY_MODEL_MAGIC[8] = {'Z', 'P', 'A', 'R', 'B', 'I', 'N', '\0'};
+const uint32_t BINARY_MODEL_VERSION = 3;
+const uint32_t BINARY_MODEL_ENDIAN = 0x01020304;
+
+struct CBinaryModelHeader {
+   char magic[8];
+   uint32_t version;
+   uint32_t endian;
+   uint32_t score_size;
+   uint32_t score_floating;
+   uint32_t flags;
+   uint32_t lists;
+   uint32_t tables;
+   uint32_t reserved;
+};
+
+// the bucket of versions 1 and 2
+struct CBinaryScoreBucket {
+   uint64_t key;      // 0 for empty buckets
+   uint32_t offset;   // into the indices and the values
+   uint32_t count;
+};
+
+inline uint64_t binaryAlign(const uint64_t &n) { return (n+7) & ~static_cast<uint64_t>(7); }
+
+// 0 marks empty buckets
+inline uint64_t binaryKey(const uint64_t &fp) { return fp ? fp : 1; }
+
+template<typename SCORE_TYPE>
+inline uint32_t binaryScoreFloating() { return static_cast<SCORE_TYPE>(0.5) != 0 ? 1 : 0; }
+
+// the number of bits of quantized values, 0 for the score type itself
+inline bool binaryValueBitsValid(const uint64_t &bits) { return bits == 0 || bits == 8 || bits == 16; }
+
+inline bool binaryIndexBitsValid(const uint64_t &bits) { return bits == 8 || bits == 16 || bits == 32; }
+
+/*===============================================================
+ *
+ * CBinaryScoreTable - a score table in a mapped binary model
+ *
+ *==============================================================*/
+
+template<typename SCORE_TYPE>
+class CBinaryScoreTable {
+
+protected:
+   const uint64_t *m_keys;
+   const uint32_t *m_offsets;
+   const CBinaryScoreBucket *m_buckets;   // versions 1 and 2
+   uint64_t m_nMask;
+   const char *m_indices;
+   uint64_t m_nIndexBits;
+   const SCORE_TYPE *m_values;
+   const int16_t *m_values16;
+   const int8_t *m_values8;
+   SCORE_TYPE m_scale;
+   const CFingerprintDictionary *m_dictionary;
+
+protected:
+   void setValues(const char *values, const uint64_t &nBits) {
+      if (nBits == 16) m_values16 = reinterpret_cast<const int16_t*>(values);
+      else if (nBits == 8) m_values8 = reinterpret_cast<const int8_t*>(values);
+      else m_values = reinterpret_cast<const SCORE_TYPE*>(values);
+   }
+
+   template<typename CPackedScoreType, typename INDEX_TYPE>
+   void addList(CPackedScoreType &o, const uint32_t &offset, const uint32_t &count) const {
+      const INDEX_TYPE *index = reinterpret_cast<const INDEX_TYPE*>(m_indices) + offset;
+      if (m_values) {
+         const SCORE_TYPE *value = m_values + offset;
+         for (uint32_t i=0; i<count; ++i)
+            o[index[i]] += value[i];
+      }
+      else if (m_values16) {
+         const int16_t *value = m_values16 + offset;
+         for (uint32_t i=0; i<count; ++i)
+            o[index[i]] += static_cast<SCORE_TYPE>(value[i]) * m_scale;
+      }
+      else {
+         const int8_t *value = m_values8 + offset;
+         for (uint32_t i=0; i<count; ++i)
+            o[index[i]] += static_cast<SCORE_TYPE>(value[i]) * m_scale;
+      }
+   }
+
+public:
+   CBinaryScoreTable() : m_keys(0), m_offsets(0), m_buckets(0), m_nMask(0), m_indices(0), m_nIndexBits(32), m_values(0), m_values16(0), m_values8(0), m_scale(1), m_dictionary(0) { }
+   CBinaryScoreTable(const uint64_t *keys, const uint32_t *offsets, const uint64_t &nBuckets, const char *indices, const uint64_t &nIndexBits, const char *values, const uint64_t &nBits, const double &scale, const CFingerprintDictionary *dictionary) : m_keys(keys), m_offsets(offsets), m_buckets(0), m_nMask(nBuckets-1), m_indices(indices), m_nIndexBits(nIndexBits), m_values(0), m_values16(0), m_values8(0), m_scale(static_cast<SCORE_TYPE>(scale)), m_dictionary(dictionary) {
+      ASSERT(nBuckets && (nBuckets&m_nMask)==0, "score_binary.h: the number of buckets is not a power of two");
+      setValues(values, nBits);
+   }
+   // versions 1 and 2
+   CBinaryScoreTable(const CBinaryScoreBucket *buckets, const uint64_t &nBuckets, const char *indices, const char *values, const uint64_t &nBits, const double &scale, const CFingerprintDictionary *dictionary) : m_keys(0), m_offsets(0), m_buckets(buckets), m_nMask(nBuckets-1), m_indices(indices), m_nIndexBits(32), m_values(0), m_values16(0), m_values8(0), m_scale(static_cast<SCORE_TYPE>(scale)), m_dictionary(dictionary) {
+      ASSERT(nBuckets && (nBuckets&m_nMask)==0, "score_binary.h: the number of buckets is not a power of two");
+      setValues(values, nBits);
+   }
+
+public:
+   bool valid() const { return m_keys != 0 || m_buckets != 0; }
+   const CFingerprintDictionary &dictionary() const { assert(m_dictionary); return *m_dictionary; }
+
+   // the list of the scores of the key, returning whether the key was found
+   bool find(const uint64_t &fp, uint32_t &offset, uint32_t &count) const {
+      const uint64_t key = binaryKey(fp);
+      uint64_t index = key & m_nMask;
+      if (m_keys) {
+         while (m_keys[index] != key) {
+            if (m_keys[index] == 0) return false;
+            index = (index+1) & m_nMask;
+         }
+         offset = m_offsets[index];
+         count = m_offsets[index+1] - offset;
+         return true;
+      }
+      while (m_buckets[index].key != key) {
+         if (m_buckets[index].key == 0) return false;
+         index = (index+1) & m_nMask;
+      }
+      offset = m_buckets[index].offset;
+      count = m_buckets[index].count;
+      return true;
+   }
+
+   // returns whether the key was found
+   template<typename CPackedScoreType>
+   bool add(CPackedScoreType &o, const uint64_t &fp) const {
+      uint32_t offset, count;
+      if (!find(fp, offset, count)) return false;
+      if (m_nIndexBits == 8) addList<CPackedScoreType, uint8_t>(o, offset, count);
+      else if (m_nIndexBits == 16) addList<CPackedScoreType, uint16_t>(o, offset, count);
+      else addList<CPackedScoreType, uint32_t>(o, offset, count);
+      return true;
+   }
+};
+
+/*===============================================================
+ *
+ * CBinaryScoreTableBuilder - collects the scores of a table
+ *
+ *==============================================================*/
+
+template<typename SCORE_TYPE>
+class CBinaryScoreTableBuilder {
+
+public:
+   std::vector<uint64_t> keys;
+   std::vector<uint32_t> offsets;
+   std::vector<uint32_t> counts;
+   std::vector<uint32_t> indices;
+   std::vector<SCORE_TYPE> values;
+
+public:
+   void insert(const uint64_t &fp, const std::vector<unsigned> &key_indices, const std::vector<SCORE_TYPE> &key_values) {
+      assert(key_indices.size() == key_values.size());
+      if (key_indices.empty()) return;
+      keys.push_back(binaryKey(fp));
+      offsets.push_back(indices.size());
+      counts.push_back(key_indices.size());
+      indices.insert(indices.end(), key_indices.begin(), key_indices.end());
+      values.insert(values.end(), key_values.begin(), key_values.end());
+   }
+
+   // the table is kept at most half full, and the lists are put
+   // in the order of the buckets of their keys
+   void build(std::vector<uint64_t> &bucket_keys, std::vector<uint32_t> &bucket_offsets, std::vector<uint32_t> &bucket_indices, std::vector<SCORE_TYPE> &bucket_values) const {
+      uint64_t size = 2;
+      while (size < keys.size()*2) size <<= 1;
+      std::vector<unsigned long> owners(size, keys.size());
+      bucket_keys.assign(size, 0);
+      for (unsigned long i=0; i<keys.size(); ++i) {
+         uint64_t index = keys[i] & (size-1);
+         while (bucket_keys[index] != 0) {
+            ASSERT(bucket_keys[index] != keys[i], "score_binary.h: fingerprint collision between feature keys");
+            index = (index+1) & (size-1);
+         }
+         bucket_keys[index] = keys[i];
+         owners[index] = i;
+      }
+      bucket_offsets.assign(size+1, 0);
+      bucket_indices.clear();
+      bucket_values.clear();
+      bucket_indices.reserve(indices.size());
+      bucket_values.reserve(values.size());
+      for (uint64_t index=0; index<size; ++index) {
+         bucket_offsets[index] = bucket_indices.size();
+         const unsigned long i = owners[index];
+         if (i == keys.size()) continue;
+         bucket_indices.insert(bucket_indices.end(), indices.begin()+offsets[i], indices.begin()+offsets[i]+counts[i]);
+         bucket_values.insert(bucket_values.end(), values.begin()+offsets[i], values.begin()+offsets[i]+counts[i]);
+      }
+      bucket_offsets[size] = bucket_indices.size();
+   }
+};
+
+/*===============================================================
+ *
+ * CBinaryModelWriter - writes a binary model
+ *
+ * String lists must be added before score tables.
+ *
+ *==============================================================*/
+
+template<typename SCORE_TYPE>
+class CBinaryModelWriter {
+
+protected:
+   std::ofstream m_file;
+   CBinaryModelHeader m_header;
+   uint64_t m_nValueBits;
+   uint64_t m_nValues;
+   double m_dMaxError;
+
+protected:
+   void write(const void *data, const uint64_t &size) {
+      static const char padding[8] = {0};
+      if (size) m_file.write(static_cast<const char*>(data), size);
+      if (binaryAlign(size) != size) m_file.write(padding, binaryAlign(size)-size);
+   }
+   void write(const uint64_t &n) { write(&n, sizeof(n)); }
+
+   // the scale maps the largest value onto the largest quantized value;
+   // integer scores keep an integer scale so that decoding stays exact
+   // for tables whose values are all within range
+   double quantizationScale(const std::vector<SCORE_TYPE> &values, const double &limit) const {
+      double max = 0;
+      for (unsigned long i=0; i<values.size(); ++i)
+         max = std::max(max, std::fabs(static_cast<double>(values[i])));
+      double scale = max / limit;
+      if (!binaryScoreFloating<SCORE_TYPE>())
+         scale = std::max(1.0, std::ceil(scale));
+      return scale > 0 ? scale : 1;
+   }
+
+   template<typename QUANTIZED_TYPE>
+   void writeQuantized(const std::vector<SCORE_TYPE> &values, const double &scale, const double &limit) {
+      std::vector<QUANTIZED_TYPE> quantized(values.size());
+      for (unsigned long i=0; i<values.size(); ++i) {
+         const double q = std::max(-limit, std::min(limit, std::floor(static_cast<double>(values[i])/scale+0.5)));
+         quantized[i] = static_cast<QUANTIZED_TYPE>(q);
+         m_dMaxError = std::max(m_dMaxError, std::fabs(static_cast<double>(values[i]) - static_cast<double>(static_cast<SCORE_TYPE>(q) * static_cast<SCORE_TYPE>(scale))));
+      }
+      if (!quantized.empty())
+         write(&(*quantized.begin()), quantized.size()*sizeof(QUANTIZED_TYPE));
+   }
+
+   template<typename INDEX_TYPE>
+   void writeNarrowed(const std::vector<uint32_t> &indices) {
+      std::vector<INDEX_TYPE> narrowed(indices.begin(), indices.end());
+      if (!narrowed.empty())
+         write(&(*narrowed.begin()), narrowed.size()*sizeof(INDEX_TYPE));
+   }
+
+public:
+   CBinaryModelWriter(const std::string &sPath, const uint64_t &nValueBits=0) : m_file(sPath.c_str(), std::ios::out|std::ios::binary|std::ios::trunc), m_nValueBits(nValueBits), m_nValues(0), m_dMaxError(0) {
+      ASSERT(m_file.is_open(), "score_binary.h: cannot open " << sPath << " for writing");
+      ASSERT(binaryValueBitsValid(m_nValueBits), "score_binary.h: scores can only be quantized to 16 or 8 bits");
+      memset(&m_header, 0, sizeof(m_header));
+      memcpy(m_header.magic, BINARY_MODEL_MAGIC, sizeof(BINARY_MODEL_MAGIC));
+      m_header.version = BINARY_MODEL_VERSION;
+      m_header.endian = BINARY_MODEL_ENDIAN;
+      m_header.score_size = sizeof(SCORE_TYPE);
+      m_header.score_floating = binaryScoreFloating<SCORE_TYPE>();
+      write(&m_header, sizeof(m_header)); // rewritten on close
+   }
+   virtual ~CBinaryModelWriter() { if (m_file.is_open()) close(); }
+
+public:
+   void setFlags(const uint32_t &flags) { m_header.flags = flags; }
+   // the number of scores written, and the largest error from quantizing them
+   const uint64_t &values() const { return m_nValues; }
+   const double &maxError() const { return m_dMaxError; }
+
+   void addList(const std::vector<std::string> &list) {
+      ASSERT(m_header.tables == 0, "score_binary.h: string lists must be written before score tables");
+      std::vector<uint64_t> offsets(1, 0);
+      std::string characters;
+      for (unsigned long i=0; i<list.size(); ++i) {
+         characters += list[i];
+         offsets.push_back(characters.size());
+      }
+      write(list.size());
+      write(&(*offsets.begin()), offsets.size()*sizeof(uint64_t));
+      write(characters.data(), characters.size());
+      ++m_header.lists;
+   }
+
+   void addTable(const std::string &name, const CBinaryScoreTableBuilder<SCORE_TYPE> &table) {
+      std::vector<uint64_t> keys;
+      std::vector<uint32_t> offsets;
+      std::vector<uint32_t> indices;
+      std::vector<SCORE_TYPE> values;
+      table.build(keys, offsets, indices, values);
+      const double limit = m_nValueBits == 16 ? 32767 : 127;
+      const double scale = m_nValueBits ? quantizationScale(values, limit) : 1;
+      const uint32_t max = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+      const uint64_t nIndexBits = max <= 0xff ? 8 : max <= 0xffff ? 16 : 32;
+      write(name.size());
+      write(name.data(), name.size());
+      write(keys.size());
+      write(indices.size());
+      write(m_nValueBits);
+      write(&scale, sizeof(scale));
+      write(nIndexBits);
+      write(&(*keys.begin()), keys.size()*sizeof(uint64_t));
+      write(&(*offsets.begin()), offsets.size()*sizeof(uint32_t));
+      if (nIndexBits == 8)
+         writeNarrowed<uint8_t>(indices);
+      else if (nIndexBits == 16)
+         writeNarrowed<uint16_t>(indices);
+      else if (!indices.empty())
+         write(&(*indices.begin()), indices.size()*sizeof(uint32_t));
+      if (m_nValueBits == 16)
+         writeQuantized<int16_t>(values, scale, limit);
+      else if (m_nValueBits == 8)
+         writeQuantized<int8_t>(values, scale, limit);
+      else if (!values.empty())
+         write(&(*values.begin()), values.size()*sizeof(SCORE_TYPE));
+      m_nValues += values.size();
+      ++m_header.tables;
+   }
+
+   void close() {
+      m_file.seekp(0);
+      write(&m_header, sizeof(m_header));
+      ASSERT(m_file.good(), "score_binary.h: failed writing the binary model");
+      m_file.close();
+   }
+};
+
+/*===============================================================
+ *
+ * CBinaryModelReader - maps a binary model
+ *
+ * The reader must outlive the tables it returns, which are
+ * returned in the order they were written.
+ *
+ *==============================================================*/
+
+class CBinaryModelReader {
+
+protected:
+   struct CTableSection {
+      std::string name;
+      uint64_t buckets;
+      uint64_t values;
+      uint64_t value_bits;
+      double scale;
+      uint64_t index_bits;
+      const uint64_t *key_data;
+      const uint32_t *offset_data;
+      const CBinaryScoreBucket *bucket_data;   // versions 1 and 2
+      const char *index_data;
+      const char *value_data;
+   };
+
+protected:
+   CMappedFile m_file;
+   CBinaryModelHeader m_header;
+   std::vector< std::vector<std::string> > m_lLists;
+   std::vector<CTableSection> m_lTables;
+   CFingerprintDictionary m_dictionary;
+
+   const char *m_pos;
+   unsigned long m_nNextTable;
+
+protected:
+   const char *read(const uint64_t &size) {
+      const char *retval = m_pos;
+      ASSERT(binaryAlign(size) <= static_cast<uint64_t>(m_file.data()+m_file.size()-m_pos), "score_binary.h: the binary model is truncated");
+      m_pos += binaryAlign(size);
+      return retval;
+   }
+   uint64_t readInteger() { uint64_t n; memcpy(&n, read(sizeof(n)), sizeof(n)); return n; }
+
+public:
+   // whether the file is a binary model
+   static bool detect(const std::string &sPath) {
+      std::ifstream file(sPath.c_str(), std::ios::in|std::ios::binary);
+      char magic[sizeof(BINARY_MODEL_MAGIC)];
+      if (!file.read(magic, sizeof(magic))) return false;
+      return memcmp(magic, BINARY_MODEL_MAGIC, sizeof(magic)) == 0;
+   }
+
+   CBinaryModelReader(const std::string &sPath) : m_file(sPath), m_nNextTable(0) {
+      m_pos = m_file.data();
+      memcpy(&m_header, read(sizeof(m_header)), sizeof(m_header));
+      ASSERT(memcmp(m_header.magic, BINARY_MODEL_MAGIC, sizeof(BINARY_MODEL_MAGIC))==0, "score_binary.h: " << sPath << " is not a binary model");
+      ASSERT(m_header.version>=1 && m_header.version<=BINARY_MODEL_VERSION, "score_binary.h: unsupported binary model version " << m_header.version);
+      ASSERT(m_header.endian==BINARY_MODEL_ENDIAN, "score_binary.h: the binary model was written on a machine of different endianness");
+      for (uint32_t i=0; i<m_header.lists; ++i) {
+         const uint64_t count = readInteger();
+         const uint64_t *offsets = reinterpret_cast<const uint64_t*>(read((count+1)*sizeof(uint64_t)));
+         const char *characters = read(offsets[count]);
+         m_lLists.push_back(std::vector<std::string>());
+         m_lLists.back().reserve(count);
+         for (uint64_t j=0; j<count; ++j)
+            m_lLists.back().push_back(std::string(characters+offsets[j], offsets[j+1]-offsets[j]));
+      }
+      m_lTables.resize(m_header.tables);
+      for (uint32_t i=0; i<m_header.tables; ++i) {
+         CTableSection &table = m_lTables[i];
+         const uint64_t length = readInteger();
+         table.name.assign(read(length), length);
+         table.buckets = readInteger();
+         table.values = readInteger();
+         table.value_bits = 0;
+         table.scale = 1;
+         table.index_bits = 32;
+         table.key_data = 0;
+         table.offset_data = 0;
+         table.bucket_data = 0;
+         if (m_header.version >= 2) {
+            table.value_bits = readInteger();
+            memcpy(&table.scale, read(sizeof(table.scale)), sizeof(table.scale));
+            ASSERT(binaryValueBitsValid(table.value_bits), "score_binary.h: unsupported quantization of score map " << table.name);
+         }
+         if (m_header.version >= 3) {
+            table.index_bits = readInteger();
+            ASSERT(binaryIndexBitsValid(table.index_bits), "score_binary.h: unsupported index width of score map " << table.name);
+            table.key_data = reinterpret_cast<const uint64_t*>(read(table.buckets*sizeof(uint64_t)));
+            table.offset_data = reinterpret_cast<const uint32_t*>(read((table.buckets+1)*sizeof(uint32_t)));
+         }
+         else {
+            table.bucket_data = reinterpret_cast<const CBinaryScoreBucket*>(read(table.buckets*sizeof(CBinaryScoreBucket)));
+         }
+         table.index_data = read(table.values*(table.index_bits/8));
+         table.value_data = read(table.values*(table.value_bits ? table.value_bits/8 : m_header.score_size));
+      }
+   }
+   virtual ~CBinaryModelReader() { }
+
+public:
+   const uint32_t &flags() const { return m_header.flags; }
+   // the number of bits of the quantized scores, 0 if the scores are not quantized
+   uint64_t valueBits() const { return m_lTables.empty() ? 0 : m_lTables.front().value_bits; }
+   unsigned long lists() const { return m_lLists.size(); }
+   const std::vector<std::string> &list(const unsigned long &index) const {
+      ASSERT(index<m_lLists.size(), "score_binary.h: the binary model does not contain string list " << index);
+      return m_lLists[index];
+   }
+   CFingerprintDictionary &dictionary() { return m_dictionary; }
+
+   // the table after the last one returned, which must be the table of name
+   template<typename SCORE_TYPE>
+   CBinaryScoreTable<SCORE_TYPE> nextTable(const std::string &name) {
+      ASSERT(m_header.score_size==sizeof(SCORE_TYPE) && m_header.score_floating==binaryScoreFloating<SCORE_TYPE>(), "score_binary.h: the score type of the binary model does not match");
+      ASSERT(m_nNextTable<m_lTables.size(), "score_binary.h: the binary model does not contain score map " << name);
+      const CTableSection &table = m_lTables[m_nNextTable];
+      ASSERT(table.name == name, "score_binary.h: the binary model has score map " << table.name << " where " << name << " was expected");
+      ++m_nNextTable;
+      if (table.key_data)
+         return CBinaryScoreTable<SCORE_TYPE>(table.key_data, table.offset_data, table.buckets, table.index_data, table.index_bits, table.value_data, table.value_bits, table.scale, &m_dictionary);
+      return CBinaryScoreTable<SCORE_TYPE>(table.bucket_data, table.buckets, table.index_data, table.value_data, table.value_bits, table.scale, &m_dictionary);
+   }
+   // whether every table has been returned
+   bool finished() const { return m_nNextTable == m_lTables.size(); }
+};
+
+#endif
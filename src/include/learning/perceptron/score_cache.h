@@ -0,0 +1,106 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * score_cache.h - the scores of partial contexts.              *
+ *                                                              *
+ * A group of feature templates that only looks at part of a    *
+ * state, such as one stack node or the next words, gives the   *
+ * same packed scores for every state that has the same part.   *
+ * The decoders keep these scores for a sentence by the part,   *
+ * and add them to the scores of each state instead of looking  *
+ * all the templates of the group up again. The scores are      *
+ * only valid while the weights do not change, so the cache is  *
+ * cleared for each sentence.                                   *
+ *                                                              *
+ * The keys need hash() and operator ==.                        *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _SCORE_CACHE_H
+#define _SCORE_CACHE_H
+
+#include "hash_utils.h"
+#include "profile.h"
+
+/*===============================================================
+ *
+ * CScoreCache - packed scores by partial context
+ *
+ * The slots are a power of two in number, are probed linearly
+ * and are kept at most half full. The entries are kept apart
+ * from the slots, and their memory is kept when the cache is
+ * cleared.
+ *
+ *==============================================================*/
+
+template <typename K, typename SCORES>
+class CScoreCache {
+
+protected:
+   std::vector<uint32_t> m_lSlots;   // one more than the index of the entry, zero when empty
+   std::vector<K> m_lKeys;
+   std::vector<SCORES> m_lScores;
+   unsigned long m_nMask;
+   uint32_t m_nSize;
+
+public:
+   CScoreCache() : m_nMask(0), m_nSize(0) { }
+   virtual ~CScoreCache() { }
+
+public:
+   inline unsigned long size() const { return m_nSize; }
+
+   // finds the scores of the key and returns true; otherwise adds
+   // the key with reset scores, which the caller computes, and
+   // returns false
+   bool find(const K &key, SCORES *&scores) {
+      if ((m_nSize+1)*2 > m_lSlots.size())
+         grow();
+      unsigned long slot = slotOf(key);
+      while (m_lSlots[slot]) {
+         if (m_lKeys[m_lSlots[slot]-1] == key) {
+            scores = &m_lScores[m_lSlots[slot]-1];
+            PROFILE_REUSE(true);
+            return true;
+         }
+         slot = (slot+1) & m_nMask;
+      }
+      if (m_nSize == m_lKeys.size()) {
+         m_lKeys.push_back(key);
+         m_lScores.push_back(SCORES());
+      }
+      else {
+         m_lKeys[m_nSize] = key;
+      }
+      m_lScores[m_nSize].reset();
+      scores = &m_lScores[m_nSize];
+      m_lSlots[slot] = ++m_nSize;
+      PROFILE_REUSE(false);
+      return false;
+   }
+
+   void clear() {
+      if (m_nSize == 0) return;
+      std::fill(m_lSlots.begin(), m_lSlots.end(), 0);
+      m_nSize = 0;
+   }
+
+protected:
+   inline unsigned long slotOf(const K &key) const {
+      return ((static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ULL) >> 32) & m_nMask;
+   }
+
+   void grow() {
+      const unsigned long size = m_lSlots.empty() ? 256 : m_lSlots.size()*2;
+      m_lSlots.assign(size, 0);
+      m_nMask = size-1;
+      for (uint32_t i=0; i<m_nSize; ++i) {
+         unsigned long slot = slotOf(m_lKeys[i]);
+         while (m_lSlots[slot])
+            slot = (slot+1) & m_nMask;
+         m_lSlots[slot] = i+1;
+      }
+   }
+};
+
+#endif
@@ -144,6 +144,19 @@ public:
    bool element(const unsigned &index) const {
       return scores.element(index);
    }
+   void sparse(std::vector<unsigned> &indices, std::vector<SCORE_TYPE> &values, const int &which) const {
+      indices.clear();
+      values.clear();
+      typename CLinkedList< unsigned, CScore<SCORE_TYPE> >::const_iterator it;
+      it = scores.begin();
+      while (it != scores.end()) {
+         if (it.second().score(which) != 0) {
+            indices.push_back(it.first());
+            values.push_back(it.second().score(which));
+         }
+         ++it;
+      }
+   }
 
 public:
 
@@ -165,6 +178,20 @@ public:
       }
    }
 
+   // adds the changes of a worker in iterative parameter mixing, see
+   // CPackedScoreMap::mix
+   void mix(const CPackedScore &s, const SCORE_TYPE &workers) {
+      typename CLinkedList<unsigned, CScore<SCORE_TYPE> > ::const_iterator it;
+      it = s.scores.begin();
+      while (it != s.scores.end()) {
+         CScore<SCORE_TYPE> &score = scores[it.first()];
+         assert(it.second().score(CScore<SCORE_TYPE>::eNonAverage) % workers == 0);
+         score[CScore<SCORE_TYPE>::eNonAverage] += it.second().score(CScore<SCORE_TYPE>::eNonAverage) / workers;
+         score[CScore<SCORE_TYPE>::eAverage] += it.second().score(CScore<SCORE_TYPE>::eAverage);
+         ++it;
+      }
+   }
+
    SCORE_TYPE dotProduct(const CPackedScore &s) {
       static const CScore<SCORE_TYPE> sc_zero;
       SCORE_TYPE retval = 0;
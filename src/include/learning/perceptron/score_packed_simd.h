@@ -0,0 +1,109 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * score_packed_simd.h - adding packed scores with SIMD.        *
+ *                                                              *
+ * The packed scores of a feature are added to those of a state *
+ * one whole vector of scores at a time. On x86 the AVX2        *
+ * kernels are chosen when the processor has them, which is     *
+ * found out once at run time, and the SSE2 kernels otherwise;  *
+ * other targets and other score types add one score at a time. *
+ * Loads and stores are unaligned, so that the scores can be    *
+ * anywhere, but rows that are laid out for adding should start *
+ * on PACKED_SCORE_ALIGN bytes.                                 *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _SCORE_PACKED_SIMD_H
+#define _SCORE_PACKED_SIMD_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define PACKED_SCORE_SIMD
+#include <immintrin.h>
+#endif
+
+#define PACKED_SCORE_ALIGN 32
+
+namespace packed_score {
+
+/*---------------------------------------------------------------
+ *
+ * addScalar - the fallback for any score type
+ *
+ *--------------------------------------------------------------*/
+
+template <typename SCORE_TYPE>
+inline void addScalar(SCORE_TYPE *out, const SCORE_TYPE *scores, const unsigned &n) {
+   for (unsigned index=0; index<n; ++index)
+      out[index] += scores[index];
+}
+
+template <typename SCORE_TYPE>
+inline void add(SCORE_TYPE *out, const SCORE_TYPE *scores, const unsigned &n) {
+   addScalar(out, scores, n);
+}
+
+#ifdef PACKED_SCORE_SIMD
+
+inline bool hasAVX2() {
+   static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+   return avx2;
+}
+
+// the kernels for one score type, with the number of scores in a
+// 256 and a 128 bit vector, and the intrinsics that load, add and
+// store them
+#define __PACKED_SCORE_KERNELS(TYPE, N256, V256, LOAD256, ADD256, STORE256, CAST256, N128, V128, LOAD128, ADD128, STORE128, CAST128) \
+   __attribute__((target("avx2"))) \
+   inline void addAVX2(TYPE *out, const TYPE *scores, const unsigned &n) { \
+      unsigned index = 0; \
+      for (; index+N256<=n; index+=N256) { \
+         V256 sum = ADD256(LOAD256((CAST256 const*)(out+index)), LOAD256((CAST256 const*)(scores+index))); \
+         STORE256((CAST256*)(out+index), sum); \
+      } \
+      for (; index<n; ++index) \
+         out[index] += scores[index]; \
+   } \
+   inline void addSSE2(TYPE *out, const TYPE *scores, const unsigned &n) { \
+      unsigned index = 0; \
+      for (; index+N128<=n; index+=N128) { \
+         V128 sum = ADD128(LOAD128((CAST128 const*)(out+index)), LOAD128((CAST128 const*)(scores+index))); \
+         STORE128((CAST128*)(out+index), sum); \
+      } \
+      for (; index<n; ++index) \
+         out[index] += scores[index]; \
+   } \
+   inline void add(TYPE *out, const TYPE *scores, const unsigned &n) { \
+      if (hasAVX2()) addAVX2(out, scores, n); \
+      else addSSE2(out, scores, n); \
+   }
+
+__PACKED_SCORE_KERNELS(int32_t, 8, __m256i, _mm256_loadu_si256, _mm256_add_epi32, _mm256_storeu_si256, __m256i,
+                                4, __m128i, _mm_loadu_si128, _mm_add_epi32, _mm_storeu_si128, __m128i)
+__PACKED_SCORE_KERNELS(int64_t, 4, __m256i, _mm256_loadu_si256, _mm256_add_epi64, _mm256_storeu_si256, __m256i,
+                                2, __m128i, _mm_loadu_si128, _mm_add_epi64, _mm_storeu_si128, __m128i)
+__PACKED_SCORE_KERNELS(float,   8, __m256,  _mm256_loadu_ps,    _mm256_add_ps,    _mm256_storeu_ps,    float,
+                                4, __m128,  _mm_loadu_ps,    _mm_add_ps,    _mm_storeu_ps,    float)
+__PACKED_SCORE_KERNELS(double,  4, __m256d, _mm256_loadu_pd,    _mm256_add_pd,    _mm256_storeu_pd,    double,
+                                2, __m128d, _mm_loadu_pd,    _mm_add_pd,    _mm_storeu_pd,    double)
+
+#undef __PACKED_SCORE_KERNELS
+
+#endif
+
+/*---------------------------------------------------------------
+ *
+ * stride - the number of scores from one row to the next, so
+ *          that each row starts on PACKED_SCORE_ALIGN bytes
+ *
+ *--------------------------------------------------------------*/
+
+template <typename SCORE_TYPE>
+inline unsigned stride(const unsigned &n) {
+   const unsigned align = PACKED_SCORE_ALIGN/sizeof(SCORE_TYPE) ? PACKED_SCORE_ALIGN/sizeof(SCORE_TYPE) : 1;
+   return (n+align-1)/align*align;
+}
+
+}
+
+#endif
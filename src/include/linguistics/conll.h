@@ -14,6 +14,7 @@
 #include "dependency.h"
 #include "dependencylabel.h"
 #include "generictag.h"
+#include "fingerprint.h"
 
 /*==============================================================
  *
@@ -138,6 +139,111 @@ inline std::ostream & operator << (std::ostream &os, const CCoNLLOutputNode &nod
    return os ;
 }
 
+/*==============================================================
+ *
+ * CCoNLLFields - the tab separated fields of a line, which are
+ *                read in place
+ *
+ *==============================================================*/
+
+class CCoNLLFields {
+
+protected:
+   const char *m_pNext;
+   const char *m_pEnd;
+
+public:
+   CCoNLLFields(const char *begin, const char *end) : m_pNext(begin), m_pEnd(end) { }
+
+public:
+   bool next(const char *&begin, const char *&end) {
+      if (m_pNext >= m_pEnd)
+         return false;
+      begin = m_pNext;
+      end = static_cast<const char*>(memchr(begin, '\t', m_pEnd-begin));
+      if (end == 0)
+         end = m_pEnd;
+      m_pNext = end+1;
+      return begin != end;
+   }
+
+   void read(std::string &field, const char *name) {
+      const char *begin, *end;
+      ASSERT(next(begin, end), "Not well formatted CoNLL data (" << name << " not found)");
+      field.assign(begin, end);
+   }
+
+   void read(int &field, const char *name) {
+      const char *begin, *end;
+      ASSERT(next(begin, end), "Not well formatted CoNLL data (" << name << " not found)");
+      parse(begin, end, field);
+   }
+
+   // as read, but a head given as _ is no head
+   void readHead(int &field, const char *name) {
+      const char *begin, *end;
+      ASSERT(next(begin, end), "Not well formatted CoNLL data (" << name << " not found)");
+      if (end-begin == 1 && *begin == '_')
+         field = DEPENDENCY_LINK_NO_HEAD;
+      else
+         parse(begin, end, field);
+   }
+
+protected:
+   static void parse(const char *begin, const char *end, int &field) {
+      while (begin != end && (*begin == ' ' || *begin == '\r' || *begin == '\n'))
+         ++begin;
+      const bool negative = begin != end && *begin == '-';
+      if (begin != end && (*begin == '-' || *begin == '+'))
+         ++begin;
+      field = 0;
+      for (; begin != end && *begin >= '0' && *begin <= '9'; ++begin)
+         field = field*10 + (*begin-'0');
+      if (negative)
+         field = -field;
+   }
+};
+
+inline void readCoNLLNode(CCoNLLFields &fields, CCoNLLInputNode &node) {
+   fields.read(node.id, "id");
+   fields.read(node.word, "word");
+   fields.read(node.lemma, "lemma");
+   fields.read(node.ctag, "cpos");
+   fields.read(node.tag, "pos");
+   fields.read(node.feats, "features");
+}
+
+inline void readCoNLLNode(CCoNLLFields &fields, CCoNLLOutputNode &node) {
+   readCoNLLNode(fields, static_cast<CCoNLLInputNode&>(node));
+   fields.read(node.head, "head");
+   fields.read(node.label, "label");
+   fields.readHead(node.phead, "phead");
+   fields.read(node.plabel, "plabel");
+}
+
+// reads the nodes of a sentence, a line each until an empty line, and
+// splits the lines in place
+template<typename CCoNLLSentence>
+inline std::istream & readCoNLLSentence(std::istream &is, CCoNLLSentence &sent) {
+   sent.clear();
+   std::string line;
+   while (getline(is, line)) {
+      const char *begin = line.data();
+      const char *end = begin + line.size();
+      while (end != begin && (*(end-1)==' ' || *(end-1)=='\n' || *(end-1)=='\r' || *(end-1)=='\t'))
+         --end;
+      const char *p = begin;
+      while (p != end && (*p==' ' || *p=='\n' || *p=='\r' || *p=='\t'))
+         ++p;
+      if (p == end)
+         break;
+      sent.push_back(typename CCoNLLSentence::value_type());
+      CCoNLLFields fields(begin, end);
+      readCoNLLNode(fields, sent.back());
+   }
+   return is ;
+}
+
 /*==============================================================
  *
  * CCoNLLInput
@@ -171,19 +277,7 @@ public:
 };
 
 inline std::istream & operator >> (std::istream &is, CCoNLLInput &sent) {
-   sent.clear();
-   std::string line;
-   getline(is, line);
-
-   while(is && !lstrip(line).empty())
-   {
-      CCoNLLInputNode node;
-      std::istringstream iss(rstrip(line));
-      iss >> node ;
-      sent.push_back( node );
-      getline(is, line);
-   }
-   return is ;
+   return readCoNLLSentence(is, sent);
 }
 
 inline std::ostream & operator << (std::ostream &os, const CCoNLLInput &sent) {
@@ -328,19 +422,7 @@ public:
 };
 
 inline std::istream & operator >> (std::istream &is, CCoNLLOutput &sent) {
-   sent.clear();
-   std::string line;
-   getline(is, line);
-
-   while(is && !lstrip(line).empty())
-   {
-      CCoNLLOutputNode node;
-      std::istringstream iss(rstrip(line));
-      iss >> node ;
-      sent.push_back( node );
-      getline(is, line);
-   }
-   return is ;
+   return readCoNLLSentence(is, sent);
 }
 
 inline std::ostream & operator << (std::ostream &os, const CCoNLLOutput &sent) {
@@ -384,4 +466,8 @@ public:
 
 void readCoNLLFeats(std::vector<CCoNLLFeats> &output, const std::string &input);
 
+// generic tags are interned per process, so fingerprint them by string
+inline uint64_t fingerprint(const CCoNLLCPOS &c, const CFingerprintDictionary &dictionary) { return fingerprint(c.str(), dictionary); }
+inline uint64_t fingerprint(const CCoNLLFeats &f, const CFingerprintDictionary &dictionary) { return fingerprint(f.str(), dictionary); }
+
 #endif
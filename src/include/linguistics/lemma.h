@@ -11,6 +11,7 @@
 #define _LEMMA_H
 
 #include "tokenizer.h"
+#include "fingerprint.h"
 
 /*===============================================================
  *
@@ -77,6 +78,11 @@ inline std::istream & operator >> (std::istream &is, CLemma &w) {
    return is ;
 }
 
+// lemmas are interned per process, so fingerprint them by string
+inline uint64_t fingerprint(const CLemma &w, const CFingerprintDictionary &dictionary) {
+   return fingerprint(w.str(), dictionary);
+}
+
 inline std::ostream & operator << (std::ostream &os, const CLemma &w) {
    os << '[' << w.str() << ']' ;
    return os ;
@@ -72,6 +72,13 @@ public:
 
 //===============================================================
 
+template <typename CTag, char sTagSep>
+inline uint64_t fingerprint(const CTaggedWord<CTag, sTagSep> &tw, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(fingerprint(tw.word, dictionary), fingerprint(tw.tag, dictionary));
+}
+
+//===============================================================
+
 template <typename CTag, char sTagSep>
 std::istream & operator >> (std::istream &is, CTaggedWord<CTag, sTagSep> &tw) {
    std::string s;
@@ -12,6 +12,8 @@
 #ifndef _TAGSET_H
 #define _TAGSET_H
 
+#include "fingerprint.h"
+
 /*===============================================================
  *
  * definitions 
@@ -177,6 +179,16 @@ public:
 public:
 //   const unsigned long long &code() const { return m_code; }
    unsigned long long hash() const { return static_cast<unsigned long long>(*m_code); }
+   // unlike hash, the fingerprint covers every tag in the set
+   uint64_t fingerprint() const {
+      uint64_t retval = 0;
+      for (unsigned long i=0; i<sizeof(m_code); i+=sizeof(uint64_t)) {
+         uint64_t block = 0;
+         memcpy(&block, m_code+i, std::min(sizeof(uint64_t), sizeof(m_code)-i));
+         retval = combineFingerprint(retval, block);
+      }
+      return retval;
+   }
 
 public:
    bool operator == (const CSetOfTags &s) const { return memcmp(m_code, s.m_code, sizeof(m_code))==0; }
@@ -184,6 +196,11 @@ public:
 
 //==============================================================================
 
+template<typename CTag>
+inline uint64_t fingerprint(const CSetOfTags<CTag> &c, const CFingerprintDictionary &) { return c.fingerprint(); }
+
+//==============================================================================
+
 template<typename CTag>
 inline std::istream & operator >> (std::istream &is, CSetOfTags<CTag> &c) {
 
@@ -22,6 +22,7 @@
 //#include "hash.h"
 #include "tokenizer.h"
 #include "bigram.h"
+#include "fingerprint.h"
 
 /*===============================================================
  *
@@ -82,6 +83,10 @@ public:
    bool empty() { return m_nHash==EMPTY; }
    bool unknown() { return m_nHash==UNKNOWN; }
    void clear() { m_nHash=EMPTY; }
+   // the codes of the known words are below this
+   unsigned long dictionarySize() const { return getTokenizer().count(); }
+   // stop adding words to the dictionary, so that unknown words are UNKNOWN
+   void freezeDictionary() const { getTokenizer().freeze(UNKNOWN); }
 }; 
 
 //===============================================================
@@ -90,5 +95,8 @@ public:
 
 inline unsigned long hash(const CWord &w) {return w.hash();}
 
+// words are identified by their id in the model dictionary
+inline uint64_t fingerprint(const CWord &w, const CFingerprintDictionary &dictionary) {return mixFingerprint(dictionary.word(w.code()));}
+
 #endif
 
@@ -0,0 +1,96 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * word_trie.h - the dictionary words of a sentence span.       *
+ *                                                              *
+ * The words of the tokenized dictionary are kept in a byte     *
+ * trie, so that the word of a span of characters is found by   *
+ * walking the trie from the start of the span, without        *
+ * building the string of the span. The walk from each start   *
+ * is kept, so that a longer span from the same start goes on   *
+ * from where the shorter one stopped, and spans that no word  *
+ * starts with are UNKNOWN at once.                             *
+ *                                                              *
+ * The dictionary is append only, so the trie adds the words   *
+ * that are new since it was last looked at, and the walks     *
+ * are started again when it does.                              *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _WORD_TRIE_H
+#define _WORD_TRIE_H
+
+#include "trie.h"
+#include "word_tokenized.h"
+
+/*===============================================================
+ *
+ * CWordTrie - the trie of the dictionary words
+ *
+ *==============================================================*/
+
+class CWordTrie : public CTrie {
+
+protected:
+   unsigned long m_nWords;             // the words in the trie are below this code
+
+public:
+   CWordTrie() : CTrie(CWord::UNKNOWN), m_nWords(CWord::EMPTY) { }
+   virtual ~CWordTrie() { }
+
+public:
+   // add the words added to the dictionary since the last update,
+   // returning whether there were any
+   bool update() {
+      const unsigned long nWords = CWord().dictionarySize();
+      if (m_nWords == nWords)
+         return false;
+      for (; m_nWords<nWords; ++m_nWords)
+         insert(CWord(m_nWords).str(), m_nWords);
+      return true;
+   }
+};
+
+/*===============================================================
+ *
+ * CWordSpans - the words of the spans of a sentence
+ *
+ *==============================================================*/
+
+class CWordSpans {
+
+protected:
+   CWordTrie m_Trie;
+   std::vector<unsigned> m_lNode;         // the node of the walk from each start
+   std::vector<int> m_lEnd;               // the last character read by the walk
+   std::vector<unsigned long> m_lStamp;   // the walk is current if this is m_nStamp
+   unsigned long m_nStamp;
+
+public:
+   CWordSpans(const unsigned long &nMaxSentenceSize) : m_lNode(nMaxSentenceSize), m_lEnd(nMaxSentenceSize), m_lStamp(nMaxSentenceSize, 0), m_nStamp(1) { }
+   virtual ~CWordSpans() { }
+
+public:
+   // the code of the characters from start to end inclusive,
+   // UNKNOWN if they are not a dictionary word
+   template<typename CSentence>
+   unsigned long find(const int &start, const int &end, const CSentence *sentence) {
+      if (m_Trie.update())
+         ++m_nStamp;
+      unsigned &node = m_lNode[start];
+      int &walked = m_lEnd[start];
+      if (m_lStamp[start] != m_nStamp || end < walked) {
+         m_lStamp[start] = m_nStamp;
+         node = CTrie::ROOT;
+         walked = start-1;
+      }
+      while (walked < end && node != CTrie::NONE)
+         node = m_Trie.child(node, sentence->at(++walked));
+      return walked < end ? static_cast<unsigned long>(CWord::UNKNOWN) : m_Trie.value(node);
+   }
+
+   // start the walks again for a new sentence
+   void clear() { ++m_nStamp; }
+};
+
+#endif
@@ -11,6 +11,7 @@
 #define _LINKED_LIST_H
 
 #include "pool.h"
+#include "thread.h"
 
 /*===============================================================
  *
@@ -108,11 +109,13 @@ protected:
 public:
    CLinkedList() : m_buckets(0) { 
       getPool(); // ensure that the pool is constructed.
+      getPoolMutex();
    }
       
    CLinkedList(const CLinkedList& o) { 
       ASSERT(o.m_buckets==0, "CLinkedList does not support copy constructor unless copying from an empty one.");
       getPool(); // ensure that the pool is constructed.
+      getPoolMutex();
       clear(); 
    }
    virtual ~CLinkedList() { 
@@ -122,13 +125,15 @@ public:
 protected:
    static CMemoryPool<CEntry> &getPool() { static CMemoryPool<CEntry> pool(POOL_BLOCK_SIZE); return pool; }
    static CEntry* &getFreeMemory() { static CEntry* c_free = 0; return c_free; }
+   // the pool is shared by the lists in all threads
+   static CMutex &getPoolMutex() { static CMutex mutex; return mutex; }
 
 public:
    CEntry *allocate() {
-      static CEntry *retval;
+      CScopedLock lock(getPoolMutex());
       CEntry * &c_free = getFreeMemory();
       if (c_free) {
-         retval = c_free;
+         CEntry *retval = c_free;
          c_free = c_free->m_next;
          retval->m_next = 0;
          return retval;
@@ -217,6 +222,7 @@ public:
          tail = tail->m_next;
       }
       tail->m_value = empty;
+      CScopedLock lock(getPoolMutex());
       CEntry* &c_free = getFreeMemory();
       tail->m_next = c_free;
       c_free = m_buckets;
@@ -0,0 +1,70 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * mmap_file.h - read only memory mapped files                  *
+ *                                                              *
+ * The mapping is shared, so that processes mapping the same    *
+ * file use the same physical pages.                            *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _MMAP_FILE_H
+#define _MMAP_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/*===============================================================
+ *
+ * CMappedFile - a read only memory mapped file
+ *
+ *==============================================================*/
+
+class CMappedFile {
+
+protected:
+   const char *m_data;
+   unsigned long m_nSize;
+
+public:
+   CMappedFile() : m_data(0), m_nSize(0) { }
+   CMappedFile(const std::string &sPath) : m_data(0), m_nSize(0) { open(sPath); }
+   CMappedFile(const CMappedFile &file) { THROW("CMappedFile does not support copy constructor!"); }
+   virtual ~CMappedFile() { close(); }
+
+public:
+   void open(const std::string &sPath) {
+      ASSERT(m_data==0, "mmap_file.h: the file is already open");
+      int fd = ::open(sPath.c_str(), O_RDONLY);
+      ASSERT(fd>=0, "mmap_file.h: cannot open " << sPath);
+      struct stat info;
+      if (fstat(fd, &info) != 0) {
+         ::close(fd);
+         THROW("mmap_file.h: cannot stat " << sPath);
+      }
+      m_nSize = info.st_size;
+      if (m_nSize == 0) {
+         ::close(fd);
+         THROW("mmap_file.h: " << sPath << " is empty");
+      }
+      void *data = mmap(0, m_nSize, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd); // the mapping keeps its own reference
+      ASSERT(data!=MAP_FAILED, "mmap_file.h: cannot map " << sPath);
+      m_data = static_cast<const char*>(data);
+   }
+   void close() {
+      if (m_data)
+         munmap(const_cast<char*>(m_data), m_nSize);
+      m_data = 0;
+      m_nSize = 0;
+   }
+
+public:
+   bool is_open() const { return m_data != 0; }
+   const char *data() const { return m_data; }
+   const unsigned long &size() const { return m_nSize; }
+};
+
+#endif
@@ -0,0 +1,218 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * pipeline.h - an order preserving multi-threaded pipeline.    *
+ *                                                              *
+ * The reader runs in the calling thread and fills a bounded    *
+ * window of slots; a pool of workers processes the slots in    *
+ * any order, and a writer thread outputs them in input order.  *
+ * Since no more than the window of sentences is in memory at   *
+ * a time, memory stays flat however large the input is.        *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _PIPELINE_H
+#define _PIPELINE_H
+
+#include "thread.h"
+
+/*===============================================================
+ *
+ * CPipeline - reader -> workers -> writer
+ *
+ *==============================================================*/
+
+template<typename CInput, typename COutput>
+class CPipeline {
+
+public:
+   // the stages of the pipeline, implemented by the caller
+   class CReader {
+   public:
+      virtual ~CReader() { }
+      // returns false at the end of the input
+      virtual bool read(CInput &input) = 0;
+   };
+   class CWorker {
+   public:
+      virtual ~CWorker() { }
+      virtual void process(CInput &input, COutput &output) = 0;
+   };
+   class CWriter {
+   public:
+      virtual ~CWriter() { }
+      virtual void write(const COutput &output) = 0;
+   };
+
+protected:
+   struct CSlot {
+      CInput input;
+      COutput output;
+      bool done;
+   };
+
+   class CWorkerThread : public CThread {
+   protected:
+      CPipeline *m_pipeline;
+      CWorker *m_worker;
+   public:
+      CWorkerThread(CPipeline *pipeline, CWorker *worker) : m_pipeline(pipeline), m_worker(worker) { }
+      void run() { m_pipeline->work(m_worker); }
+   };
+
+   class CWriterThread : public CThread {
+   protected:
+      CPipeline *m_pipeline;
+      CWriter *m_writer;
+   public:
+      CWriterThread(CPipeline *pipeline, CWriter *writer) : m_pipeline(pipeline), m_writer(writer) { }
+      void run() { m_pipeline->output(m_writer); }
+   };
+
+protected:
+   CSlot *m_slots;
+   const unsigned long m_nWindow;
+
+   unsigned long m_nRead;      // the number of items read
+   unsigned long m_nTaken;     // the number of items taken by workers
+   unsigned long m_nWritten;   // the number of items written
+   bool m_bEnd;                // whether the reader has finished
+   bool m_bAbort;              // whether a stage has failed
+   std::string m_sError;
+
+   CMutex m_mutex;
+   CCondition m_readable;      // signalled when an item is read or the input ends
+   CCondition m_available;     // signalled when a slot is written and freed
+   CCondition m_finished;      // signalled when the next item to write is done
+
+public:
+   CPipeline(const unsigned long &nWindow) : m_nWindow(nWindow) {
+      ASSERT(m_nWindow>0, "The pipeline window must not be empty");
+      m_slots = new CSlot[m_nWindow];
+   }
+   CPipeline(const CPipeline &pipeline) : m_nWindow(0) { THROW("CPipeline does not support copy constructor!"); }
+   virtual ~CPipeline() {
+      delete [] m_slots;
+   }
+
+public:
+   // run the pipeline to the end of the input, with one thread for each worker
+   void run(CReader &reader, std::vector<CWorker*> &workers, CWriter &writer) {
+      ASSERT(!workers.empty(), "The pipeline needs at least one worker");
+      m_nRead = m_nTaken = m_nWritten = 0;
+      m_bEnd = m_bAbort = false;
+      m_sError.clear();
+
+      std::vector<CWorkerThread*> threads;
+      for (unsigned i=0; i<workers.size(); ++i) {
+         threads.push_back(new CWorkerThread(this, workers[i]));
+         threads.back()->start();
+      }
+      CWriterThread writer_thread(this, &writer);
+      writer_thread.start();
+
+      input(&reader);
+
+      for (unsigned i=0; i<threads.size(); ++i) {
+         threads[i]->join();
+         delete threads[i];
+      }
+      writer_thread.join();
+      if (m_bAbort)
+         THROW(m_sError);
+   }
+
+protected:
+   void abort(const std::string &sError) {
+      CScopedLock lock(m_mutex);
+      if (!m_bAbort) {
+         m_bAbort = true;
+         m_sError = sError;
+      }
+      m_readable.broadcast();
+      m_available.broadcast();
+      m_finished.broadcast();
+   }
+
+   void input(CReader *reader) {
+      try {
+         while (true) {
+            unsigned long index;
+            {
+               CScopedLock lock(m_mutex);
+               while (m_nRead-m_nWritten == m_nWindow && !m_bAbort)
+                  m_available.wait(m_mutex);
+               if (m_bAbort)
+                  return;
+               index = m_nRead;
+            }
+            // the slot is not visible to the other stages until m_nRead moves
+            CSlot &slot = m_slots[index%m_nWindow];
+            slot.done = false;
+            const bool bRead = reader->read(slot.input);
+            CScopedLock lock(m_mutex);
+            if (!bRead) {
+               m_bEnd = true;
+               m_readable.broadcast();
+               m_finished.broadcast();
+               return;
+            }
+            ++m_nRead;
+            m_readable.signal();
+         }
+      }
+      catch (const std::string &e) {
+         abort(e);
+      }
+   }
+
+   void work(CWorker *worker) {
+      try {
+         while (true) {
+            unsigned long index;
+            {
+               CScopedLock lock(m_mutex);
+               while (m_nTaken == m_nRead && !m_bEnd && !m_bAbort)
+                  m_readable.wait(m_mutex);
+               if (m_bAbort || m_nTaken == m_nRead)
+                  return;
+               index = m_nTaken++;
+            }
+            CSlot &slot = m_slots[index%m_nWindow];
+            worker->process(slot.input, slot.output);
+            CScopedLock lock(m_mutex);
+            slot.done = true;
+            if (index == m_nWritten)
+               m_finished.signal();
+         }
+      }
+      catch (const std::string &e) {
+         abort(e);
+      }
+   }
+
+   void output(CWriter *writer) {
+      try {
+         while (true) {
+            unsigned long index;
+            {
+               CScopedLock lock(m_mutex);
+               while (!m_bAbort && !(m_nWritten < m_nRead && m_slots[m_nWritten%m_nWindow].done) && !(m_bEnd && m_nWritten == m_nRead))
+                  m_finished.wait(m_mutex);
+               if (m_bAbort || m_nWritten == m_nRead)
+                  return;
+               index = m_nWritten;
+            }
+            writer->write(m_slots[index%m_nWindow].output);
+            CScopedLock lock(m_mutex);
+            ++m_nWritten;
+            m_available.signal();
+         }
+      }
+      catch (const std::string &e) {
+         abort(e);
+      }
+   }
+};
+
+#endif
@@ -0,0 +1,173 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * profile.h - the profiling of the decoders.                   *
+ *                                                              *
+ * Compiled with -DPROFILE, the decoders time their phases with *
+ * the monotonic clock and count their feature lookups and how  *
+ * often they reuse cached partial scores, and a summary for    *
+ * the run is printed to stderr at exit. Otherwise the macros   *
+ * are empty, and the decoders are not changed.                 *
+ *                                                              *
+ * Each thread keeps its own counters, which are only added up  *
+ * at exit, so that the decoders do not share cache lines.      *
+ * The phases nest, and the time of a phase includes the time   *
+ * of the phases inside it.                                     *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#ifdef PROFILE
+
+#include <time.h>
+#include "thread.h"
+
+namespace profile {
+
+/*===============================================================
+ *
+ * the phases and the counters
+ *
+ *==============================================================*/
+
+enum EPhase { kDecode, kScore, kBeam, kMove, kOutput, PHASES };
+
+enum ECounter { kSentences, kLookups, kHits, kPartials, kReuses, COUNTERS };
+
+static const char * const PHASE_NAMES[PHASES] = { "decode", "score", "beam", "move", "output" };
+
+struct CCounters {
+   uint64_t time[PHASES];
+   uint64_t calls[PHASES];
+   uint64_t count[COUNTERS];
+};
+
+inline uint64_t now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return static_cast<uint64_t>(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+}
+
+/*===============================================================
+ *
+ * CProfile - the counters of all threads
+ *
+ *==============================================================*/
+
+class CProfile {
+
+protected:
+   CMutex m_mutex;
+   std::vector<CCounters*> m_counters;
+
+public:
+   virtual ~CProfile() {
+      report(std::cerr);
+      for (unsigned long i=0; i<m_counters.size(); ++i)
+         delete m_counters[i];
+   }
+
+public:
+   static CProfile &instance() {
+      static CProfile profile;
+      return profile;
+   }
+
+   // the counters of a new thread, which are kept after it exits
+   CCounters *add() {
+      CCounters *counters = new CCounters;
+      memset(counters, 0, sizeof(CCounters));
+      CScopedLock lock(m_mutex);
+      m_counters.push_back(counters);
+      return counters;
+   }
+
+   void report(std::ostream &os) {
+      CCounters total;
+      memset(&total, 0, sizeof(CCounters));
+      {
+         CScopedLock lock(m_mutex);
+         for (unsigned long i=0; i<m_counters.size(); ++i) {
+            for (unsigned j=0; j<PHASES; ++j) {
+               total.time[j] += m_counters[i]->time[j];
+               total.calls[j] += m_counters[i]->calls[j];
+            }
+            for (unsigned j=0; j<COUNTERS; ++j)
+               total.count[j] += m_counters[i]->count[j];
+         }
+      }
+      const uint64_t &sentences = total.count[kSentences];
+      if (sentences == 0) return;
+      os << "Profile of " << sentences << " sentences in " << m_counters.size() << " threads" << std::endl;
+      os << "phase\tcalls/sentence\tns/sentence\tns/call" << std::endl;
+      for (unsigned j=0; j<PHASES; ++j) {
+         if (total.calls[j] == 0) continue;
+         os << PHASE_NAMES[j] << '\t' << double(total.calls[j])/sentences << '\t' << total.time[j]/sentences << '\t' << total.time[j]/total.calls[j] << std::endl;
+      }
+      if (total.count[kLookups]) {
+         os << "feature lookups/sentence " << double(total.count[kLookups])/sentences
+            << ", hit rate " << 100.0*total.count[kHits]/total.count[kLookups] << '%' << std::endl;
+      }
+      if (total.count[kPartials]) {
+         os << "partial scores/sentence " << double(total.count[kPartials])/sentences
+            << ", reused " << 100.0*total.count[kReuses]/total.count[kPartials] << '%' << std::endl;
+      }
+      os.flush();
+   }
+};
+
+// the counters of this thread
+inline CCounters &counters() {
+   static __thread CCounters *counters = 0;
+   if (counters == 0)
+      counters = CProfile::instance().add();
+   return *counters;
+}
+
+/*===============================================================
+ *
+ * CTimer - times a phase until the end of the scope
+ *
+ *==============================================================*/
+
+class CTimer {
+
+protected:
+   const EPhase m_phase;
+   uint64_t m_start;
+
+public:
+   CTimer(const EPhase &phase) : m_phase(phase), m_start(now()) { }
+   ~CTimer() { stop(); }
+
+public:
+   void stop() {
+      if (m_start == 0) return;
+      CCounters &c = counters();
+      c.time[m_phase] += now() - m_start;
+      ++c.calls[m_phase];
+      m_start = 0;
+   }
+};
+
+} // namespace profile
+
+#define PROFILE_PHASE(x) profile::CTimer __profile_##x(profile::x)
+#define PROFILE_STOP(x) __profile_##x.stop()
+#define PROFILE_COUNT(x, n) { profile::counters().count[profile::x] += (n); }
+#define PROFILE_LOOKUP(hit) { profile::CCounters &__profile_c = profile::counters(); ++__profile_c.count[profile::kLookups]; if (hit) ++__profile_c.count[profile::kHits]; }
+#define PROFILE_REUSE(hit) { profile::CCounters &__profile_c = profile::counters(); ++__profile_c.count[profile::kPartials]; if (hit) ++__profile_c.count[profile::kReuses]; }
+
+#else
+
+#define PROFILE_PHASE(x)
+#define PROFILE_STOP(x)
+#define PROFILE_COUNT(x, n)
+#define PROFILE_LOOKUP(hit)
+#define PROFILE_REUSE(hit)
+
+#endif
+
+#endif
@@ -16,6 +16,7 @@
 
 #include "definitions.h"
 #include "file_utils.h"
+#include "mmap_file.h"
 #include "linguistics/sentence_string.h"
 
 /*===============================================================
@@ -23,7 +24,12 @@
  * CSentenceReader - read sentence
  *
  * Specify a file name in the constructor. If no file name is specified, 
- * the reader will read from the standard input.
+ * the reader will read from the standard input. A reader can also be
+ * given a stream, which it reads without taking over.
+ *
+ * Files are memory mapped and tokenised in place. Streams are read a
+ * line at a time into a buffer, which is tokenised in place likewise,
+ * so that lines can still be read one by one from a pipe.
  *
  * readRawSentence:
  *  - The input file should contain tokenised sentences each in a line, 
@@ -35,24 +41,40 @@
 class CSentenceReader {
    protected:
       std::istream *m_iStream;
+      bool m_bOwnStream;
+      CMappedFile m_file;              // read in place when it is open
+      const char *m_pCursor;           // the next char of the file
+      std::string m_sLine;             // the line read from the stream
+      bool m_bEndOfLine;               // whether the last line ended with a newline
       int m_nLine;
    public:
       // constructor and destructor method
-      CSentenceReader(const std::string &sFileName="") { 
+      CSentenceReader(const std::string &sFileName="") : m_iStream(0), m_bOwnStream(false), m_pCursor(0), m_bEndOfLine(false), m_nLine(0) { 
          if (sFileName.empty()) 
 	   m_iStream = &std::cin; 
          else {
             if (!FileExists(sFileName)) THROW("File " << sFileName << " not found.");
-            m_iStream=new std::ifstream(sFileName.c_str());
+            // empty files, pipes and other files that cannot be mapped are streamed
+            try {
+               m_file.open(sFileName);
+               m_pCursor = m_file.data();
+            }
+            catch (const std::string &) {
+               m_iStream=new std::ifstream(sFileName.c_str());
+               m_bOwnStream = true;
+            }
          }
-         m_nLine = 0;
       };
+      CSentenceReader(std::istream *iStream) : m_iStream(iStream), m_bOwnStream(false), m_pCursor(0), m_bEndOfLine(false), m_nLine(0) { };
       virtual ~CSentenceReader() {
-         if (m_iStream != &std::cin) {
+         if (m_bOwnStream) {
             ((std::ifstream*)m_iStream)->close(); 
             delete m_iStream;
          }
       };
+   protected:
+      bool readLine(const char *&begin, const char *&end);
+   public:
       bool readRawCharacter(std::string *retval);
       bool readRawSentence(CStringVector *retval, bool bSkipEmptyLines=false, bool bIgnoreSpace=false);
       bool readSegmentedSentence(CStringVector *retval, bool bSkipEmptyLines=false);
@@ -0,0 +1,236 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * stages.h - a pipeline of concurrent stages.                  *
+ *                                                              *
+ * Each stage runs in a thread of its own and passes its items  *
+ * to the next stage through a bounded ring, which has a single *
+ * producer and a single consumer, so the items stay in order   *
+ * and a stage gets no more than a ring ahead of the next one.  *
+ * Unlike pipeline.h, where a pool of workers runs copies of    *
+ * one decoder, every stage owns its model, so decoders that    *
+ * are not reentrant can still run at the same time.            *
+ *                                                              *
+ * Each stage times the work on its items, and the report gives *
+ * the items per second of each stage while it is busy, so the  *
+ * slowest stage, which bounds the throughput, stands out.      *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _STAGES_H
+#define _STAGES_H
+
+#include <time.h>
+#include "thread.h"
+
+/*===============================================================
+ *
+ * CRing - a bounded ring with one producer and one consumer
+ *
+ * The slots are kept and filled in place. The producer fills
+ * back() and then calls push(), and the consumer reads front()
+ * and then calls pop(); the slot is not touched by the other
+ * side in between.
+ *
+ *==============================================================*/
+
+template<typename T>
+class CRing {
+
+protected:
+   std::vector<T> m_slots;
+   unsigned long m_nPushed;
+   unsigned long m_nPopped;
+   bool m_bClosed;             // the producer has finished
+   bool m_bAborted;            // a stage has failed
+
+   CMutex m_mutex;
+   CCondition m_readable;
+   CCondition m_writable;
+
+public:
+   CRing(const unsigned long &nSize) : m_slots(nSize), m_nPushed(0), m_nPopped(0), m_bClosed(false), m_bAborted(false) {
+      ASSERT(nSize>0, "The ring must not be empty");
+   }
+   CRing(const CRing &ring) { THROW("CRing does not support copy constructor!"); }
+   virtual ~CRing() { }
+
+public:
+   // the slot for the next item, 0 if the pipeline is aborted
+   T *back() {
+      CScopedLock lock(m_mutex);
+      while (m_nPushed-m_nPopped == m_slots.size() && !m_bAborted)
+         m_writable.wait(m_mutex);
+      return m_bAborted ? 0 : &m_slots[m_nPushed%m_slots.size()];
+   }
+   void push() {
+      CScopedLock lock(m_mutex);
+      ++m_nPushed;
+      m_readable.signal();
+   }
+   // the next item, 0 at the end or if the pipeline is aborted
+   T *front() {
+      CScopedLock lock(m_mutex);
+      while (m_nPopped == m_nPushed && !m_bClosed && !m_bAborted)
+         m_readable.wait(m_mutex);
+      return (m_bAborted || m_nPopped == m_nPushed) ? 0 : &m_slots[m_nPopped%m_slots.size()];
+   }
+   void pop() {
+      CScopedLock lock(m_mutex);
+      ++m_nPopped;
+      m_writable.signal();
+   }
+   void close() {
+      CScopedLock lock(m_mutex);
+      m_bClosed = true;
+      m_readable.broadcast();
+   }
+   void abort() {
+      CScopedLock lock(m_mutex);
+      m_bAborted = true;
+      m_readable.broadcast();
+      m_writable.broadcast();
+   }
+};
+
+/*===============================================================
+ *
+ * CStageStats - the items and the busy time of a stage
+ *
+ *==============================================================*/
+
+class CStageStats {
+
+protected:
+   std::string m_sName;
+   unsigned long m_nItems;
+   uint64_t m_nBusy;
+   uint64_t m_nStart;
+   std::string m_sError;
+
+public:
+   static uint64_t now() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return static_cast<uint64_t>(ts.tv_sec)*1000000000ULL + ts.tv_nsec;
+   }
+
+public:
+   CStageStats(const std::string &sName) : m_sName(sName), m_nItems(0), m_nBusy(0), m_nStart(0) { }
+   virtual ~CStageStats() { }
+
+public:
+   void startItem() { m_nStart = now(); }
+   void finishItem() { m_nBusy += now()-m_nStart; ++m_nItems; }
+   void fail(const std::string &sError) { m_sError = sError; }
+
+   const std::string &name() const { return m_sName; }
+   const unsigned long &items() const { return m_nItems; }
+   double seconds() const { return m_nBusy/1e9; }
+   const std::string &error() const { return m_sError; }
+};
+
+/*===============================================================
+ *
+ * CStage - a stage that reads one ring and writes the next
+ *
+ *==============================================================*/
+
+template<typename CInput, typename COutput>
+class CStage : public CThread, public CStageStats {
+
+protected:
+   CRing<CInput> &m_input;
+   CRing<COutput> &m_output;
+
+public:
+   CStage(const std::string &sName, CRing<CInput> &input, CRing<COutput> &output) : CStageStats(sName), m_input(input), m_output(output) { }
+   virtual ~CStage() { }
+
+public:
+   virtual void process(CInput &input, COutput &output) = 0;
+
+   void run() {
+      try {
+         CInput *input;
+         COutput *output;
+         while ((input = m_input.front()) != 0) {
+            // a later stage has failed, so stop the earlier ones too
+            if ((output = m_output.back()) == 0) {
+               m_input.abort();
+               return;
+            }
+            startItem();
+            process(*input, *output);
+            finishItem();
+            m_input.pop();
+            m_output.push();
+         }
+         m_output.close();
+      }
+      catch (const std::string &e) {
+         fail(e);
+         m_input.abort();
+         m_output.abort();
+      }
+   }
+};
+
+/*===============================================================
+ *
+ * CSink - the last stage, which reads a ring
+ *
+ *==============================================================*/
+
+template<typename CInput>
+class CSink : public CThread, public CStageStats {
+
+protected:
+   CRing<CInput> &m_input;
+
+public:
+   CSink(const std::string &sName, CRing<CInput> &input) : CStageStats(sName), m_input(input) { }
+   virtual ~CSink() { }
+
+public:
+   virtual void process(CInput &input) = 0;
+
+   void run() {
+      try {
+         CInput *input;
+         while ((input = m_input.front()) != 0) {
+            startItem();
+            process(*input);
+            finishItem();
+            m_input.pop();
+         }
+      }
+      catch (const std::string &e) {
+         fail(e);
+         m_input.abort();
+      }
+   }
+};
+
+/*===============================================================
+ *
+ * finishStages - report the stages, which have all been joined,
+ *                or throw the first error of a stage
+ *
+ *==============================================================*/
+
+inline void finishStages(const std::vector<const CStageStats*> &stages, const double &seconds, std::ostream &os) {
+   for (unsigned long i=0; i<stages.size(); ++i)
+      if (!stages[i]->error().empty())
+         THROW(stages[i]->name() << ": " << stages[i]->error());
+   os << "stage\titems\tbusy s\titems/s busy\tbusy %" << std::endl;
+   for (unsigned long i=0; i<stages.size(); ++i) {
+      const CStageStats &stage = *stages[i];
+      os << stage.name() << '\t' << stage.items() << '\t' << stage.seconds() << '\t'
+         << (stage.seconds() > 0 ? stage.items()/stage.seconds() : 0) << '\t'
+         << (seconds > 0 ? 100.0*stage.seconds()/seconds : 0) << std::endl;
+   }
+   os.flush();
+}
+
+#endif
@@ -0,0 +1,129 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * thread.h - the thread utilities (posix threads).             *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _THREAD_H
+#define _THREAD_H
+
+#include <pthread.h>
+
+/*===============================================================
+ *
+ * atomic loads and stores
+ *
+ * A value stored with atomicStore is seen by atomicLoad in
+ * another thread together with everything written before it,
+ * which is enough to publish data to readers that take no lock.
+ *
+ *==============================================================*/
+
+template<typename T>
+inline T atomicLoad(const T *p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+
+template<typename T>
+inline void atomicStore(T *p, const T &value) { __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+
+/*===============================================================
+ *
+ * CMutex - mutual exclusion lock
+ *
+ *==============================================================*/
+
+class CMutex {
+
+protected:
+   pthread_mutex_t m_mutex;
+
+public:
+   CMutex() { pthread_mutex_init(&m_mutex, 0); }
+   CMutex(const CMutex &mutex) { THROW("CMutex does not support copy constructor!"); }
+   virtual ~CMutex() { pthread_mutex_destroy(&m_mutex); }
+
+public:
+   void lock() { pthread_mutex_lock(&m_mutex); }
+   void unlock() { pthread_mutex_unlock(&m_mutex); }
+   pthread_mutex_t *handle() { return &m_mutex; }
+};
+
+/*===============================================================
+ *
+ * CScopedLock - holds a mutex until the end of the scope
+ *
+ *==============================================================*/
+
+class CScopedLock {
+
+protected:
+   CMutex &m_mutex;
+
+public:
+   CScopedLock(CMutex &mutex) : m_mutex(mutex) { m_mutex.lock(); }
+   CScopedLock(const CScopedLock &lock) : m_mutex(lock.m_mutex) { THROW("CScopedLock does not support copy constructor!"); }
+   virtual ~CScopedLock() { m_mutex.unlock(); }
+};
+
+/*===============================================================
+ *
+ * CCondition - condition variable
+ *
+ *==============================================================*/
+
+class CCondition {
+
+protected:
+   pthread_cond_t m_cond;
+
+public:
+   CCondition() { pthread_cond_init(&m_cond, 0); }
+   CCondition(const CCondition &cond) { THROW("CCondition does not support copy constructor!"); }
+   virtual ~CCondition() { pthread_cond_destroy(&m_cond); }
+
+public:
+   // the mutex must be locked by the caller
+   void wait(CMutex &mutex) { pthread_cond_wait(&m_cond, mutex.handle()); }
+   void signal() { pthread_cond_signal(&m_cond); }
+   void broadcast() { pthread_cond_broadcast(&m_cond); }
+};
+
+/*===============================================================
+ *
+ * CThread - a thread running the run() method
+ *
+ *==============================================================*/
+
+class CThread {
+
+protected:
+   pthread_t m_thread;
+   bool m_bStarted;
+
+protected:
+   static void *entry(void *thread) {
+      static_cast<CThread*>(thread)->run();
+      return 0;
+   }
+
+public:
+   CThread() : m_bStarted(false) { }
+   CThread(const CThread &thread) { THROW("CThread does not support copy constructor!"); }
+   virtual ~CThread() { assert(!m_bStarted); }
+
+public:
+   virtual void run() = 0;
+
+   void start() {
+      ASSERT(!m_bStarted, "The thread has already started");
+      ASSERT(pthread_create(&m_thread, 0, entry, this)==0, "Cannot create thread");
+      m_bStarted = true;
+   }
+   void join() {
+      if (!m_bStarted) return;
+      pthread_join(m_thread, 0);
+      m_bStarted = false;
+   }
+};
+
+#endif
@@ -3,6 +3,20 @@
  *                                                              *
  * tokenizer.h - the tokenizer.                                 *
  *                                                              *
+ * Tokens are shared by decoder threads. Lookups of known keys  *
+ * and keys of tokens take no lock; new keys are added under a  *
+ * mutex and published to the readers with atomic stores.       *
+ *                                                              *
+ * Keys are stored append only in chunks that double in size,   *
+ * so that a key never moves once it is added, and the hash     *
+ * chains only ever grow at their heads. When the table grows   *
+ * it is rebuilt and swapped in, and the old table is kept for  *
+ * the readers still in it until the tokenizer is destroyed.    *
+ *                                                              *
+ * A frozen tokenizer adds no more keys, and looks up unknown   *
+ * keys as a given token instead, so that decoding services do  *
+ * not grow with the words they see.                            *
+ *                                                              *
  * Author: Yue Zhang                                            *
  *                                                              *
  * Computing Laboratory, Oxford. 2007.5                         *
@@ -13,6 +27,7 @@
 #define _TOKENIZER_H
 
 #include "hash.h"
+#include "thread.h"
 
 //static const unsigned TOKENIZER_SIZE = 65537 ;
 
@@ -25,25 +40,115 @@
 template <typename K, unsigned TOKENIZER_SIZE>
 class CTokenizer {
    protected:
-      CHashMap<K, unsigned long> m_mapTokens;
-      std::vector<K> m_vecKeys;
+      enum { CHUNK_BITS = 6, CHUNKS = sizeof(unsigned long)*8-CHUNK_BITS };
+      struct CNode {
+         const K *key;
+         unsigned long token;
+         CNode *next;
+      };
+      struct CTable {
+         std::vector<CNode*> buckets;
+         unsigned long mask;
+      };
+   protected:
+      CTable *m_table;                 // read without locking
+      std::vector<CTable*> m_retired;  // the tables replaced by larger ones
+      std::deque<CNode> m_nodes;       // nodes do not move when new nodes are added
+      K *m_chunks[CHUNKS];             // chunk i holds 2^(CHUNK_BITS+i) keys
       unsigned long m_nWaterMark;
       unsigned long m_nStartingToken;
+      bool m_bFrozen;
+      unsigned long m_nUnknown;        // the token of unknown keys when frozen
+      CMutex m_mutex;                  // held by writers only
+   protected:
+      static uint64_t mix(const K &key) { return static_cast<uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ULL; }
+      static unsigned long bucket(const K &key, const unsigned long &mask) { return (mix(key)>>32) & mask; }
+      // the chunk and the offset of a key
+      static void locate(const unsigned long &index, unsigned long &chunk, unsigned long &offset) {
+         const unsigned long n = index + (1UL<<CHUNK_BITS);
+         const unsigned long bit = sizeof(unsigned long)*8-1-__builtin_clzl(n);
+         chunk = bit-CHUNK_BITS;
+         offset = n-(1UL<<bit);
+      }
+      const CNode *search(const K &key) const {
+         const CTable *table = atomicLoad(&m_table);
+         const CNode *node = atomicLoad(&table->buckets[bucket(key, table->mask)]);
+         while (node) {
+            if (*node->key == key) return node;
+            node = node->next;
+         }
+         return 0;
+      }
+      void link(CTable *table, const K *key, const unsigned long &token) {
+         CNode *&head = table->buckets[bucket(*key, table->mask)];
+         CNode node = { key, token, head };
+         m_nodes.push_back(node);
+         atomicStore(&head, &m_nodes.back());
+      }
+      // rebuilds the table with twice the buckets, the caller holds the mutex
+      void grow() {
+         CTable *table = new CTable;
+         table->buckets.assign(m_table->buckets.size()*2, static_cast<CNode*>(0));
+         table->mask = table->buckets.size()-1;
+         for (unsigned long token=m_nStartingToken; token<m_nWaterMark; ++token)
+            link(table, &key(token), token);
+         m_retired.push_back(m_table);
+         atomicStore(&m_table, table);
+      }
    public:
-      CTokenizer(unsigned nTokenStartsFrom=0) : m_mapTokens(TOKENIZER_SIZE), m_nWaterMark(nTokenStartsFrom), m_nStartingToken(nTokenStartsFrom) {}
-      virtual ~CTokenizer() {}
+      CTokenizer(unsigned nTokenStartsFrom=0) : m_nWaterMark(nTokenStartsFrom), m_nStartingToken(nTokenStartsFrom), m_bFrozen(false), m_nUnknown(0) {
+         m_table = new CTable;
+         unsigned long size = 1;
+         while (size < TOKENIZER_SIZE) size <<= 1;
+         m_table->buckets.assign(size, static_cast<CNode*>(0));
+         m_table->mask = size-1;
+         for (unsigned long i=0; i<CHUNKS; ++i)
+            m_chunks[i] = 0;
+      }
+      CTokenizer(const CTokenizer &tokenizer) { THROW("CTokenizer does not support copy constructor!"); }
+      virtual ~CTokenizer() {
+         delete m_table;
+         for (unsigned long i=0; i<m_retired.size(); ++i)
+            delete m_retired[i];
+         for (unsigned long i=0; i<CHUNKS; ++i)
+            delete [] m_chunks[i];
+      }
       unsigned long lookup(const K &key) {
-         unsigned long retval; 
-         bool bNew = m_mapTokens.findorinsert(key, m_nWaterMark, retval); 
-         if (bNew) { 
-            ++m_nWaterMark; 
-            assert(m_nWaterMark!=0); // there is no overflow on the number of tokens!
-            m_vecKeys.push_back(key);
-         } return retval;
-      }
-      unsigned long find(const K &key, const unsigned long &val) const {return m_mapTokens.find(key, val);}
-      const K &key(const unsigned long &token) const {assert( token < m_vecKeys.size()+m_nStartingToken ); return m_vecKeys[token-m_nStartingToken];}
-      const unsigned long &count() const {return m_nWaterMark;}
+         const CNode *node = search(key);
+         if (node) return node->token;
+         if (atomicLoad(&m_bFrozen)) return m_nUnknown;
+         CScopedLock lock(m_mutex);
+         node = search(key); // another thread may have added the key
+         if (node) return node->token;
+         if (m_bFrozen) return m_nUnknown;
+         const unsigned long token = m_nWaterMark;
+         assert(token+1!=0); // there is no overflow on the number of tokens!
+         unsigned long chunk, offset;
+         locate(token-m_nStartingToken, chunk, offset);
+         if (m_chunks[chunk] == 0)
+            m_chunks[chunk] = new K[1UL<<(CHUNK_BITS+chunk)];
+         m_chunks[chunk][offset] = key;
+         if (token-m_nStartingToken >= m_table->buckets.size())
+            grow();
+         link(m_table, &m_chunks[chunk][offset], token);
+         atomicStore(&m_nWaterMark, token+1);
+         return token;
+      }
+      unsigned long find(const K &key, const unsigned long &val) const {const CNode *node = search(key); return node ? node->token : val;}
+      const K &key(const unsigned long &token) const {
+         assert( token >= m_nStartingToken && token < count() );
+         unsigned long chunk, offset;
+         locate(token-m_nStartingToken, chunk, offset);
+         return m_chunks[chunk][offset];
+      }
+      unsigned long count() const {return atomicLoad(&m_nWaterMark);}
+      // stop adding keys, looking up unknown keys as nUnknown
+      void freeze(const unsigned long &nUnknown) {
+         CScopedLock lock(m_mutex);
+         m_nUnknown = nUnknown;
+         atomicStore(&m_bFrozen, true);
+      }
+      bool frozen() const {return atomicLoad(&m_bFrozen);}
 };
 
 #endif
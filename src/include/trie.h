@@ -0,0 +1,121 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * trie.h - the byte trie.                                      *
+ *                                                              *
+ * Maps strings to values, and is walked a few bytes at a time, *
+ * so that a string that grows by one character at a time is    *
+ * looked up without being built, and the walk stops as soon    *
+ * as no key starts with what has been read.                    *
+ *                                                              *
+ * Nodes are numbered from ROOT, with NONE for the node past a  *
+ * dead end. The edges of all the nodes are kept in one open    *
+ * addressing table, keyed by the parent and the byte, which is *
+ * kept at most half full and probed linearly.                  *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _TRIE_H
+#define _TRIE_H
+
+/*===============================================================
+ *
+ * CTrie - the byte trie
+ *
+ *==============================================================*/
+
+class CTrie {
+
+public:
+   enum { NONE=0, ROOT=1 };
+
+protected:
+   struct CEdge {
+      unsigned parent;                 // NONE for empty slots
+      unsigned child;
+      unsigned char byte;
+   };
+
+protected:
+   std::vector<CEdge> m_edges;
+   unsigned long m_nMask;
+   unsigned long m_nEdges;
+   std::vector<unsigned long> m_values;  // the value of NONE is the default
+
+protected:
+   static unsigned long bucket(const unsigned &parent, const unsigned char &byte, const unsigned long &mask) {
+      return ((((static_cast<uint64_t>(parent)<<8)|byte) * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+   }
+   void link(const unsigned &parent, const unsigned char &byte, const unsigned &child) {
+      unsigned long slot = bucket(parent, byte, m_nMask);
+      while (m_edges[slot].parent != NONE)
+         slot = (slot+1) & m_nMask;
+      m_edges[slot].parent = parent;
+      m_edges[slot].child = child;
+      m_edges[slot].byte = byte;
+   }
+   // rebuilds the table with twice the slots
+   void grow() {
+      std::vector<CEdge> edges;
+      edges.swap(m_edges);
+      const CEdge empty = { NONE, NONE, 0 };
+      m_edges.assign(edges.size()*2, empty);
+      m_nMask = m_edges.size()-1;
+      for (unsigned long slot=0; slot<edges.size(); ++slot)
+         if (edges[slot].parent != NONE)
+            link(edges[slot].parent, edges[slot].byte, edges[slot].child);
+   }
+
+public:
+   CTrie(const unsigned long &nDefault) : m_nMask(255), m_nEdges(0), m_values(ROOT+1, nDefault) {
+      const CEdge empty = { NONE, NONE, 0 };
+      m_edges.assign(m_nMask+1, empty);
+   }
+   virtual ~CTrie() { }
+
+public:
+   // the node after reading byte from node
+   unsigned child(const unsigned &node, const unsigned char &byte) const {
+      if (node == NONE)
+         return NONE;
+      unsigned long slot = bucket(node, byte, m_nMask);
+      while (m_edges[slot].parent != NONE) {
+         if (m_edges[slot].parent == node && m_edges[slot].byte == byte)
+            return m_edges[slot].child;
+         slot = (slot+1) & m_nMask;
+      }
+      return NONE;
+   }
+   // the node after reading all the bytes of s from node
+   unsigned child(unsigned node, const std::string &s) const {
+      for (std::string::const_iterator it=s.begin(); it!=s.end() && node!=NONE; ++it)
+         node = child(node, static_cast<unsigned char>(*it));
+      return node;
+   }
+   // the value of the key read up to node, the default if the key is not in the trie
+   const unsigned long &value(const unsigned &node) const { return m_values[node]; }
+
+   void insert(const std::string &key, const unsigned long &value) {
+      unsigned node = ROOT;
+      for (std::string::const_iterator it=key.begin(); it!=key.end(); ++it) {
+         const unsigned char byte = static_cast<unsigned char>(*it);
+         unsigned next = child(node, byte);
+         if (next == NONE) {
+            next = m_values.size();
+            assert(next != NONE); // there is no overflow on the number of nodes!
+            m_values.push_back(m_values[NONE]);
+            if ((m_nEdges+1)*2 > m_edges.size())
+               grow();
+            link(node, byte, next);
+            ++m_nEdges;
+         }
+         node = next;
+      }
+      m_values[node] = value;
+   }
+
+   // the number of nodes, including ROOT
+   unsigned long size() const { return m_values.size()-1; }
+};
+
+#endif
@@ -11,6 +11,8 @@
 #ifndef _TUPLE2_H
 #define _TUPLE2_H
 
+#include "fingerprint.h"
+
 /*===============================================================
  *
  * Tuple2
@@ -116,6 +118,12 @@ protected:
 
 //===============================================================
 
+template<class CClass1, class CClass2>
+inline uint64_t fingerprint(const CTuple2<CClass1, CClass2> &w, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(fingerprint(*w.first(), dictionary), fingerprint(*w.second(), dictionary));
+}
+
+//===============================================================
 
 template <class CClass1, class CClass2>
 std::istream & operator >> (std::istream &is, CTuple2<CClass1, CClass2> &tuple2) {
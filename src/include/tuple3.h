@@ -11,6 +11,8 @@
 #ifndef _TUPLE3_H
 #define _TUPLE3_H
 
+#include "fingerprint.h"
+
 /*===============================================================
  *
  * Tuple3
@@ -129,6 +131,11 @@ protected:
 //template<class CClass1, class CClass2, class CClass3>
 //inline unsigned long int hash(const CTuple3<CClass1, CClass2, CClass3> &w) { return w.hash(); }
 
+template<class CClass1, class CClass2, class CClass3>
+inline uint64_t fingerprint(const CTuple3<CClass1, CClass2, CClass3> &w, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(combineFingerprint(fingerprint(*w.first(), dictionary), fingerprint(*w.second(), dictionary)), fingerprint(*w.third(), dictionary));
+}
+
 //===============================================================
 
 template <class CClass1, class CClass2, class CClass3>
@@ -11,6 +11,8 @@
 #ifndef _TUPLE4_H
 #define _TUPLE4_H
 
+#include "fingerprint.h"
+
 /*===============================================================
  *
  * Tuple4
@@ -142,6 +144,11 @@ protected:
 //template<class CClass1, class CClass2, class CClass3, class CClass4>
 //inline unsigned long int hash(const CTuple4<CClass1, CClass2, CClass3, CClass4> &w) { return w.hash(); }
 
+template<class CClass1, class CClass2, class CClass3, class CClass4>
+inline uint64_t fingerprint(const CTuple4<CClass1, CClass2, CClass3, CClass4> &w, const CFingerprintDictionary &dictionary) {
+   return combineFingerprint(combineFingerprint(combineFingerprint(fingerprint(*w.first(), dictionary), fingerprint(*w.second(), dictionary)), fingerprint(*w.third(), dictionary)), fingerprint(*w.fourth(), dictionary));
+}
+
 //===============================================================
 
 template <class CClass1, class CClass2, class CClass3, class CClass4>
@@ -0,0 +1,79 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *                                                              *
+ * window.h - a window of sentences decoded by length.          *
+ *                                                              *
+ * The driver reads ahead a window of sentences, decodes them   *
+ * from the longest to the shortest, so that the decoder sizes  *
+ * its states once for the window and sentences of one length  *
+ * are decoded together, and writes them in input order.       *
+ * The sentence type needs only size(), the number of words.    *
+ *                                                              *
+ ****************************************************************/
+
+#ifndef _WINDOW_H
+#define _WINDOW_H
+
+/*===============================================================
+ *
+ * CWindow - a bounded window of sentences
+ *
+ *==============================================================*/
+
+template<typename CSentence>
+class CWindow {
+
+protected:
+   // the longer sentence first, and the one read first for a tie
+   struct CLonger {
+      const std::vector<CSentence> *sentences;
+      CLonger(const std::vector<CSentence> *s) : sentences(s) { }
+      bool operator () (const unsigned &i, const unsigned &j) const {
+         const unsigned long si = (*sentences)[i].size();
+         const unsigned long sj = (*sentences)[j].size();
+         return si > sj || (si == sj && i < j);
+      }
+   };
+
+protected:
+   std::vector<CSentence> m_lSentences;
+   std::vector<unsigned> m_lOrder;
+   unsigned m_nSize;
+
+public:
+   CWindow(const unsigned &nCapacity) : m_lSentences(nCapacity), m_nSize(0) {
+      ASSERT(nCapacity > 0, "The window must hold at least one sentence");
+   }
+
+private:
+   CWindow(const CWindow &);
+   CWindow &operator = (const CWindow &);
+
+public:
+   void clear() { m_nSize = 0; m_lOrder.clear(); }
+   bool full() const { return m_nSize == m_lSentences.size(); }
+   bool empty() const { return m_nSize == 0; }
+   const unsigned &size() const { return m_nSize; }
+
+   // the slot for the next sentence, which is dropped by pop
+   // if it can not be read
+   CSentence &push() { ASSERT(!full(), "The window is full"); return m_lSentences[m_nSize++]; }
+   void pop() { ASSERT(!empty(), "The window is empty"); --m_nSize; }
+
+   // the sentences in input order
+   CSentence &operator [] (const unsigned &index) { return m_lSentences[index]; }
+   const CSentence &operator [] (const unsigned &index) const { return m_lSentences[index]; }
+
+   // the input index of the sentence to decode the k-th, and the
+   // number of words in the longest sentence
+   void sort() {
+      m_lOrder.resize(m_nSize);
+      for (unsigned index=0; index<m_nSize; ++index)
+         m_lOrder[index] = index;
+      std::sort(m_lOrder.begin(), m_lOrder.end(), CLonger(&m_lSentences));
+   }
+   const unsigned &order(const unsigned &k) const { return m_lOrder[k]; }
+   unsigned long longest() const { return m_nSize == 0 ? 0 : m_lSentences[m_lOrder[0]].size(); }
+};
+
+#endif
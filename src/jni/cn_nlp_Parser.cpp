@@ -1,125 +1,189 @@
+/****************************************************************
+ *                                                              *
+ * cn_nlp_Parser.cpp - the java bindings of the parser.         *
+ *                                                              *
+ * A model is loaded once for the process, and each call parses *
+ * with a decoder from a pool of decoders that share its        *
+ * weights, so that the bindings can be called from any number  *
+ * of java threads at once. A binary model is mapped read only  *
+ * and shared, so the processes that load the same binary model *
+ * use one copy of it in memory. A model named shm:NAME is the  *
+ * posix shared memory object NAME, which is how a model that   *
+ * has been copied into shared memory is attached.              *
+ *                                                              *
+ ****************************************************************/
+
 #include "cn_nlp_Parser.h"
 #include "definitions.h"
 #include "depparser.h"
 #include "reader.h"
 #include "writer.h"
+#include "thread.h"
 #include "stdlib.h"
 
 using namespace TARGET_LANGUAGE;
 const unsigned long nMaxSentSize=512;
 const char separator_p='_';
 
-CDepParser *parser;
+// the model, whose weights the decoders share
+CDepParser *parser = 0;
+
+// the decoders that are not parsing
+std::vector<CDepParser*> free_decoders;
+CMutex decoders_mutex;
+
+CDepParser *acquireDecoder() {
+   CScopedLock lock(decoders_mutex);
+   ASSERT(parser, "The parser has not been initialised");
+   if (free_decoders.empty())
+      return new CDepParser(*parser, false);
+   CDepParser *decoder = free_decoders.back();
+   free_decoders.pop_back();
+   return decoder;
+}
+
+void releaseDecoder(CDepParser *decoder) {
+   CScopedLock lock(decoders_mutex);
+   free_decoders.push_back(decoder);
+}
+
+// a decoder from the pool, which goes back to the pool at the end of
+// the scope, however the call ends
+class CPooledDecoder {
+protected:
+   CDepParser *m_decoder;
+public:
+   CPooledDecoder() : m_decoder(acquireDecoder()) { }
+   ~CPooledDecoder() { releaseDecoder(m_decoder); }
+   CDepParser *get() const { return m_decoder; }
+private:
+   CPooledDecoder(const CPooledDecoder &);
+   CPooledDecoder &operator=(const CPooledDecoder &);
+};
+
+// raises an IllegalStateException in java if there is no model, since
+// nothing can be parsed before init has succeeded
+bool checkInitialised(JNIEnv *env) {
+   bool bInitialised;
+   {
+      CScopedLock lock(decoders_mutex);
+      bInitialised = parser != 0;
+   }
+   if (!bInitialised)
+      env->ThrowNew(env->FindClass("java/lang/IllegalStateException"), "The parser has not been initialised");
+   return bInitialised;
+}
+
+// the path of a model, with shm:NAME for a posix shared memory object
+std::string modelPath(const std::string &sModel) {
+   static const std::string shm("shm:");
+   if (sModel.compare(0, shm.size(), shm) == 0)
+      return "/dev/shm/" + sModel.substr(shm.size());
+   return sModel;
+}
+
+// reads words with their tags, separated by spaces, where the tag of
+// a word follows the last separator
 void string2CStringVector(const char *str,CTwoStringVector *vReturn,bool bIgnoreSpace)
 {
    vReturn->clear();
-   char cTemp;
-   //char separator_c=separator[0];
-   std::string sWord;
-   std::string sTag;
-   bool bCurrentTag=false;
-   // did we read anything?
-   for(int i=0;i<strlen(str);i++) {
-        cTemp=str[i];
-
-      if (cTemp == ' ') {                       // otherwise, if we meet " "
-         if (!sWord.empty() || !sTag.empty()) { // we have found another word
-            if (sTag.empty()) {
-               REPORT("Input file line " << str << ": not well formatted tag for" << sWord);
-               vReturn->clear();
-               return;
-            }
-            vReturn->push_back(std::make_pair(sWord, sTag));
-            sWord = "";
-            sTag = "";
-            bCurrentTag = false;
+   const char *word = str;
+   const char *end = str + strlen(str);
+   while (word < end) {
+      const char *next = std::find(word, end, ' ');
+      const char *sep = next;
+      while (sep != word && *--sep != separator_p) ;
+      // a lone separator is no word
+      if (next != word && (next-word > 1 || *word != separator_p)) {
+         if (*sep != separator_p || sep+1 == next) {
+            REPORT("Input file line " << str << ": not well formatted tag for" << std::string(word, next));
+            vReturn->clear();
+            return;
          }
+         vReturn->push_back(std::make_pair(std::string(word, sep), std::string(sep+1, next)));
       }
-//      else if ( cTemp == separator && sWord[sWord.size()-1] != '\\') { // otherwise, if we meet the separator char
-      else if ( cTemp == separator_p ) { // otherwise, if we meet the separator char
-         if (!bCurrentTag) { // current word
-            bCurrentTag = true;
-         }
-         else { // already currently processing tag
-            sWord += separator_p;
-            sWord += sTag;
-            sTag = "";
-         }
-      }
-      else                                      // otherwise
-         if (bCurrentTag)
-            sTag += cTemp;
-         else
-            sWord += cTemp;
-    }
-    if (!sWord.empty() || !sTag.empty()) {        // we have found another word
-      if (sTag.empty()) {
-         REPORT("Input file line " << str << ": not well formatted tag for" << sWord);
-         vReturn->clear();
-         return;
-      }
-
-      vReturn->push_back(std::make_pair(sWord, sTag));
-      sWord = "";
-      sTag="";
+      word = next+1;
    }
 }
-std::string CDependencyParse2string(const CDependencyParse sentence, std::string delimit) {
-   //std::string str_sen="";
-   std::string charArrSen;
-   int nCharIndex=0;
+
+std::string CDependencyParse2string(const CDependencyParse &sentence, const std::string &delimit) {
+   std::ostringstream os;
    for (int i=0; i<sentence.size(); ++i) {
-      charArrSen.append(sentence.at(i).word);
-      charArrSen.append(delimit);
-      charArrSen.append(sentence.at(i).tag);
-      charArrSen.append(delimit);
-
-      char *str=new char[10];
-      sprintf(str,"%d",sentence.at(i).head);
-
-      charArrSen.append(str);
-      delete[]str;
-      charArrSen.append(delimit);
-      charArrSen.append(sentence.at(i).label);
-      charArrSen.append("\n");
+      os << sentence.at(i).word << delimit << sentence.at(i).tag << delimit
+         << sentence.at(i).head << delimit << sentence.at(i).label << '\n';
    }
-   return charArrSen;
+   return os.str();
+}
+
+// parses one sentence with the given decoder
+std::string parseString(CDepParser *decoder, const char *str) {
+   CTwoStringVector input_sent;
+   CDependencyParse output_sent;
+   string2CStringVector(str,&input_sent,false);
+   if ( input_sent.size() >= depparser::MAX_SENTENCE_SIZE )
+      std::cerr << "The size of the sentence is larger than the limit (" << depparser::MAX_SENTENCE_SIZE << "), skipping." << std::endl;
+   else
+      decoder->parse( input_sent , &output_sent , 1 , 0 ) ;
+   return CDependencyParse2string(output_sent,"\t");
 }
 
 JNIEXPORT jstring JNICALL Java_cn_nlp_Parser_parseSentence
   (JNIEnv *env, jobject obj, jstring sSen)
   {
-      bool bSegmented=false;
-      bool bScores=false;
-      unsigned long nBest=1;
-      CTwoStringVector input_sent;
-       CDependencyParse *output_sent = new CDependencyParse[nBest];
-       depparser::SCORE_TYPE *scores=0;
-
-
-       const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
-
-        string2CStringVector(strMsgPtr,&input_sent,false);
-        env->ReleaseStringUTFChars( sSen, strMsgPtr);
-
+      if (!checkInitialised(env))
+         return 0;
+      const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
+      std::string str_output_sen;
+      try {
+         CPooledDecoder decoder;
+         str_output_sen = parseString(decoder.get(), strMsgPtr);
+      } catch(const std::string &e) {
+         std::cerr << "Error: " << e << std::endl;
+      }
+      env->ReleaseStringUTFChars( sSen, strMsgPtr);
+      return env->NewStringUTF(str_output_sen.c_str());
+  }
 
-      if ( input_sent.size() >= depparser::MAX_SENTENCE_SIZE ) {
-            std::cerr << "The size of the sentence is larger than the limit (" << depparser::MAX_SENTENCE_SIZE << "), skipping." << std::endl;
-            for (int i=0; i<nBest; ++i) {
-               output_sent[i].clear();
+/*
+ * Class:     cn_nlp_Parser
+ * Method:    parseSentences
+ * Signature: ([Ljava/lang/String;)[Ljava/lang/String;
+ *
+ * Parses a batch of sentences with one decoder in one call.
+ */
+JNIEXPORT jobjectArray JNICALL Java_cn_nlp_Parser_parseSentences
+  (JNIEnv *env, jobject obj, jobjectArray sSens)
+  {
+      if (!checkInitialised(env))
+         return 0;
+      const jsize nSentences = env->GetArrayLength(sSens);
+      jobjectArray retval = env->NewObjectArray(nSentences, env->FindClass("java/lang/String"), 0);
+      if (retval == 0)
+         return 0; // OutOfMemoryError is pending
+      try {
+         CPooledDecoder decoder;
+         for (jsize i=0; i<nSentences; ++i) {
+            jstring sSen = static_cast<jstring>(env->GetObjectArrayElement(sSens, i));
+            std::string str_output_sen;
+            if (sSen) {
+               const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
+               try {
+                  str_output_sen = parseString(decoder.get(), strMsgPtr);
+               } catch(const std::string &e) {
+                  std::cerr << "Error: " << e << std::endl;
+               }
+               env->ReleaseStringUTFChars( sSen, strMsgPtr);
+               env->DeleteLocalRef(sSen);
             }
+            // the local references of a large batch are released as it goes
+            jstring sOutput = env->NewStringUTF(str_output_sen.c_str());
+            env->SetObjectArrayElement(retval, i, sOutput);
+            env->DeleteLocalRef(sOutput);
          }
-         else
-         {
-             parser->parse( input_sent , output_sent , nBest , scores ) ;
-         }
-        std::string str_output_sen=CDependencyParse2string(output_sent[0],"\t");
-        for (int i=0; i<nBest; ++i) {
-               output_sent[i].clear();
-        }
-        delete [] output_sent;
-        delete[]scores;
-      return env->NewStringUTF(str_output_sen.c_str());
+      } catch(const std::string &e) {
+         std::cerr << "Error: " << e << std::endl;
+      }
+      return retval;
   }
 
 /*
@@ -131,10 +195,25 @@ JNIEXPORT jint JNICALL Java_cn_nlp_Parser_init
   (JNIEnv *env, jobject obj, jstring sModelFile)
   {
       const char *strMsgPtr = env->GetStringUTFChars( sModelFile , 0);
-      std::string sFeatureDBPath=strMsgPtr;
-      std::cerr<<"sFeatureDBPath="<<sFeatureDBPath<<std::endl;
-      parser=new CDepParser(sFeatureDBPath, false, false);
+      std::string sFeatureDBPath=modelPath(strMsgPtr);
       env->ReleaseStringUTFChars( sModelFile, strMsgPtr);
+      CScopedLock lock(decoders_mutex);
+      // the decoders of other threads may be using the loaded model
+      if (parser) {
+         std::cerr<<"The parser has already been initialised, ignoring "<<sFeatureDBPath<<std::endl;
+         return 1;
+      }
+      std::cerr<<"sFeatureDBPath="<<sFeatureDBPath<<std::endl;
+      try {
+         parser=new CDepParser(sFeatureDBPath, false, false);
+      } catch(const std::string &e) {
+         std::cerr << "Error: " << e << std::endl;
+         return 0;
+      }
+      // the words of the model are all known now, and the words that
+      // are not are unknown, so that the dictionary of a long running
+      // java process does not grow and parsing takes no lock for them
+      CWord().freezeDictionary();
       return 1;
   }
 
@@ -162,142 +241,151 @@ JNIEXPORT jint JNICALL Java_cn_nlp_Parser_parseFile
       env->ReleaseStringUTFChars( sInputFile, strMsgPtr);
       env->ReleaseStringUTFChars( sOutputFile, strMsgPtrO);
 
-      CSentenceReader *input_reader;
-   std::ifstream *is;
-   std::ofstream os(sOutputFile_.c_str());
-   std::ofstream *os_scores=0;
-   depparser::SCORE_TYPE *scores=0;
-   assert(os.is_open());
+      if (!checkInitialised(env))
+         return 0;
+      try {
+         CPooledDecoder pooled;
+         CDepParser *decoder = pooled.get();
+         CSentenceReader *input_reader;
+         std::ifstream *is;
+         std::ofstream os(sOutputFile_.c_str());
+         std::ofstream *os_scores=0;
+         depparser::SCORE_TYPE *scores=0;
+         ASSERT(os.is_open(), "Cannot open the output file " << sOutputFile_);
 #ifdef JOINT_MORPH
-   CStringVector input_sent;
+         CStringVector input_sent;
 #else
-   CTwoStringVector input_sent;
+         CTwoStringVector input_sent;
 #endif
-   CCoNLLInput input_conll;
-   CDependencyParse *output_sent;
-   CCoNLLOutput *output_conll;
-   depparser::CSuperTag *supertags;
-   std::ifstream *is_supertags = 0;
-
-   supertags = 0;
-   bool bCoNLL=false;
-//   if (!sSuperPath.empty()) {
-//      supertags = new depparser::CSuperTag();
-//      is_supertags = new std::ifstream(sSuperPath.c_str());
-//      parser.setSuperTags(supertags);
-//   }
-
-   is = 0;
-   input_reader = 0;
-   if (bCoNLL)
-      is = new std::ifstream(sInputFile_.c_str());
-   else
-      input_reader = new CSentenceReader(sInputFile_);
+         CCoNLLInput input_conll;
+         CDependencyParse *output_sent;
+         CCoNLLOutput *output_conll;
+         depparser::CSuperTag *supertags;
+         std::ifstream *is_supertags = 0;
+
+         supertags = 0;
+         bool bCoNLL=false;
+         // if (!sSuperPath.empty()) {
+         //    supertags = new depparser::CSuperTag();
+         //    is_supertags = new std::ifstream(sSuperPath.c_str());
+         //    parser.setSuperTags(supertags);
+         // }
+
+         is = 0;
+         input_reader = 0;
+         if (bCoNLL)
+            is = new std::ifstream(sInputFile_.c_str());
+         else
+            input_reader = new CSentenceReader(sInputFile_);
 
-   int nCount=0;
-   bool bReadSuccessful;
+         int nCount=0;
+         bool bReadSuccessful;
 
-   if (bScores) {
-      scores = new depparser::SCORE_TYPE[nBest];
-      os_scores = new std::ofstream(std::string(sOutputFile_+".scores").c_str());
-   }
+         if (bScores) {
+            scores = new depparser::SCORE_TYPE[nBest];
+            os_scores = new std::ofstream(std::string(sOutputFile_+".scores").c_str());
+         }
 
-   output_conll = 0;
-   output_sent = 0;
-   if (bCoNLL)
-      output_conll = new CCoNLLOutput[nBest];
-   else
-      output_sent = new CDependencyParse[nBest];
+         output_conll = 0;
+         output_sent = 0;
+         if (bCoNLL)
+            output_conll = new CCoNLLOutput[nBest];
+         else
+            output_sent = new CDependencyParse[nBest];
 
-   // Read the next example
-   if (bCoNLL)
-      bReadSuccessful = ( (*is) >> input_conll );
-   else
+         // Read the next example
+         if (bCoNLL)
+            bReadSuccessful = ( (*is) >> input_conll );
+         else
 #ifdef JOINT_MORPH
-	  bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
+            bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
 #else
-      bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
+            bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
 #endif
-   while( bReadSuccessful ) {
-      if(nCount%100==0)
-        std::cerr<<"Sentence " << nCount<<std::endl;
-      TRACE("Sentence " << nCount);
-      ++ nCount;
-
-      // check size
-      if ( (bCoNLL && input_conll.size() > depparser::MAX_SENTENCE_SIZE) ||
-           (!bCoNLL && input_sent.size() > depparser::MAX_SENTENCE_SIZE) ) {
-         WARNING("The sentence is longer than system limitation, skipping it.");
-         for (unsigned i=0; i<nBest; ++i) {
-            if (bCoNLL)
-               output_conll[i].clear();
-            else
-               output_sent[i].clear();
-            if (bScores) scores[i]=0;
-         }
-      }
-      else {
+         while( bReadSuccessful ) {
+            if(nCount%100==0)
+              std::cerr<<"Sentence " << nCount<<std::endl;
+            TRACE("Sentence " << nCount);
+            ++ nCount;
+
+            // check size
+            if ( (bCoNLL && input_conll.size() > depparser::MAX_SENTENCE_SIZE) ||
+                 (!bCoNLL && input_sent.size() > depparser::MAX_SENTENCE_SIZE) ) {
+               WARNING("The sentence is longer than system limitation, skipping it.");
+               for (unsigned i=0; i<nBest; ++i) {
+                  if (bCoNLL)
+                     output_conll[i].clear();
+                  else
+                     output_sent[i].clear();
+                  if (bScores) scores[i]=0;
+               }
+            }
+            else {
+
+               // Find decoder output
+               if (supertags) {
+                  if (bCoNLL)
+                     supertags->setSentenceSize( input_conll.size() );
+                  else
+                     supertags->setSentenceSize( input_sent.size() );
+                  (*is_supertags) >> *supertags;
+               }
+
+               if (bCoNLL)
+                  decoder->parse_conll( input_conll , output_conll , nBest , scores );
+               else
+                  decoder->parse( input_sent , output_sent , nBest , scores ) ;
 
-         // Find decoder output
-         if (supertags) {
+            }
+
+            // Ouptut sent
+            for (unsigned i=0; i<nBest; ++i) {
+               if (bCoNLL)
+                  os << output_conll[i];
+               else
+                  os << output_sent[i] ;
+               if (bScores) *os_scores << scores[i] << std::endl;
+            }
+
+            // Read the next example
             if (bCoNLL)
-               supertags->setSentenceSize( input_conll.size() );
+               bReadSuccessful = ( (*is) >> input_conll );
             else
-               supertags->setSentenceSize( input_sent.size() );
-            (*is_supertags) >> *supertags;
+#ifdef JOINT_MORPH
+            bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
+#else
+            bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
+#endif
          }
 
          if (bCoNLL)
-            parser->parse_conll( input_conll , output_conll , nBest , scores );
+            delete [] output_conll;
          else
-            parser->parse( input_sent , output_sent , nBest , scores ) ;
+            delete [] output_sent ;
+         os.close();
 
-      }
+         if (bScores) {
+            os_scores->close();
+            delete os_scores;
+            delete []scores;
+         }
 
-      // Ouptut sent
-      for (unsigned i=0; i<nBest; ++i) {
          if (bCoNLL)
-            os << output_conll[i];
+            delete is;
          else
-            os << output_sent[i] ;
-         if (bScores) *os_scores << scores[i] << std::endl;
-      }
-
-      // Read the next example
-      if (bCoNLL)
-         bReadSuccessful = ( (*is) >> input_conll );
-      else
-#ifdef JOINT_MORPH
-	  bReadSuccessful = input_reader->readRawSentence(&input_sent, false, true);
-#else
-      bReadSuccessful = input_reader->readTaggedSentence(&input_sent, false, TAG_SEPARATOR);
-#endif
-   }
+            delete input_reader;
 
-   if (bCoNLL)
-      delete [] output_conll;
-   else
-      delete [] output_sent ;
-   os.close();
-
-   if (bScores) {
-      os_scores->close();
-      delete os_scores;
-      delete []scores;
-   }
-
-   if (bCoNLL)
-      delete is;
-   else
-      delete input_reader;
-
-   if (supertags) {
-      delete supertags;
-      is_supertags->close();
-      delete is_supertags;
-   }
+         if (supertags) {
+            delete supertags;
+            is_supertags->close();
+            delete is_supertags;
+         }
 
-   std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+         std::cerr << "Parsing has finished successfully. Total time taken is: " << double(clock()-time_start)/CLOCKS_PER_SEC << std::endl;
+      } catch(const std::string &e) {
+         std::cerr << "Error: " << e << std::endl;
+         return 0;
+      }
       return 1;
   }
 //int main(int argc, char* argv[]) {
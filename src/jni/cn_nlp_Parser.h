@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT jstring JNICALL Java_cn_nlp_Parser_parseSentence
   (JNIEnv *, jobject, jstring);
 
+/*
+ * Class:     cn_nlp_Parser
+ * Method:    parseSentences
+ * Signature: ([Ljava/lang/String;)[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_cn_nlp_Parser_parseSentences
+  (JNIEnv *, jobject, jobjectArray);
+
 /*
  * Class:     cn_nlp_Parser
  * Method:    init
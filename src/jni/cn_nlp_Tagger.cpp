@@ -1,3 +1,13 @@
+/****************************************************************
+ *                                                              *
+ * cn_nlp_Tagger.cpp - the java bindings of the tagger.         *
+ *                                                              *
+ * The tagger has no decoders that share its weights, so the    *
+ * calls from java threads take turns with it; a batch of       *
+ * sentences is tagged in one call and one turn.                *
+ *                                                              *
+ ****************************************************************/
+
 #include "cn_nlp_Tagger.h"
 #include "tagger.h"
 #include "knowledge/tagdict.h"
@@ -7,6 +17,7 @@
 #include "definitions.h"
 #include "reader.h"
 #include "writer.h"
+#include "thread.h"
 #include "stdlib.h"
 
 using namespace chinese;
@@ -16,6 +27,7 @@ const int nMaxWordLength=20;
 bool shouldUseUserDict=false;
 
 CTagger *taggerObj;
+CMutex tagger_mutex;
 
 CWordDictionary m_Knowledge;
 
@@ -238,44 +250,77 @@ std::string CTwoStringVector2string(const CTwoStringVector *sentence, std::strin
 }
 
 
+// tags one sentence; the caller holds tagger_mutex
+std::string tagString(const char *str) {
+  unsigned long nBest=1;
+  CStringVector input_sent;
+  CTwoStringVector output_sent;
+  CTwoStringVector output_sent_new;
+  tagger::SCORE_TYPE *output_scores = 0;
+
+  string2CStringVector(str,&input_sent,false);
+  if ( input_sent.size() >= tagger::MAX_SENTENCE_SIZE ) {
+    std::cerr << "The size of the sentence is larger than the limit (" << tagger::MAX_SENTENCE_SIZE << "), skipping." << std::endl;
+  }
+  else
+  {
+    taggerObj->tag(&input_sent, &output_sent, output_scores, nBest);
+    changePOS(&output_sent,&output_sent_new);
+  }
+  return CTwoStringVector2string(&output_sent_new,separator);
+}
+
   JNIEXPORT jstring JNICALL Java_cn_nlp_Tagger_tagSentence
 (JNIEnv *env, jobject obj, jstring sSen)
 {
+  const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
+  std::string str_output_sen;
   try {
-    bool bSegmented=false;
-    bool bScores=false;
-    unsigned long nBest=1;
-    CStringVector *input_sent = new CStringVector;
-    CTwoStringVector *output_sent = new CTwoStringVector[nBest];
-    CTwoStringVector *output_sent_new=new CTwoStringVector;
-    tagger::SCORE_TYPE *output_scores;
-
-
-    const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
-    string2CStringVector(strMsgPtr,input_sent,false);
-    env->ReleaseStringUTFChars( sSen, strMsgPtr);
-
+    CScopedLock lock(tagger_mutex);
+    str_output_sen = tagString(strMsgPtr);
+  } catch(
+      const std::string&e) {std::cerr<<"Error: "<<e<<std::endl;
+      str_output_sen = "Error";
+  }
+  env->ReleaseStringUTFChars( sSen, strMsgPtr);
+  return env->NewStringUTF(str_output_sen.c_str());
+}
 
-    if ( input_sent->size() >= tagger::MAX_SENTENCE_SIZE ) {
-      std::cerr << "The size of the sentence is larger than the limit (" << tagger::MAX_SENTENCE_SIZE << "), skipping." << std::endl;
-      for (int i=0; i<nBest; ++i) {
-        output_sent[i].clear();
+/*
+ * Class:     cn_nlp_Tagger
+ * Method:    tagSentences
+ * Signature: ([Ljava/lang/String;)[Ljava/lang/String;
+ *
+ * Tags a batch of sentences in one call.
+ */
+  JNIEXPORT jobjectArray JNICALL Java_cn_nlp_Tagger_tagSentences
+(JNIEnv *env, jobject obj, jobjectArray sSens)
+{
+  const jsize nSentences = env->GetArrayLength(sSens);
+  jobjectArray retval = env->NewObjectArray(nSentences, env->FindClass("java/lang/String"), 0);
+  if (retval == 0)
+    return 0; // OutOfMemoryError is pending
+  CScopedLock lock(tagger_mutex);
+  for (jsize i=0; i<nSentences; ++i) {
+    jstring sSen = static_cast<jstring>(env->GetObjectArrayElement(sSens, i));
+    std::string str_output_sen;
+    if (sSen) {
+      const char *strMsgPtr = env->GetStringUTFChars( sSen , 0);
+      try {
+        str_output_sen = tagString(strMsgPtr);
+      } catch(const std::string&e) {
+        std::cerr<<"Error: "<<e<<std::endl;
+        str_output_sen = "Error";
       }
+      env->ReleaseStringUTFChars( sSen, strMsgPtr);
+      env->DeleteLocalRef(sSen);
     }
-    else
-    {
-      taggerObj->tag(input_sent, output_sent, output_scores, nBest);
-      changePOS(output_sent,output_sent_new);
-    }
-    std::string str_output_sen=CTwoStringVector2string(output_sent_new,separator);
-    delete input_sent;
-    delete output_sent_new;
-    delete [] output_sent;
-    return env->NewStringUTF(str_output_sen.c_str());
-  } catch(
-      const std::string&e) {std::cerr<<"Error: "<<e<<std::endl;
-      return env->NewStringUTF("Error");
+    // the local references of a large batch are released as it goes
+    jstring sOutput = env->NewStringUTF(str_output_sen.c_str());
+    env->SetObjectArrayElement(retval, i, sOutput);
+    env->DeleteLocalRef(sOutput);
   }
+  return retval;
 }
 
 /*
@@ -292,6 +337,7 @@ std::string CTwoStringVector2string(const CTwoStringVector *sentence, std::strin
     std::string sFeatureDBPath=strMsgPtr;
     std::string sKnowledgePath=strMsgDic;
 
+    CScopedLock lock(tagger_mutex);
     loadKnowledge(sKnowledgePath);
     std::cerr<<"sFeatureDBPath="<<sFeatureDBPath<<std::endl;
     taggerObj=new CTagger(sFeatureDBPath,false, nMaxSentSize, true);
@@ -328,6 +374,7 @@ std::string CTwoStringVector2string(const CTwoStringVector *sentence, std::strin
     env->ReleaseStringUTFChars( sOutputFile, strMsgPtrO);
 
     //std::cout<<"sInputFile="<<sInputFile_<<std::endl;
+    CScopedLock lock(tagger_mutex);
 
     CSentenceReader input_reader(sInputFile_);
     CSentenceWriter output_writer(sOutputFile_);
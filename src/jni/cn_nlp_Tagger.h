@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT jstring JNICALL Java_cn_nlp_Tagger_tagSentence
   (JNIEnv *, jobject, jstring);
 
+/*
+ * Class:     cn_nlp_Tagger
+ * Method:    tagSentences
+ * Signature: ([Ljava/lang/String;)[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_cn_nlp_Tagger_tagSentences
+  (JNIEnv *, jobject, jobjectArray);
+
 /*
  * Class:     cn_nlp_Tagger
  * Method:    init
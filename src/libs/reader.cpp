@@ -17,6 +17,68 @@
  *
  *==============================================================*/
 
+/*---------------------------------------------------------------
+ *
+ * readLine - read the next line in place
+ *
+ * The line is given without the newline and carriage returns,
+ * and stays valid until the next line is read.
+ *
+ * The return value shows if anything was read from the file
+ *
+ *--------------------------------------------------------------*/
+
+bool CSentenceReader::readLine(const char *&begin, const char *&end) {
+   if (m_file.is_open()) {
+      const char *file_end = m_file.data() + m_file.size();
+      if (m_pCursor == file_end)
+         return false;
+      begin = m_pCursor;
+      end = static_cast<const char*>(memchr(begin, '\n', file_end-begin));
+      m_bEndOfLine = end != 0;
+      if (end == 0)
+         end = file_end;
+      m_pCursor = m_bEndOfLine ? end+1 : end;
+   }
+   else {
+      if (!std::getline(*m_iStream, m_sLine))
+         return false;
+      m_bEndOfLine = !m_iStream->eof();
+      begin = m_sLine.data();
+      end = begin + m_sLine.size();
+   }
+   if (m_bEndOfLine)
+      m_nLine++;                                // new line
+   if (memchr(begin, '\r', end-begin)) {       // ignore the windows \r
+      std::string sLine;
+      for (const char *p=begin; p!=end; ++p)
+         if (*p != '\r')
+            sLine += *p;
+      m_sLine.swap(sLine);
+      begin = m_sLine.data();
+      end = begin + m_sLine.size();
+   }
+   return true;
+}
+
+/*---------------------------------------------------------------
+ *
+ * nextWord - find the next space separated word of a line
+ *
+ *--------------------------------------------------------------*/
+
+inline bool nextWord(const char *&p, const char *end, const char *&word, const char *&word_end) {
+   while (p != end && *p == ' ')
+      ++p;
+   if (p == end)
+      return false;
+   word = p;
+   while (p != end && *p != ' ')
+      ++p;
+   word_end = p;
+   return true;
+}
+
 /*---------------------------------------------------------------
  *
  * readRawCharacter - read a raw character in utf
@@ -27,7 +89,8 @@ bool CSentenceReader::readRawCharacter(std::string *retval) {
    char cTemp;
    std::string sWord;                                // std::string for next word
    bool bReadSomething = false;                 // did we read anything?
-   while (m_iStream->get(cTemp)) {              // still have something there
+   const char *file_end = m_file.data() + m_file.size();
+   while (m_file.is_open() ? (m_pCursor != file_end && (cTemp = *m_pCursor++, true)) : static_cast<bool>(m_iStream->get(cTemp))) { // still have something there
       bReadSomething = true;
       if (cTemp == '\r')
          continue;
@@ -59,38 +122,21 @@ bool CSentenceReader::readRawCharacter(std::string *retval) {
 bool CSentenceReader::readRawSentence(CStringVector *vReturn, bool bSkipEmptyLines, bool bIgnoreSpace) {
    assert(vReturn != NULL);
    vReturn->clear();
-   char cTemp;
-   std::string sWord;                                // std::string for next word
+   const char *line, *line_end, *word, *word_end;
    bool bReadSomething = false;                 // did we read anything?
-   while (m_iStream->get(cTemp)) {              // still have something there
+   while (readLine(line, line_end)) {           // still have something there
       bReadSomething = true;
-      if (cTemp == '\r')
-         continue;
-      if (cTemp == '\n') {                      // if we meet EOL, return std::string
-         m_nLine++;                             // new line
-         if (!sWord.empty()) {                  // we have found another word
-            getCharactersFromUTF8String(sWord, vReturn);
-         }
-         if (vReturn->empty()) {
-            if (bSkipEmptyLines)
-               continue;
-         }
-         return bReadSomething;
+      if (!bIgnoreSpace) {
+         if (line != line_end)
+            getCharactersFromUTF8String(std::string(line, line_end), vReturn);
       }
-
-      if (bIgnoreSpace && cTemp == ' ') {       // otherwise, if we meet " "
-         if (!sWord.empty()) {                  // we have found another word
-            getCharactersFromUTF8String(sWord, vReturn);
-            sWord = "";
-         }
+      else {
+         while (nextWord(line, line_end, word, word_end))
+            getCharactersFromUTF8String(std::string(word, word_end), vReturn);
       }
-      else                                      // otherwise
-         sWord += cTemp;
-   }
-   if (!sWord.empty()) {                        // we have found another word
-      getCharactersFromUTF8String(sWord, vReturn);
-      sWord = "";
-      TRACE((unsigned long int)(cTemp))
+      if (vReturn->empty() && bSkipEmptyLines)
+         continue;
+      break;
    }
    return bReadSomething;
 };
@@ -110,36 +156,15 @@ bool CSentenceReader::readRawSentence(CStringVector *vReturn, bool bSkipEmptyLin
 bool CSentenceReader::readSegmentedSentence(CStringVector *vReturn, bool bSkipEmptyLines) {
    assert(vReturn != NULL);
    vReturn->clear();
-   char cTemp;
-   std::string sWord;                                // std::string for next word
+   const char *line, *line_end, *word, *word_end;
    bool bReadSomething = false;
-   while (m_iStream->get(cTemp)) {              // still have something there
+   while (readLine(line, line_end)) {           // still have something there
       bReadSomething = true;
-      if (cTemp == '\r')
+      while (nextWord(line, line_end, word, word_end))
+         vReturn->push_back(std::string(word, word_end));
+      if (vReturn->empty() && bSkipEmptyLines)
          continue;
-      if (cTemp == '\n') {                      // if we meet EOL, return std::string
-         m_nLine++;                             // new line
-         if (!sWord.empty()) {                  // we have found another word
-            vReturn->push_back(sWord);
-         }
-         if (vReturn->empty()) {
-            if (bSkipEmptyLines)
-               continue;
-         }
-         return bReadSomething;
-      }
-      if (cTemp == ' ') {                       // otherwise, if we meet " "
-         if (!sWord.empty()) {                  // we have found another word
-            vReturn->push_back(sWord);
-            sWord = "";
-         }
-      }
-      else                                      // otherwise
-         sWord += cTemp;
-   }
-   if (!sWord.empty()) {                        // we have found another word
-      vReturn->push_back(sWord);
-      sWord = "";
+      break;
    }
    return bReadSomething;
 };
@@ -151,6 +176,8 @@ bool CSentenceReader::readSegmentedSentence(CStringVector *vReturn, bool bSkipEm
  * The input file should contain tagged sentences each in a line,
  * with space separated words and punctuations.
  * Each word and its pos tag are divided by a separator char.
+ * The tag follows the last separator, so that the word can
+ * contain the separator.
  *
  * The return value shows if anything was read from the file
  *
@@ -159,69 +186,30 @@ bool CSentenceReader::readSegmentedSentence(CStringVector *vReturn, bool bSkipEm
 bool CSentenceReader::readTaggedSentence(CTwoStringVector *vReturn, bool bSkipEmptyLines, const char separator) {
    assert(vReturn != NULL);
    vReturn->clear();
-   char cTemp;
-   bool bCurrentTag = false;
+   const char *line, *line_end, *word, *word_end, *tag;
    bool bReadSomething = false;
-   std::string sWord;                                // std::string for next word
-   std::string sTag;                                 // std::string for next tag
-   while (m_iStream->get(cTemp)) {              // still have something there
+   while (readLine(line, line_end)) {           // still have something there
       bReadSomething = true;
-      if (cTemp == '\r')                        // ignore the windows \r
-         continue;                              // and continue read in
-      if (cTemp == '\n') {                      // if we meet EOL, return std::string
-         m_nLine++;                             // next line
-         if (!sWord.empty() || !sTag.empty()) { // we have found another word
-            if (sTag.empty()) {
-               REPORT("Input file line " << m_nLine << ": not well formatted tag for" << sWord);
-               vReturn->clear();
-               return bReadSomething;
-            }
-            vReturn->push_back(std::make_pair(sWord, sTag));
-         }
-         if (vReturn->empty()) {
-            if (bSkipEmptyLines)
+      while (nextWord(line, line_end, word, word_end)) {
+         for (tag=word_end; tag!=word && *(tag-1)!=separator; --tag)
+            ;
+         if (tag == word_end) {                 // no tag after the separator
+            if (tag-1 == word && tag != word)   // a separator only
                continue;
+            REPORT("Input file line " << m_nLine << ": not well formatted tag for" << std::string(word, tag-1));
+            vReturn->clear();
+            return bReadSomething;
          }
-         return bReadSomething;
-      }
-      if (cTemp == ' ') {                       // otherwise, if we meet " "
-         if (!sWord.empty() || !sTag.empty()) { // we have found another word
-            if (sTag.empty()) {
-               REPORT("Input file line " << m_nLine << ": not well formatted tag for" << sWord);
-               vReturn->clear();
-               return bReadSomething;
-            }
-            vReturn->push_back(std::make_pair(sWord, sTag));
-            sWord = "";
-            sTag = "";
-            bCurrentTag = false;
-         }
-      }
-//      else if ( cTemp == separator && sWord[sWord.size()-1] != '\\') { // otherwise, if we meet the separator char
-      else if ( cTemp == separator ) { // otherwise, if we meet the separator char
-         if (!bCurrentTag) { // current word
-            bCurrentTag = true;
-         }
-         else { // already currently processing tag
-            sWord += separator;
-            sWord += sTag;
-            sTag = "";
+         if (tag == word) {                     // no separator
+            REPORT("Input file line " << m_nLine << ": not well formatted tag for" << std::string(word, word_end));
+            vReturn->clear();
+            return bReadSomething;
          }
+         vReturn->push_back(std::make_pair(std::string(word, tag-1), std::string(tag, word_end)));
       }
-      else                                      // otherwise
-         if (bCurrentTag)
-            sTag += cTemp;
-         else
-            sWord += cTemp;
-   }
-   if (!sWord.empty() || !sTag.empty()) {        // we have found another word
-      if (sTag.empty()) {
-         REPORT("Input file line " << m_nLine << ": not well formatted tag for" << sWord);
-         vReturn->clear();
-         return bReadSomething;
-      }
-      vReturn->push_back(std::make_pair(sWord, sTag));
-      sWord = "";
+      if (vReturn->empty() && bSkipEmptyLines)
+         continue;
+      break;
    }
    return bReadSomething;
 };
@@ -338,57 +326,47 @@ inline bool tokenizeWord(const std::string &w, CStringVector *v) {
 bool CSentenceReader::readSegmentedSentenceAndTokenize(CStringVector *vReturn, bool bSkipEmptyLines) {
    assert(vReturn != NULL);
    vReturn->clear();
-   char cTemp;
+   const char *line, *line_end, *word, *word_end, *p;
    std::string sWord;                                // std::string for next word
    bool bReadSomething = false;
-   while (m_iStream->get(cTemp)) {              // still have something there
+   while (readLine(line, line_end)) {           // still have something there
       bReadSomething = true;
-      if (cTemp == '\r')
-         continue;
-      else if (cTemp == '\n') {                      // if we meet EOL, return std::string
-         m_nLine++;                             // new line
-         if (!sWord.empty()) {                  // we have found another word
-            if (!tokenizeWord(sWord, vReturn)) { // tokenize word
-               // end of sentence .
-               if (sWord.size() > 1 && sWord[sWord.size()-1] == '.') {
-                  vReturn->push_back(sWord.substr(0, sWord.size()-1));
-                  vReturn->push_back(".");
+      while (nextWord(line, line_end, word, word_end)) {
+         // the colons, commas and semicolons are always words
+         for (p=word; p!=word_end; ++p) {
+            if (*p == ':' || *p == ',' || *p == ';') {
+               if (p != word) {
+                  sWord.assign(word, p);
+                  if (!tokenizeWord(sWord, vReturn))
+                     vReturn->push_back(sWord);
                }
-               else
-                  vReturn->push_back(sWord);
+               vReturn->push_back(std::string(1, *p));
+               word = p+1;
             }
          }
-         if (vReturn->empty()) {
-            if (bSkipEmptyLines)
-               continue;
-         }
-         return bReadSomething;
-      }
-      else if (cTemp == ' ') {                       // otherwise, if we meet " "
-         if (!sWord.empty()) {                  // we have found another word
+         if (word == word_end)
+            continue;
+         sWord.assign(word, word_end);
+         if (word_end != line_end) {
             if (!tokenizeWord(sWord, vReturn))
                vReturn->push_back(sWord);
-            sWord = "";
          }
-      }
-      else if (cTemp == ':' || cTemp == ',' || cTemp == ';' ) {
-         if (!sWord.empty()) {                  // we have found another word
-            if (!tokenizeWord(sWord, vReturn))
+         else if (!m_bEndOfLine) {              // the file ends without a newline
+            vReturn->push_back(sWord);
+         }
+         else if (!tokenizeWord(sWord, vReturn)) { // tokenize word
+            // end of sentence .
+            if (sWord.size() > 1 && sWord[sWord.size()-1] == '.') {
+               vReturn->push_back(sWord.substr(0, sWord.size()-1));
+               vReturn->push_back(".");
+            }
+            else
                vReturn->push_back(sWord);
          }
-         // append ctemp as a string
-         sWord = "";
-         sWord += cTemp;
-         vReturn->push_back(sWord);
-         sWord = "";
       }
-      else                                      // otherwise
-         sWord += cTemp;
-   }
-   if (!sWord.empty()) {                        // we have found another word
-      vReturn->push_back(sWord);
-      sWord = "";
+      if (vReturn->empty() && bSkipEmptyLines)
+         continue;
+      break;
    }
    return bReadSomething;
 };
-
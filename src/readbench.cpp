@@ -0,0 +1,287 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *
+ * readbench.cpp - benchmark the input readers, comparing them
+ *                 with reading a char at a time from a stream
+ *
+ * Usage: readbench file [tagged|segmented|conll]
+ *
+ * The sentence reader is run both on a stream and on the
+ * memory mapped file, and the CoNLL reader on a stream. The
+ * reference readers are the readers before lines were read in
+ * place, and all readers must read the same words.
+ *
+ ****************************************************************/
+
+#include "definitions.h"
+#include "reader.h"
+#include "linguistics/conll.h"
+
+/*---------------------------------------------------------------
+ *
+ * the reference readers
+ *
+ *--------------------------------------------------------------*/
+
+bool referenceSegmented(std::istream &is, CStringVector *vReturn) {
+   vReturn->clear();
+   char cTemp;
+   std::string sWord;
+   bool bReadSomething = false;
+   while (is.get(cTemp)) {
+      bReadSomething = true;
+      if (cTemp == '\r')
+         continue;
+      if (cTemp == '\n') {
+         if (!sWord.empty())
+            vReturn->push_back(sWord);
+         return bReadSomething;
+      }
+      if (cTemp == ' ') {
+         if (!sWord.empty()) {
+            vReturn->push_back(sWord);
+            sWord = "";
+         }
+      }
+      else
+         sWord += cTemp;
+   }
+   if (!sWord.empty())
+      vReturn->push_back(sWord);
+   return bReadSomething;
+}
+
+bool referenceTagged(std::istream &is, CTwoStringVector *vReturn) {
+   vReturn->clear();
+   char cTemp;
+   bool bCurrentTag = false;
+   bool bReadSomething = false;
+   std::string sWord, sTag;
+   while (is.get(cTemp)) {
+      bReadSomething = true;
+      if (cTemp == '\r')
+         continue;
+      if (cTemp == '\n' || cTemp == ' ') {
+         if (!sWord.empty() || !sTag.empty()) {
+            if (sTag.empty()) {
+               vReturn->clear();
+               return bReadSomething;
+            }
+            vReturn->push_back(std::make_pair(sWord, sTag));
+            sWord = "";
+            sTag = "";
+            bCurrentTag = false;
+         }
+         if (cTemp == '\n')
+            return bReadSomething;
+      }
+      else if (cTemp == '_') {
+         if (!bCurrentTag)
+            bCurrentTag = true;
+         else {
+            sWord += '_';
+            sWord += sTag;
+            sTag = "";
+         }
+      }
+      else if (bCurrentTag)
+         sTag += cTemp;
+      else
+         sWord += cTemp;
+   }
+   if (!sWord.empty() || !sTag.empty()) {
+      if (sTag.empty()) {
+         vReturn->clear();
+         return bReadSomething;
+      }
+      vReturn->push_back(std::make_pair(sWord, sTag));
+   }
+   return bReadSomething;
+}
+
+bool referenceCoNLL(std::istream &is, CCoNLLOutput &sent) {
+   sent.clear();
+   std::string line;
+   getline(is, line);
+   while (is && !lstrip(line).empty()) {
+      CCoNLLOutputNode node;
+      std::istringstream iss(rstrip(line));
+      iss >> node;
+      sent.push_back(node);
+      getline(is, line);
+   }
+   return static_cast<bool>(is);
+}
+
+/*---------------------------------------------------------------
+ *
+ * CChecksum - what a reader read
+ *
+ *--------------------------------------------------------------*/
+
+struct CChecksum {
+   unsigned long sentences;
+   unsigned long words;
+   unsigned long chars;
+   unsigned long hash;
+
+   CChecksum() : sentences(0), words(0), chars(0), hash(0) { }
+
+   void add(const std::string &s) {
+      chars += s.size();
+      for (unsigned long i=0; i<s.size(); ++i)
+         hash = hash*31 + static_cast<unsigned char>(s[i]);
+   }
+   void add(const long &n) {
+      hash = hash*31 + n;
+   }
+   bool operator == (const CChecksum &c) const {
+      return sentences == c.sentences && words == c.words && chars == c.chars && hash == c.hash;
+   }
+};
+
+void add(CChecksum &checksum, const CStringVector &sent) {
+   ++checksum.sentences;
+   checksum.words += sent.size();
+   for (unsigned long i=0; i<sent.size(); ++i)
+      checksum.add(sent[i]);
+}
+
+void add(CChecksum &checksum, const CTwoStringVector &sent) {
+   ++checksum.sentences;
+   checksum.words += sent.size();
+   for (unsigned long i=0; i<sent.size(); ++i) {
+      checksum.add(sent[i].first);
+      checksum.add(sent[i].second);
+   }
+}
+
+void add(CChecksum &checksum, const CCoNLLOutput &sent) {
+   ++checksum.sentences;
+   checksum.words += sent.size()-1;
+   for (unsigned long i=1; i<sent.size(); ++i) {
+      checksum.add(sent[i].id);
+      checksum.add(sent[i].word);
+      checksum.add(sent[i].lemma);
+      checksum.add(sent[i].ctag);
+      checksum.add(sent[i].tag);
+      checksum.add(sent[i].feats);
+      checksum.add(sent[i].head);
+      checksum.add(sent[i].label);
+      checksum.add(sent[i].phead);
+      checksum.add(sent[i].plabel);
+   }
+}
+
+/*---------------------------------------------------------------
+ *
+ * report - print the read rate
+ *
+ *--------------------------------------------------------------*/
+
+void report(const std::string &sName, const unsigned long &nBytes, const clock_t &time, const CChecksum &checksum) {
+   const double seconds = double(time)/CLOCKS_PER_SEC;
+   std::cout << sName << ": " << nBytes/(seconds>0?seconds:1e-9)/1048576 << " MB/sec (" << seconds << "s, "
+             << checksum.sentences << " sentences, " << checksum.words << " words)" << std::endl;
+}
+
+/*---------------------------------------------------------------
+ *
+ * bench - the readers of a format
+ *
+ *--------------------------------------------------------------*/
+
+bool readSegmented(CSentenceReader &reader, CStringVector *sent) {
+   return reader.readSegmentedSentence(sent);
+}
+
+bool readTagged(CSentenceReader &reader, CTwoStringVector *sent) {
+   return reader.readTaggedSentence(sent);
+}
+
+template<typename CSentence>
+void bench(const std::string &sFile, const unsigned long &nBytes, bool (*reference)(std::istream&, CSentence*), bool (*read)(CSentenceReader&, CSentence*)) {
+   CSentence sent;
+   CChecksum checksum[3];
+   clock_t start = clock();
+   {
+      std::ifstream is(sFile.c_str());
+      while (reference(is, &sent))
+         add(checksum[0], sent);
+   }
+   report("reference      ", nBytes, clock()-start, checksum[0]);
+
+   start = clock();
+   {
+      std::ifstream is(sFile.c_str());
+      CSentenceReader reader(&is);
+      while (read(reader, &sent))
+         add(checksum[1], sent);
+   }
+   report("reader (stream)", nBytes, clock()-start, checksum[1]);
+
+   start = clock();
+   {
+      CSentenceReader reader(sFile);
+      while (read(reader, &sent))
+         add(checksum[2], sent);
+   }
+   report("reader (mapped)", nBytes, clock()-start, checksum[2]);
+
+   ASSERT(checksum[0]==checksum[1] && checksum[0]==checksum[2], "The readers read different sentences");
+}
+
+void benchCoNLL(const std::string &sFile, const unsigned long &nBytes) {
+   CCoNLLOutput sent;
+   CChecksum checksum[2];
+   clock_t start = clock();
+   {
+      std::ifstream is(sFile.c_str());
+      while (referenceCoNLL(is, sent))
+         add(checksum[0], sent);
+   }
+   report("reference      ", nBytes, clock()-start, checksum[0]);
+
+   start = clock();
+   {
+      std::ifstream is(sFile.c_str());
+      while (is >> sent)
+         add(checksum[1], sent);
+   }
+   report("reader (stream)", nBytes, clock()-start, checksum[1]);
+
+   ASSERT(checksum[0]==checksum[1], "The readers read different sentences");
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char *argv[]) {
+   try {
+      if (argc < 2) {
+         std::cout << "Usage: " << argv[0] << " file [tagged|segmented|conll]" << std::endl;
+         return 1;
+      }
+      const std::string sFile = argv[1];
+      const std::string sFormat = argc > 2 ? argv[2] : "tagged";
+      ASSERT(FileExists(sFile), "File " << sFile << " not found.");
+      std::ifstream file(sFile.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
+      const unsigned long nBytes = file.tellg();
+      std::cout << sFile << ", " << nBytes << " bytes, " << sFormat << std::endl;
+      if (sFormat == "tagged")
+         bench<CTwoStringVector>(sFile, nBytes, referenceTagged, readTagged);
+      else if (sFormat == "segmented")
+         bench<CStringVector>(sFile, nBytes, referenceSegmented, readSegmented);
+      else if (sFormat == "conll")
+         benchCoNLL(sFile, nBytes);
+      else
+         THROW("Unknown format " << sFormat);
+      return 0;
+   } catch (const std::string &e) {
+      std::cerr << "Error: " << e << std::endl;
+      return 1;
+   }
+}
@@ -0,0 +1,133 @@
+// Copyright (C) University of Oxford 2010
+/****************************************************************
+ *
+ * stagestest.cpp - test the stages of stages.h
+ *
+ * Usage: stagestest [items]
+ *
+ * Runs a source in the calling thread, a stage and a sink over
+ * rings of several sizes, with random delays in the stages, and
+ * checks that the items arrive in order, and that a stage that
+ * fails, before or after the others, stops the whole pipeline
+ * and has its error thrown. A pipeline that hangs is killed by
+ * an alarm, which fails the test.
+ *
+ ****************************************************************/
+
+#include <unistd.h>
+
+#include "definitions.h"
+#include "stages.h"
+
+/*---------------------------------------------------------------
+ *
+ * CDouble - the stage, which doubles the items
+ *
+ *--------------------------------------------------------------*/
+
+class CDouble : public CStage<long, long> {
+protected:
+   const long m_nFail;
+public:
+   CDouble(CRing<long> &input, CRing<long> &output, const long &nFail) : CStage<long, long>("double", input, output), m_nFail(nFail) { }
+   void process(long &input, long &output) {
+      if (input == m_nFail)
+         THROW("failed at " << input);
+      if (rand()%7 == 0)
+         usleep(rand()%200);
+      output = input*2;
+   }
+};
+
+/*---------------------------------------------------------------
+ *
+ * CCheck - the sink, which checks the order of the items
+ *
+ *--------------------------------------------------------------*/
+
+class CCheck : public CSink<long> {
+protected:
+   const long m_nFail;
+public:
+   long next;
+   bool ordered;
+public:
+   CCheck(CRing<long> &input, const long &nFail) : CSink<long>("check", input), m_nFail(nFail), next(0), ordered(true) { }
+   void process(long &input) {
+      if (next == m_nFail)
+         THROW("failed at " << next);
+      if (rand()%5 == 0)
+         usleep(rand()%300);
+      if (input != next*2)
+         ordered = false;
+      ++next;
+   }
+};
+
+/*---------------------------------------------------------------
+ *
+ * run - run the pipeline, and return the error of a stage
+ *
+ *--------------------------------------------------------------*/
+
+std::string run(const long &nItems, const unsigned &nRing, const long &nStageFail, const long &nSinkFail) {
+   CRing<long> source(nRing), doubled(nRing);
+   CDouble stage(source, doubled, nStageFail);
+   CCheck sink(doubled, nSinkFail);
+   CStageStats split("source");
+   stage.start();
+   sink.start();
+   long *item;
+   for (long i=0; i<nItems && (item = source.back()) != 0; ++i) {
+      split.startItem();
+      *item = i;
+      split.finishItem();
+      source.push();
+   }
+   source.close();
+   stage.join();
+   sink.join();
+   ASSERT(sink.ordered, "the items are out of order with a ring of " << nRing);
+   std::vector<const CStageStats*> stages;
+   stages.push_back(&split);
+   stages.push_back(&stage);
+   stages.push_back(&sink);
+   std::ostringstream report;
+   try {
+      finishStages(stages, 1.0, report);
+   }
+   catch (const std::string &e) {
+      return e;
+   }
+   ASSERT(sink.next == nItems, sink.next << " of " << nItems << " items arrived with a ring of " << nRing);
+   return "";
+}
+
+/*===============================================================
+ *
+ * main
+ *
+ *==============================================================*/
+
+int main(int argc, char *argv[]) {
+   try {
+      const long nItems = argc > 1 ? atol(argv[1]) : 20000;
+      alarm(60);
+      const unsigned rings[] = { 1, 3, 4, 7, 64 };
+      for (unsigned i=0; i<sizeof(rings)/sizeof(rings[0]); ++i) {
+         ASSERT(run(nItems, rings[i], -1, -1).empty(), "a pipeline without failures failed");
+         ASSERT(run(0, rings[i], -1, -1).empty(), "an empty pipeline failed");
+         // the stage fails, before the sink
+         std::string error = run(nItems, rings[i], nItems/4, -1);
+         ASSERT(error.find("double: failed") == 0, "the failure of the stage was lost with a ring of " << rings[i]);
+         // the sink fails, after the stage, which must stop the source too
+         error = run(nItems, rings[i], -1, 10);
+         ASSERT(error.find("check: failed") == 0, "the failure of the sink was lost with a ring of " << rings[i]);
+         std::cout << "ring " << rings[i] << ": ok" << std::endl;
+      }
+      return 0;
+   } catch (const std::string &e) {
+      std::cerr << "Error: " << e << std::endl;
+      return 1;
+   }
+}